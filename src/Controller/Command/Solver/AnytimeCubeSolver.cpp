@@ -0,0 +1,259 @@
+#include "AnytimeCubeSolver.h"
+
+namespace busybin
+{
+  /**
+   * Init.  The solvers must stay in scope, and they must be initialized
+   * before solving: either by this solver's initialize or separately (not
+   * both).
+   * @param pCube The cube model (may be null when there's no GUI).
+   * @param pThreadPool A ThreadPool pointer for queueing jobs.
+   * @param pKorfSolver The optimal solver.
+   * @param pQuickSolver The solver that gives the first solution (e.g. a
+   * ThistlethwaiteCubeSolver).
+   */
+  AnytimeCubeSolver::AnytimeCubeSolver(RubiksCubeModel* pCube,
+    ThreadPool* pThreadPool, KorfCubeSolver* pKorfSolver,
+    CubeSolver* pQuickSolver) :
+    CubeSolver(pCube, pThreadPool),
+    pKorfSolver(pKorfSolver),
+    pQuickSolver(pQuickSolver),
+    deadlineSeconds(0),
+    numInitializing(0)
+  {
+  }
+
+  /**
+   * Set the deadline used by solveCube and findSolution.
+   * @param deadlineSeconds Seconds from the start of each solve (0, the
+   * default, for none).
+   */
+  void AnytimeCubeSolver::setDeadline(double deadlineSeconds)
+  {
+    this->deadlineSeconds = deadlineSeconds;
+  }
+
+  /**
+   * Initialize both solvers.  onInitialized is called when they're done.
+   */
+  void AnytimeCubeSolver::initialize(std::function<void()> onInitialized)
+  {
+    CubeSolver::initialize(onInitialized);
+
+    auto onSolverInitialized = [this, onInitialized]()
+    {
+      if (--this->numInitializing == 0)
+        onInitialized();
+    };
+
+    this->numInitializing = 2;
+    this->pKorfSolver->initialize(onSolverInitialized);
+    this->pQuickSolver->initialize(onSolverInitialized);
+  }
+
+  /**
+   * Solve the cube, printing each improvement.  This is run in a separate
+   * thread.
+   */
+  void AnytimeCubeSolver::solveCube(RubiksCube& cube)
+  {
+    RubiksCubeIndexModel& iCube = static_cast<RubiksCubeIndexModel&>(cube);
+    SolveGoal             solveGoal;
+    vector<MOVE>          allMoves;
+
+    cout << "Solving with a deadline of " << this->deadlineSeconds << "s." << endl;
+
+    Progress best = this->findSolutionBy(iCube, this->deadlineSeconds,
+      [](const Progress& progress)
+      {
+        cout << "Anytime: " << progress.moves.size() << " moves, at least "
+             << (unsigned)progress.lowerBound << " needed (gap "
+             << progress.getGap() << ") after "
+             << progress.elapsedSeconds << "s." << endl;
+      });
+
+    vector<MOVE> goalMoves = best.moves;
+
+    this->processGoalMoves(solveGoal, cube, 1, allMoves, goalMoves);
+
+    cout << "\n\nSolved the cube in " << allMoves.size() << " moves ("
+         << (best.optimal ? "optimal" : "at most " + std::to_string(best.getGap()) +
+           " more than optimal") << ").\n";
+
+    for (MOVE move : allMoves)
+      cout << cube.getMove(move) << ' ';
+    cout << endl;
+
+    // Done solving - re-enable movement.  (Note that solving is set to true in
+    // the parent class on keypress.)
+    this->setSolving(false);
+  }
+
+  /**
+   * Solve a cube within the deadline set by setDeadline, without printing
+   * anything (see KorfCubeSolver::findSolution).  Setting pHalt ends the
+   * search like the deadline does: the best solution so far is returned,
+   * and the solution is only marked as halted if there isn't one.
+   * @param cube The scrambled cube.
+   * @param pHalt An optional flag that ends the search when set.
+   */
+  CubeSolver::Solution AnytimeCubeSolver::findSolution(
+    const RubiksCubeIndexModel& cube, const atomic_bool* pHalt) const
+  {
+    Progress best = this->findSolutionBy(cube, this->deadlineSeconds,
+      progressCallback_t(), pHalt);
+    Solution solution;
+
+    solution.moves          = best.moves;
+    solution.numNodes       = best.numNodes;
+    solution.elapsedSeconds = best.elapsedSeconds;
+    solution.halted         = best.moves.empty() && !cube.isSolved();
+    solution.lowerBound     = best.lowerBound;
+
+    return solution;
+  }
+
+  /**
+   * Solve a cube by a deadline.  The quick solver's solution is published
+   * first, then the Korf search runs until the deadline, publishing the
+   * lower bound before each IDA* bound.  The search stops early if the lower
+   * bound reaches the quick solution's length (which is then optimal), or if
+   * it finds an optimal solution.  onProgress is called on the calling
+   * thread.  Call after the solvers are initialized.
+   * @param cube The scrambled cube.
+   * @param deadlineSeconds The time limit, in seconds (0 for none).  The
+   * quick solution is always returned, even if it takes longer.
+   * @param onProgress Optional; called with each improvement.
+   * @param pHalt An optional flag that ends the search early when set.
+   * @return The best answer at the deadline.
+   */
+  AnytimeCubeSolver::Progress AnytimeCubeSolver::findSolutionBy(
+    const RubiksCubeIndexModel& cube, double deadlineSeconds,
+    const progressCallback_t& onProgress, const atomic_bool* pHalt) const
+  {
+    typedef std::chrono::steady_clock clock;
+
+    Timer    timer(true);
+    Progress best;
+    Solution quick = this->pQuickSolver->findSolution(cube, pHalt);
+
+    best.moves          = AnytimeCubeSolver::mergeTwists(quick.moves);
+    best.lowerBound     = quick.lowerBound;
+    best.optimal        = best.moves.size() == best.lowerBound;
+    best.numNodes       = quick.numNodes;
+    best.elapsedSeconds = timer.getElapsedSeconds();
+
+    if (quick.halted)
+      return best;
+
+    if (onProgress)
+      onProgress(best);
+
+    if (best.optimal)
+      return best;
+
+    // The search is halted from a watchdog thread at the deadline, or when
+    // pHalt is set.
+    atomic_bool        halt(false);
+    bool               done = false;
+    mutex              doneMutex;
+    condition_variable doneCond;
+    clock::time_point  deadline = clock::now() +
+      std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(deadlineSeconds));
+
+    thread watchdog([&]()
+    {
+      unique_lock<mutex> lock(doneMutex);
+
+      while (!done)
+      {
+        if ((deadlineSeconds > 0 && clock::now() >= deadline) ||
+          (pHalt && *pHalt))
+        {
+          halt = true;
+          return;
+        }
+
+        doneCond.wait_for(lock, std::chrono::milliseconds(10));
+      }
+    });
+
+    Solution optimal = this->pKorfSolver->findOptimalSolution(cube, &halt,
+      [&](uint8_t bound)
+      {
+        best.lowerBound     = bound;
+        best.elapsedSeconds = timer.getElapsedSeconds();
+
+        // No shorter solution exists, so the quick one is optimal.
+        if (bound >= best.moves.size())
+        {
+          best.optimal = true;
+          halt         = true;
+        }
+
+        if (onProgress)
+          onProgress(best);
+      });
+
+    {
+      lock_guard<mutex> lock(doneMutex);
+
+      done = true;
+    }
+
+    doneCond.notify_one();
+    watchdog.join();
+
+    best.numNodes      += optimal.numNodes;
+    best.elapsedSeconds = timer.getElapsedSeconds();
+
+    if (!optimal.halted && !best.optimal)
+    {
+      if (optimal.moves.size() < best.moves.size())
+        best.moves = optimal.moves;
+
+      best.lowerBound = optimal.lowerBound;
+      best.optimal    = true;
+
+      if (onProgress)
+        onProgress(best);
+    }
+
+    return best;
+  }
+
+  /**
+   * Merge consecutive twists of the same face (e.g. R R2 is R', and U U' is
+   * nothing).  The quick solvers join their stages without doing this.
+   * @param moves The face twists.
+   */
+  vector<RubiksCube::MOVE> AnytimeCubeSolver::mergeTwists(
+    const vector<MOVE>& moves)
+  {
+    // Quarter turns per twist by ind % 3 (X, X', X2), and back.
+    const uint8_t quarters[] = {1, 3, 2};
+    const uint8_t twists[]   = {0, 0, 2, 1};
+    vector<MOVE>  merged;
+
+    for (MOVE move : moves)
+    {
+      unsigned face = (unsigned)move / 3;
+
+      if (!merged.empty() && (unsigned)merged.back() / 3 == face)
+      {
+        unsigned turns = (quarters[(unsigned)merged.back() % 3] +
+          quarters[(unsigned)move % 3]) % 4;
+
+        merged.pop_back();
+
+        if (turns != 0)
+          merged.push_back((MOVE)(face * 3 + twists[turns]));
+      }
+      else
+        merged.push_back(move);
+    }
+
+    return merged;
+  }
+}
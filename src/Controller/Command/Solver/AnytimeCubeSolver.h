@@ -0,0 +1,87 @@
+#ifndef _BUSYBIN_ANYTIME_CUBE_SOLVER_H_
+#define _BUSYBIN_ANYTIME_CUBE_SOLVER_H_
+
+#include "CubeSolver.h"
+#include "KorfCubeSolver.h"
+#include "../../Searcher/IDACubeSearcher.h"
+#include "../../../Model/RubiksCubeModel.h"
+#include "../../../Model/RubiksCubeIndexModel.h"
+#include "../../../Util/ThreadPool.h"
+#include "../../../Util/Timer.h"
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <vector>
+using std::vector;
+#include <functional>
+using std::function;
+#include <atomic>
+using std::atomic_bool;
+using std::atomic_uint;
+#include <thread>
+using std::thread;
+#include <mutex>
+using std::mutex;
+using std::unique_lock;
+#include <condition_variable>
+using std::condition_variable;
+#include <chrono>
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * Solver controller for the cube that answers within a deadline.  A quick
+   * (suboptimal) solver gives a solution right away, and the rest of the
+   * time goes to the Korf IDA* search.  Each improvement is published as it
+   * happens: the proven lower bound rises with each IDA* bound, and an
+   * optimal solution replaces the quick one if it's found in time.  At the
+   * deadline the best solution so far is returned, along with how far from
+   * optimal it can be.
+   */
+  class AnytimeCubeSolver : public CubeSolver
+  {
+  public:
+    /**
+     * The best answer so far.  The solution is at most getGap() moves longer
+     * than an optimal one.
+     */
+    struct Progress
+    {
+      vector<MOVE>       moves;
+      uint8_t            lowerBound;
+      bool               optimal;
+      unsigned long long numNodes;
+      double             elapsedSeconds;
+
+      unsigned getGap() const
+      {
+        return this->moves.size() - this->lowerBound;
+      }
+    };
+
+    typedef function<void(const Progress&)> progressCallback_t;
+
+  private:
+    KorfCubeSolver* pKorfSolver;
+    CubeSolver*     pQuickSolver;
+    double          deadlineSeconds;
+    atomic_uint     numInitializing;
+
+    static vector<MOVE> mergeTwists(const vector<MOVE>& moves);
+
+  public:
+    AnytimeCubeSolver(RubiksCubeModel* pCube, ThreadPool* pThreadPool,
+      KorfCubeSolver* pKorfSolver, CubeSolver* pQuickSolver);
+    void setDeadline(double deadlineSeconds);
+    void initialize(std::function<void()> onInitialized);
+    void solveCube(RubiksCube& cube);
+    Solution findSolution(const RubiksCubeIndexModel& cube,
+      const atomic_bool* pHalt = nullptr) const;
+    Progress findSolutionBy(const RubiksCubeIndexModel& cube,
+      double deadlineSeconds, const progressCallback_t& onProgress,
+      const atomic_bool* pHalt = nullptr) const;
+  };
+}
+
+#endif
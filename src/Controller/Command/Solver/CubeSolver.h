@@ -7,6 +7,7 @@
 #include "../../../Model/MoveStore/MoveStore.h"
 #include "../../../Model/Goal/Goal.h"
 #include "../../../Model/RubiksCubeModel.h"
+#include "../../../Model/RubiksCubeIndexModel.h"
 #include <iostream>
 using std::cout;
 using std::endl;
@@ -62,8 +63,25 @@ namespace busybin
       unsigned goalNum, vector<MOVE>& allMoves, vector<MOVE>& goalMoves);
 
   public:
+    /**
+     * The result of solving one cube.
+     */
+    struct Solution
+    {
+      vector<MOVE>       moves;
+      unsigned long long numNodes;
+      double             elapsedSeconds;
+      bool               halted;
+
+      // No solution is shorter than this.  It's the length of an optimal
+      // solution, and 0 when the solver doesn't prove anything.
+      uint8_t            lowerBound;
+    };
+
     atomic_bool solving;
     virtual void solveCube(RubiksCube& cube) = 0;
+    virtual Solution findSolution(const RubiksCubeIndexModel& cube,
+      const atomic_bool* pHalt = nullptr) const = 0;
     CubeSolver(RubiksCubeModel* pCube, ThreadPool* pThreadPool);
     virtual void initialize(std::function<void()> onInitialized);
     vector<string> simplifyMoves(const vector<string>& moves) const;
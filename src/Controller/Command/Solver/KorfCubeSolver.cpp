@@ -8,120 +8,394 @@ namespace busybin
    * @param pWorldWnd The world window, used to bind key and pulse events.
    * @param pMover Pointer to the CubeMover command.
    * @param pThreadPool A ThreadPool pointer for queueing jobs.
+   * @param numSearchThreads The number of threads used by the IDA* search.
+   * When more than one, the search tree is split at splitDepth and the
+   * subtrees are searched in parallel on pThreadPool, which should have at
+   * least this many threads.
+   * @param splitDepth The depth at which the search tree is split.
    */
-  KorfCubeSolver::KorfCubeSolver(RubiksCubeModel* pCube, ThreadPool* pThreadPool) :
+  KorfCubeSolver::KorfCubeSolver(RubiksCubeModel* pCube,
+    ThreadPool* pThreadPool, unsigned numSearchThreads, uint8_t splitDepth) :
     CubeSolver(pCube, pThreadPool),
-    cornerDB(),
-    edgeG1DB(),
-    edgeG2DB(),
+    pCornerDB(new CornerPatternDatabase()),
     edgePermDB(),
-    korfDB(&cornerDB, &edgeG1DB, &edgeG2DB, &edgePermDB),
-    cornerDBIndexed(false),
-    edgeG1DBIndexed(false),
-    edgeG2DBIndexed(false),
-    edgePermDBIndexed(false) 
+    numDBsIndexed(0),
+    numSearchThreads(numSearchThreads),
+    splitDepth(splitDepth),
+    mapDatabases(false),
+    hugePages(false),
+    inPlaceSearch(false),
+    adaptiveOrdering(true),
+    symmetryReduction(false),
+    diskIndexMegabytes(0)
   {
+    this->setEdgePartition({{0, 1, 2, 3, 4, 5, 6}, {5, 6, 7, 8, 9, 10, 11}});
   }
 
   /**
-   * Launch a thread to initialize the pattern databases. 
+   * Choose how the pattern databases are loaded.  By default each database
+   * file is read into memory and inflated to a byte per entry.  When mapped,
+   * the files are memory mapped and searched in their packed form instead:
+   * startup is nearly instant, memory use is cut by about two thirds, and
+   * several solver processes share one copy of the databases through the
+   * page cache.  Call before initialize.
+   * @param mapDatabases Whether to memory map the database files.
+   * @param hugePages Back the databases with huge pages, which cuts down on
+   * TLB misses.  Mappings are only hinted; inflated copies try explicit,
+   * then transparent huge pages, and fall back to the heap (see
+   * HugePageBuffer).  The backing is reported on initialization.
    */
-  void KorfCubeSolver::initialize(std::function<void()> onInitialized)
+  void KorfCubeSolver::setDatabaseMapping(bool mapDatabases, bool hugePages)
   {
-    CubeSolver::initialize(onInitialized);
-    this->onInitialized = onInitialized;
+    this->mapDatabases = mapDatabases;
+    this->hugePages    = hugePages;
+  }
 
-    cout << "Initializing pattern databases for KorfCubeSolver." << endl;
+  /**
+   * Choose how the edges are split among the edge pattern databases.  By
+   * default there are two 7-edge databases, edges 0-6 and 5-11 (~244MB
+   * each).  Larger databases make a much stronger heuristic, so fewer nodes
+   * are expanded per solve, but each edge added multiplies a database's size
+   * by about 10: an 8-edge database is ~2.4GB (~4.8GB inflated, so mapping
+   * is recommended), and a 9-edge database is ~19GB.  Each database is
+   * stored in its own file, named for its edges, and indexed at startup if
+   * the file doesn't exist.  With symmetry reduction, the 8 U and D layer
+   * edges can be one of the sets (see setSymmetryReduction).  Call before
+   * initialize.
+   * @param edgeSets The edges that each database tracks, numbered 0-11 (see
+   * RubiksCube::EDGE).  Each database tracks 6 to 9 edges.
+   */
+  void KorfCubeSolver::setEdgePartition(const vector<vector<uint8_t>>& edgeSets)
+  {
+    vector<PatternDatabase*> databases;
 
-    // Index each pattern database.
-    this->pThreadPool->addJob(bind(&KorfCubeSolver::indexCornerDatabase, this));
-    this->pThreadPool->addJob(bind(&KorfCubeSolver::indexEdgeG1Database, this));
-    this->pThreadPool->addJob(bind(&KorfCubeSolver::indexEdgeG2Database, this));
-    this->pThreadPool->addJob(bind(&KorfCubeSolver::indexEdgePermDatabase, this));
+    // The old databases are freed first, since they can be huge.
+    this->pKorfDB.reset();
+    this->edgeDBs.clear();
+    this->edgeSets = edgeSets;
+
+    databases.push_back(this->pCornerDB.get());
+
+    for (const vector<uint8_t>& edges : edgeSets)
+    {
+      this->edgeDBs.emplace_back(this->createEdgeDatabase(edges));
+      databases.push_back(this->edgeDBs.back().get());
+    }
+
+    // The edge permutation index is the most expensive, so it's last.
+    databases.push_back(&this->edgePermDB);
+
+    this->pKorfDB.reset(new KorfPatternDatabase(databases));
+    this->pKorfDB->setAdaptiveOrdering(this->adaptiveOrdering);
   }
 
   /**
-   * Index the corner database.
+   * Choose whether the symmetry-reduced databases are used.  A scramble and
+   * its mirror images and rotations are the same distance from solved, so
+   * these databases store one entry per class of symmetric scrambles.  The
+   * corner database becomes a CornerSymPatternDatabase (~1MB rather than
+   * ~42MB), and an edge set of the 8 U and D layer edges (0-3 and 8-11)
+   * becomes an EdgeUDSymPatternDatabase (~221MB, less than a 7-edge
+   * database, rather than ~2.4GB for an 8-edge one).  Each lookup conjugates
+   * the scramble to its class, so it costs more than a plain lookup.  The
+   * databases are recreated, with their own files.  Call before initialize.
+   * @param symmetryReduction Whether to use the symmetry-reduced databases.
    */
-  void KorfCubeSolver::indexCornerDatabase()
+  void KorfCubeSolver::setSymmetryReduction(bool symmetryReduction)
   {
-    // The corner pattern database will be created using a breadth-first
-    // search.
-    BreadthFirstCubeSearcher bfsSearcher;
+    this->symmetryReduction = symmetryReduction;
 
-    // An index model is used for building pattern databases.
-    RubiksCubeIndexModel iCube;
+    // The old databases are freed first, since they can be huge.
+    this->pKorfDB.reset();
+    this->pCornerDB.reset();
 
-    this->setSolving(true);
+    if (symmetryReduction)
+      this->pCornerDB.reset(new CornerSymPatternDatabase());
+    else
+      this->pCornerDB.reset(new CornerPatternDatabase());
+
+    this->setEdgePartition(vector<vector<uint8_t>>(this->edgeSets));
+  }
+
+  /**
+   * Check if a set of edges is indexed by the symmetry-reduced U and D edge
+   * database.
+   * @param edges The edges to track.
+   */
+  bool KorfCubeSolver::isEdgeUDSymSet(const vector<uint8_t>& edges) const
+  {
+    return this->symmetryReduction &&
+      edges == vector<uint8_t>({0, 1, 2, 3, 8, 9, 10, 11});
+  }
 
-    // The seacher uses about 5GB of memory; the internal queue is quite large
-    // while indexing the corner database.
-    if (!this->cornerDB.fromFile("../Data/corner.pdb"))
+  /**
+   * Create an edge pattern database for a set of 6 to 9 edges.
+   * @param edges The edges to track.
+   */
+  PatternDatabase* KorfCubeSolver::createEdgeDatabase(
+    const vector<uint8_t>& edges) const
+  {
+    if (this->isEdgeUDSymSet(edges))
+      return new EdgeUDSymPatternDatabase();
+
+    switch (edges.size())
     {
-      // First create the corner database.
-      CornerDatabaseGoal cornerGoal(&this->cornerDB);
-      TwistStore         twistStore(iCube);
+      case 6:
+        return new EdgePatternDatabase<6>(edges);
+      case 7:
+        return new EdgePatternDatabase<7>(edges);
+      case 8:
+        return new EdgePatternDatabase<8>(edges);
+      case 9:
+        return new EdgePatternDatabase<9>(edges);
+      default:
+        throw RubiksCubeException("Edge pattern databases track 6 to 9 edges.");
+    }
+  }
+
+  /**
+   * Get the name of an edge database, which is also its file name.  The
+   * default databases keep their original names: edgeG1 and edgeG2.  Others
+   * are named for their edges, e.g. edge_0-1-2-3-4-5-6-7, and the
+   * symmetry-reduced U and D edge database is edge_ud_sym.
+   * @param edges The edges the database tracks.
+   */
+  string KorfCubeSolver::getEdgeDatabaseName(const vector<uint8_t>& edges) const
+  {
+    if (this->isEdgeUDSymSet(edges))
+      return "edge_ud_sym";
+
+    if (edges == vector<uint8_t>({0, 1, 2, 3, 4, 5, 6}))
+      return "edgeG1";
+
+    if (edges == vector<uint8_t>({5, 6, 7, 8, 9, 10, 11}))
+      return "edgeG2";
+
+    string name = "edge";
+
+    for (uint8_t i = 0; i < edges.size(); ++i)
+      name += (i == 0 ? "_" : "-") + std::to_string((unsigned)edges[i]);
+
+    return name;
+  }
+
+  /**
+   * Choose how the single-threaded IDA* search expands nodes: by copying the
+   * cube for each child (the default), or by moving one cube in place and
+   * undoing the moves (InPlaceIDACubeSearcher).  Which is faster depends on
+   * the hardware; benchmarkSearch measures both.
+   * @param inPlaceSearch Whether to search in place.
+   */
+  void KorfCubeSolver::setInPlaceSearch(bool inPlaceSearch)
+  {
+    this->inPlaceSearch = inPlaceSearch;
+  }
+
+  /**
+   * Choose whether the pattern databases are probed in an order measured
+   * during the search (the default), or in a fixed order: corner, edges,
+   * then edge permutation.  See CompositePatternDatabase.
+   * @param adaptiveOrdering Whether to adapt the probe order.
+   */
+  void KorfCubeSolver::setAdaptiveOrdering(bool adaptiveOrdering)
+  {
+    this->adaptiveOrdering = adaptiveOrdering;
+    this->pKorfDB->setAdaptiveOrdering(adaptiveOrdering);
+  }
+
+  /**
+   * Get the heuristic that the searches use, e.g. to combine more databases
+   * with it.  Extra databases must be indexed or loaded by the caller, and
+   * they're dropped by setEdgePartition.
+   */
+  CompositePatternDatabase& KorfCubeSolver::getHeuristic()
+  {
+    return *this->pKorfDB;
+  }
+
+  /**
+   * Use a transposition table to prune duplicate states in the copy-based
+   * IDA* searches (serial and parallel).  All the searches run by this
+   * solver share the table.  It costs memory and a random access per node,
+   * on top of the database lookups, so whether it pays off depends on the
+   * scramble and the hardware; benchmarkSearch reports both ways, with the
+   * table's statistics.
+   * @param numMegabytes The table size, or 0 for no table (the default).
+   */
+  void KorfCubeSolver::setTranspositionTableSize(size_t numMegabytes)
+  {
+    if (numMegabytes == 0)
+      this->pTable.reset();
+    else
+      this->pTable.reset(new TranspositionTable(numMegabytes));
+  }
 
-      cout << "Goal 1: " << cornerGoal.getDescription() << endl;
+  /**
+   * Print the transposition table's statistics, if there is a table.
+   */
+  void KorfCubeSolver::printTableStats() const
+  {
+    if (!this->pTable)
+      return;
+
+    TranspositionTable::Stats stats = this->pTable->getStats();
+
+    cout << "Transposition table: " << this->pTable->getNumEntries()
+         << " entries, " << stats.probes << " probes, " << stats.hits
+         << " hits (" << (stats.probes ? 100.0 * stats.hits / stats.probes : 0)
+         << "%), " << stats.pruned << " nodes pruned, " << stats.stores
+         << " stores, " << stats.replacements << " replacements." << endl;
+  }
 
-      bfsSearcher.findGoal(cornerGoal, iCube, twistStore);
-      this->cornerDB.toFile("../Data/corner.pdb");
+  /**
+   * Load a database from a file, either reading or mapping it.  Returns false
+   * if the file doesn't exist.
+   */
+  bool KorfCubeSolver::loadDatabase(PatternDatabase& db, const string& filePath)
+  {
+    if (this->mapDatabases)
+      return db.mapFile(filePath, this->hugePages);
+
+    return db.fromFile(filePath);
+  }
+
+  /**
+   * Choose how missing pattern databases are indexed.  By default each one
+   * is indexed in memory, which takes the whole database (an 8-edge database
+   * needs ~2.4GB, a 9-edge one ~19GB).  With disk indexing each database is
+   * built in its file instead, a slice at a time, with a checkpoint after
+   * each slice so that an interrupted build resumes where it left off (see
+   * ExternalPatternDatabaseIndexer).  It's slower, and it needs free disk
+   * for the search frontier, so it's meant for databases that don't fit in
+   * memory; map them once they're built (see setDatabaseMapping).  Call
+   * before initialize.
+   * @param memoryMegabytes The memory budget for building each database, or
+   * 0 to index in memory.
+   */
+  void KorfCubeSolver::setDiskIndexing(size_t memoryMegabytes)
+  {
+    this->diskIndexMegabytes = memoryMegabytes;
+  }
+
+  /**
+   * Index a database and write it to its file.  Databases indexed on disk
+   * are loaded from the file afterward.
+   * @param goal The goal holding the database.
+   * @param iCube A solved cube.
+   * @param moveStore The moves to index with.
+   * @param filePath The database file.
+   */
+  void KorfCubeSolver::buildDatabase(DatabaseGoal& goal,
+    RubiksCubeIndexModel& iCube, MoveStore& moveStore, const string& filePath)
+  {
+    if (this->diskIndexMegabytes != 0)
+    {
+      ExternalPatternDatabaseIndexer indexer(this->pThreadPool, filePath,
+        this->diskIndexMegabytes);
+
+      indexer.findGoal(goal, iCube, moveStore);
+
+      if (!this->loadDatabase(*goal.getDatabase(), filePath))
+        throw RubiksCubeException("Failed to load an indexed database.");
     }
+    else
+    {
+      // The database is indexed in place with a parallel breadth-first
+      // search.
+      ParallelPatternDatabaseIndexer indexer(this->pThreadPool);
 
-    this->cornerDBIndexed = true;
-    this->onIndexComplete();
+      indexer.findGoal(goal, iCube, moveStore);
+      goal.getDatabase()->toFile(filePath);
+    }
   }
 
   /**
-   * Index the first edge database.
+   * Get the path to the corner database's file.
    */
-  void KorfCubeSolver::indexEdgeG1Database()
+  string KorfCubeSolver::getCornerDatabasePath() const
   {
-    // The corner databases are indexed using a specialized IDDFS search.
-    PatternDatabaseIndexer indexer;
-    RubiksCubeIndexModel   iCube;
+    return this->symmetryReduction ? "../Data/corner_sym.pdb" :
+      "../Data/corner.pdb";
+  }
+
+  /**
+   * Launch a thread to initialize the pattern databases. 
+   */
+  void KorfCubeSolver::initialize(std::function<void()> onInitialized)
+  {
+    CubeSolver::initialize(onInitialized);
+    this->onInitialized = onInitialized;
+
+    cout << "Initializing pattern databases for KorfCubeSolver." << endl;
+
+    // Index each pattern database.
+    this->numDBsIndexed = 0;
+
+    this->pThreadPool->addJob(bind(&KorfCubeSolver::indexCornerDatabase, this));
+
+    for (unsigned i = 0; i < this->edgeDBs.size(); ++i)
+      this->pThreadPool->addJob(bind(&KorfCubeSolver::indexEdgeDatabase, this, i));
+
+    this->pThreadPool->addJob(bind(&KorfCubeSolver::indexEdgePermDatabase, this));
+  }
+
+  /**
+   * Index the corner database.
+   */
+  void KorfCubeSolver::indexCornerDatabase()
+  {
+    // An index model is used for building pattern databases.
+    RubiksCubeIndexModel iCube;
 
     this->setSolving(true);
 
-    if (!this->edgeG1DB.fromFile("../Data/edgeG1.pdb"))
+    if (!this->loadDatabase(*this->pCornerDB, this->getCornerDatabasePath()))
     {
-      // Create the first edge database.
-      EdgeDatabaseGoal      edgeG1Goal(&this->edgeG1DB);
-      TwistStore            twistStore(iCube);
+      // First create the corner database.
+      unique_ptr<DatabaseGoal> pCornerGoal(this->symmetryReduction ?
+        (DatabaseGoal*)new CornerSymDatabaseGoal(
+          static_cast<CornerSymPatternDatabase*>(this->pCornerDB.get())) :
+        (DatabaseGoal*)new CornerDatabaseGoal(
+          static_cast<CornerPatternDatabase*>(this->pCornerDB.get())));
+      TwistStore twistStore(iCube);
 
-      cout << "Goal 2: " << edgeG1Goal.getDescription() << endl;
+      cout << "Goal 1: " << pCornerGoal->getDescription() << endl;
 
-      indexer.findGoal(edgeG1Goal, iCube, twistStore);
-      this->edgeG1DB.toFile("../Data/edgeG1.pdb");
+      this->buildDatabase(*pCornerGoal, iCube, twistStore,
+        this->getCornerDatabasePath());
     }
 
-    this->edgeG1DBIndexed = true;
     this->onIndexComplete();
   }
 
   /**
-   * Index the second edge database.
+   * Index one of the edge databases.
+   * @param ind The database's index in edgeDBs.
    */
-  void KorfCubeSolver::indexEdgeG2Database()
+  void KorfCubeSolver::indexEdgeDatabase(unsigned ind)
   {
-    PatternDatabaseIndexer indexer;
-    RubiksCubeIndexModel   iCube;
+    RubiksCubeIndexModel iCube;
+    PatternDatabase&     edgeDB   = *this->edgeDBs[ind];
+    string               filePath = "../Data/" +
+      this->getEdgeDatabaseName(this->edgeSets[ind]) + ".pdb";
 
     this->setSolving(true);
 
-    if (!this->edgeG2DB.fromFile("../Data/edgeG2.pdb"))
+    if (!this->loadDatabase(edgeDB, filePath))
     {
-      // Create the second edge database.
-      EdgeDatabaseGoal      edgeG2Goal(&this->edgeG2DB);
-      TwistStore            twistStore(iCube);
+      // Create the edge database.
+      unique_ptr<DatabaseGoal> pEdgeGoal(this->isEdgeUDSymSet(this->edgeSets[ind]) ?
+        (DatabaseGoal*)new EdgeUDSymDatabaseGoal(
+          static_cast<EdgeUDSymPatternDatabase*>(&edgeDB)) :
+        (DatabaseGoal*)new EdgeDatabaseGoal(&edgeDB,
+          this->edgeSets[ind].size()));
+      TwistStore twistStore(iCube);
 
-      cout << "Goal 3: " << edgeG2Goal.getDescription() << endl;
+      cout << "Goal " << ind + 2 << ": " << pEdgeGoal->getDescription() << endl;
 
-      indexer.findGoal(edgeG2Goal, iCube, twistStore);
-      this->edgeG2DB.toFile("../Data/edgeG2.pdb");
+      this->buildDatabase(*pEdgeGoal, iCube, twistStore, filePath);
     }
 
-    this->edgeG2DBIndexed = true;
     this->onIndexComplete();
   }
 
@@ -130,24 +404,23 @@ namespace busybin
    */
   void KorfCubeSolver::indexEdgePermDatabase()
   {
-    PatternDatabaseIndexer indexer;
-    RubiksCubeIndexModel   iCube;
+    RubiksCubeIndexModel iCube;
 
     this->setSolving(true);
 
-    if (!this->edgePermDB.fromFile("../Data/edge_perm.pdb"))
+    if (!this->loadDatabase(this->edgePermDB, "../Data/edge_perm.pdb"))
     {
       // Create the edge permutation database.
       EdgePermutationDatabaseGoal    edgePermGoal(&this->edgePermDB);
       TwistStore                     twistStore(iCube);
 
-      cout << "Goal 4: " << edgePermGoal.getDescription() << endl;
+      cout << "Goal " << this->edgeDBs.size() + 2 << ": "
+           << edgePermGoal.getDescription() << endl;
 
-      indexer.findGoal(edgePermGoal, iCube, twistStore);
-      this->edgePermDB.toFile("../Data/edge_perm.pdb");
+      this->buildDatabase(edgePermGoal, iCube, twistStore,
+        "../Data/edge_perm.pdb");
     }
 
-    this->edgePermDBIndexed = true;
     this->onIndexComplete();
   }
 
@@ -157,11 +430,15 @@ namespace busybin
    */
   void KorfCubeSolver::onIndexComplete()
   {
-    if (this->cornerDBIndexed && this->edgeG1DBIndexed && this->edgeG2DBIndexed && this->edgePermDBIndexed)
+    if (++this->numDBsIndexed == this->edgeDBs.size() + 2)
     {
       // Inflate the DB for faster access (doubles the size, but no bit-wise
-      // operations are required when indexing).
-      this->korfDB.inflate();
+      // operations are required when indexing).  Mapped databases are
+      // searched in place.
+      if (!this->mapDatabases)
+        this->pKorfDB->inflate(this->pThreadPool, this->hugePages);
+
+      this->printStorageReport();
 
       //this->setSolving(false);
 
@@ -194,11 +471,27 @@ namespace busybin
     */
 
     // Second goal: solve the cube.
-    IDACubeSearcher      idaSearcher(&this->korfDB);
     SolveGoal            solveGoal;
     TwistStore           twistStore(cube);
 
-    goalMoves = idaSearcher.findGoal(solveGoal, cube, twistStore);
+    if (this->numSearchThreads > 1)
+    {
+      ParallelIDACubeSearcher idaSearcher(this->pKorfDB.get(),
+        this->pThreadPool, this->splitDepth);
+
+      idaSearcher.setTranspositionTable(this->pTable.get());
+      goalMoves = idaSearcher.findGoal(solveGoal, cube, twistStore);
+    }
+    else
+    {
+      unsigned long long numNodes = 0;
+
+      goalMoves = this->searchSolution(static_cast<RubiksCubeIndexModel&>(cube),
+        this->inPlaceSearch, true, nullptr, true, 0xFF, numNodes);
+    }
+
+    this->printTableStats();
+
     this->processGoalMoves(solveGoal, cube, 2, allMoves, goalMoves);
 
     // Print the moves.
@@ -215,5 +508,360 @@ namespace busybin
     // the parent class on keypress.)
     this->setSolving(false);
   }
-}
 
+  /**
+   * Solve a cube without printing anything and return the solution.  The
+   * search runs on the calling thread, so many cubes can be solved at once
+   * (e.g. one per pool thread in batch mode).  Call after the databases are
+   * initialized.
+   * @param cube The scrambled cube.
+   * @param pHalt An optional flag that aborts the search when set, in which
+   * case the solution is marked as halted.
+   */
+  CubeSolver::Solution KorfCubeSolver::findSolution(
+    const RubiksCubeIndexModel& cube, const atomic_bool* pHalt) const
+  {
+    return this->findOptimalSolution(cube, pHalt,
+      IDACubeSearcher::boundCallback_t());
+  }
+
+  /**
+   * Same as findSolution, but each IDA* bound is reported to onBound before
+   * it's searched, so a caller can follow the proven lower bound.  If the
+   * search is halted, the solution's lowerBound is the last bound reported.
+   * @param cube The scrambled cube.
+   * @param pHalt An optional flag that aborts the search when set.  It can
+   * be set from onBound.
+   * @param onBound Called on the searching thread with each bound.
+   */
+  CubeSolver::Solution KorfCubeSolver::findOptimalSolution(
+    const RubiksCubeIndexModel& cube, const atomic_bool* pHalt,
+    const IDACubeSearcher::boundCallback_t& onBound) const
+  {
+    RubiksCubeIndexModel iCube(cube);
+    Timer                timer(true);
+    Solution             solution;
+
+    solution.numNodes   = 0;
+    solution.lowerBound = 0;
+
+    solution.moves = this->searchSolution(iCube, this->inPlaceSearch, true,
+      pHalt, false, 0xFF, solution.numNodes,
+      [&solution, &onBound](uint8_t bound)
+      {
+        solution.lowerBound = bound;
+
+        if (onBound)
+          onBound(bound);
+      });
+
+    solution.elapsedSeconds = timer.getElapsedSeconds();
+    solution.halted         = pHalt && *pHalt && solution.moves.empty() &&
+      !iCube.isSolved();
+
+    if (!solution.halted)
+      solution.lowerBound = solution.moves.size();
+
+    return solution;
+  }
+
+  /**
+   * Find every optimal solution of a cube, or the first maxSolutions of
+   * them.  Solutions are streamed to onSolution, which can return false to
+   * stop early.  With more than one search thread, the final bound is
+   * searched in parallel and onSolution is called from the pool threads
+   * (one call at a time).  Call after the databases are initialized.
+   * @param cube The scrambled cube.
+   * @param maxSolutions The most solutions to find (0 for all).
+   * @param onSolution Optional; called with each solution.  Leave it empty
+   * to just count them.
+   * @return The number of solutions found.
+   */
+  unsigned long long KorfCubeSolver::findAllSolutions(
+    const RubiksCubeIndexModel& cube, unsigned long long maxSolutions,
+    const IDACubeSearcher::solutionCallback_t& onSolution) const
+  {
+    RubiksCubeIndexModel iCube(cube);
+    SolveGoal            solveGoal;
+    TwistStore           twistStore(iCube);
+
+    if (this->numSearchThreads > 1)
+    {
+      ParallelIDACubeSearcher idaSearcher(this->pKorfDB.get(), this->pThreadPool,
+        this->splitDepth);
+
+      idaSearcher.setVerbose(false);
+
+      return idaSearcher.findAllGoals(solveGoal, iCube, twistStore,
+        maxSolutions, onSolution);
+    }
+
+    IDACubeSearcher idaSearcher(this->pKorfDB.get());
+
+    idaSearcher.setVerbose(false);
+
+    return idaSearcher.findAllGoals(solveGoal, iCube, twistStore,
+      maxSolutions, onSolution);
+  }
+
+  /**
+   * Search for the solved state on the calling thread.
+   * @param iCube The scrambled cube (left as is).
+   * @param inPlace Whether to use the in-place searcher.
+   * @param useTable Whether to use the transposition table, if there is one
+   * (the in-place searcher doesn't use it).
+   * @param pHalt An optional flag that aborts the search when set.
+   * @param verbose Whether to print progress.
+   * @param maxBound The last IDA* bound to search (0xFF for no limit).
+   * @param numNodes Set to the number of nodes traversed.
+   * @param onBound Optional; called with each IDA* bound.
+   */
+  vector<RubiksCube::MOVE> KorfCubeSolver::searchSolution(
+    RubiksCubeIndexModel& iCube, bool inPlace, bool useTable,
+    const atomic_bool* pHalt, bool verbose, uint8_t maxBound,
+    unsigned long long& numNodes,
+    const IDACubeSearcher::boundCallback_t& onBound) const
+  {
+    SolveGoal    solveGoal;
+    vector<MOVE> moves;
+
+    if (inPlace)
+    {
+      InPlaceIDACubeSearcher<IndexTwistStore> idaSearcher(this->pKorfDB.get());
+      IndexTwistStore                         twistStore(iCube);
+
+      idaSearcher.setVerbose(verbose);
+      idaSearcher.setHaltFlag(pHalt);
+      idaSearcher.setMaxBound(maxBound);
+      idaSearcher.setBoundCallback(onBound);
+
+      moves    = idaSearcher.findGoal(solveGoal, iCube, twistStore);
+      numNodes = idaSearcher.getNumNodes();
+    }
+    else
+    {
+      IDACubeSearcher idaSearcher(this->pKorfDB.get());
+      TwistStore      twistStore(iCube);
+
+      idaSearcher.setVerbose(verbose);
+      idaSearcher.setHaltFlag(pHalt);
+      idaSearcher.setMaxBound(maxBound);
+      idaSearcher.setBoundCallback(onBound);
+
+      if (useTable)
+        idaSearcher.setTranspositionTable(this->pTable.get());
+
+      moves    = idaSearcher.findGoal(solveGoal, iCube, twistStore);
+      numNodes = idaSearcher.getNumNodes();
+    }
+
+    return moves;
+  }
+
+  /**
+   * Print the order that the heuristic's terms are probed in.  Terms added
+   * through getHeuristic are printed by number.
+   */
+  void KorfCubeSolver::printProbeOrder() const
+  {
+    vector<string> names = this->getDatabaseNames();
+
+    cout << "Probe order:";
+
+    for (unsigned term : this->pKorfDB->getProbeOrder())
+      cout << ' ' << (term < names.size() ? names[term] : "term" + std::to_string(term));
+
+    cout << '.' << endl;
+  }
+
+  /**
+   * Print how each database is stored: mapped, or inflated and on which
+   * kind of pages.  For transparent huge pages, the amount the kernel
+   * actually backed with huge pages is included.
+   */
+  void KorfCubeSolver::printStorageReport() const
+  {
+    vector<string> names = this->getDatabaseNames();
+
+    for (unsigned d = 0; d < names.size(); ++d)
+    {
+      const HugePageBuffer& inflated = this->pKorfDB->getInflatedDatabase(d);
+
+      cout << "Korf: " << names[d] << " database ";
+
+      if (inflated.empty())
+      {
+        cout << "mapped" << (this->hugePages ? " (huge pages hinted)" : "")
+             << '.' << endl;
+        continue;
+      }
+
+      cout << "inflated, " << inflated.getSize() / 1048576 << "MB on "
+           << inflated.getBackingName();
+
+      if (inflated.getBacking() == HugePageBuffer::BACKING::TRANSPARENT_HUGE_PAGES)
+        cout << " (" << inflated.getHugePageBytes() / 1048576 << "MB obtained)";
+
+      cout << '.' << endl;
+    }
+  }
+
+  /**
+   * Get the names of the solver's own databases, in the order they were
+   * added to the heuristic (each is a term).
+   */
+  vector<string> KorfCubeSolver::getDatabaseNames() const
+  {
+    vector<string> names;
+
+    names.push_back(this->symmetryReduction ? "cornerSym" : "corner");
+
+    for (const vector<uint8_t>& edges : this->edgeSets)
+      names.push_back(this->getEdgeDatabaseName(edges));
+
+    names.push_back("edgePerm");
+
+    return names;
+  }
+
+  /**
+   * Compare the cost of looking up moves in the packed (nibble) databases
+   * against the inflated (byte) copies, and print the results.  The indices
+   * come from a random walk, so they're spread over the databases about the
+   * same way a search spreads them.  The indices are computed up front so
+   * that only the lookups are timed.  The inflated copies are the ones made
+   * at initialization.  Mapped databases have none, so each is inflated (and
+   * freed) in turn, and at most one inflated copy is in memory at a time.
+   * Call after the databases are initialized.
+   * @param numStates The number of lookups per database.
+   */
+  void KorfCubeSolver::benchmarkLookups(unsigned numStates)
+  {
+    const vector<PatternDatabase*>& dbs   = this->pKorfDB->getDatabases();
+    vector<string>                  names = this->getDatabaseNames();
+
+    RubiksCubeIndexModel   iCube;
+    Random                 rand(0, 17);
+    vector<vector<size_t>> indices(names.size());
+
+    for (vector<size_t>& dbIndices : indices)
+      dbIndices.reserve(numStates);
+
+    for (unsigned i = 0; i < numStates; ++i)
+    {
+      iCube.move((MOVE)rand.next());
+
+      for (unsigned d = 0; d < names.size(); ++d)
+        indices[d].push_back(dbs[d]->getDatabaseIndex(iCube));
+    }
+
+    cout << "Lookup benchmark (" << numStates << " lookups per database)."
+         << endl;
+
+    for (unsigned d = 0; d < names.size(); ++d)
+    {
+      unsigned long long packedSum   = 0;
+      unsigned long long inflatedSum = 0;
+      Timer              timer(true);
+
+      for (size_t ind : indices[d])
+        packedSum += dbs[d]->getNumMoves(ind);
+
+      double packedSecs = timer.getElapsedSeconds();
+
+      // Use the heuristic's own inflated copy if there is one.
+      const HugePageBuffer& resident    = this->pKorfDB->getInflatedDatabase(d);
+      HugePageBuffer        temp;
+      double                inflateSecs = 0;
+
+      if (resident.empty())
+      {
+        timer.restart();
+        temp        = dbs[d]->inflate(this->pThreadPool, this->hugePages);
+        inflateSecs = timer.getElapsedSeconds();
+      }
+
+      const HugePageBuffer& inflated = resident.empty() ? temp : resident;
+
+      timer.restart();
+
+      for (size_t ind : indices[d])
+        inflatedSum += inflated[ind];
+
+      double inflatedSecs = timer.getElapsedSeconds();
+
+      if (packedSum != inflatedSum)
+        throw RubiksCubeException("Inflated lookups do not match packed lookups.");
+
+      cout << names[d] << ": packed " << packedSecs * 1e9 / numStates
+           << "ns/lookup (" << dbs[d]->getSize() / 2 / 1048576 << "MB), "
+           << "inflated " << inflatedSecs * 1e9 / numStates
+           << "ns/lookup (" << dbs[d]->getSize() / 1048576 << "MB on "
+           << inflated.getBackingName();
+
+      if (resident.empty())
+        cout << ", inflated in " << inflateSecs << "s";
+
+      cout << ")." << endl;
+    }
+  }
+
+  /**
+   * Measure the IDA* search speed.  Each cube is searched through its first
+   * numBounds bounds (a full solve of a hard scramble takes hours), once by
+   * copying cubes, once in place, and once by copying with the transposition
+   * table (if there is one).  The nodes per second are printed for each cube
+   * and overall.  Call after the databases are initialized.
+   * @param cubes The scrambled cubes.
+   * @param numBounds The number of IDA* bounds to search for each cube.
+   */
+  void KorfCubeSolver::benchmarkSearch(const vector<RubiksCubeIndexModel>& cubes,
+    unsigned numBounds)
+  {
+    const char* names[]    = {"copy", "in place", "copy + table"};
+    unsigned    numMethods = this->pTable ? 3 : 2;
+
+    cout << "Search benchmark (" << cubes.size() << " cubes, " << numBounds
+         << " bounds each)." << endl;
+
+    for (unsigned method = 0; method < numMethods; ++method)
+    {
+      unsigned long long totalNodes   = 0;
+      double             totalSeconds = 0;
+
+      if (this->pTable)
+        this->pTable->resetStats();
+
+      for (unsigned i = 0; i < cubes.size(); ++i)
+      {
+        RubiksCubeIndexModel iCube(cubes[i]);
+        uint8_t              startBound = this->pKorfDB->getNumMoves(iCube);
+        unsigned long long   numNodes   = 0;
+        Timer                timer(true);
+
+        this->searchSolution(iCube, method == 1, method == 2, nullptr, false,
+          startBound + numBounds - 1, numNodes);
+
+        double seconds = timer.getElapsedSeconds();
+
+        totalNodes   += numNodes;
+        totalSeconds += seconds;
+
+        cout << names[method] << ", cube " << i << ": bounds "
+             << (unsigned)startBound << '-'
+             << (unsigned)(startBound + numBounds - 1) << ", " << numNodes
+             << " nodes in " << seconds << "s (" << numNodes / seconds
+             << " nodes/s)." << endl;
+      }
+
+      cout << names[method] << ", total: " << totalNodes << " nodes in "
+           << totalSeconds << "s (" << totalNodes / totalSeconds
+           << " nodes/s)." << endl;
+
+      this->printProbeOrder();
+
+      if (method == 2)
+        this->printTableStats();
+    }
+  }
+}
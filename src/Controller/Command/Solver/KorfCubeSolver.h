@@ -8,19 +8,32 @@
 #include "../../../Model/Goal/OrientGoal.h"
 #include "../../../Model/Goal/SolveGoal.h"
 #include "../../../Model/Goal/Korf/CornerDatabaseGoal.h"
+#include "../../../Model/Goal/Korf/CornerSymDatabaseGoal.h"
 #include "../../../Model/Goal/Korf/EdgeDatabaseGoal.h"
 #include "../../../Model/Goal/Korf/EdgePermutationDatabaseGoal.h"
+#include "../../../Model/Goal/Korf/EdgeUDSymDatabaseGoal.h"
 #include "../../../Model/MoveStore/TwistStore.h"
 #include "../../../Model/MoveStore/RotationStore.h"
+#include "../../../Model/MoveStore/IndexTwistStore.h"
 #include "../../../Model/PatternDatabase/Korf/CornerPatternDatabase.h"
-#include "../../../Model/PatternDatabase/Korf/EdgeG1PatternDatabase.h"
-#include "../../../Model/PatternDatabase/Korf/EdgeG2PatternDatabase.h"
+#include "../../../Model/PatternDatabase/Korf/CornerSymPatternDatabase.h"
+#include "../../../Model/PatternDatabase/Korf/EdgePatternDatabase.h"
 #include "../../../Model/PatternDatabase/Korf/EdgePermutationPatternDatabase.h"
+#include "../../../Model/PatternDatabase/Korf/EdgeUDSymPatternDatabase.h"
 #include "../../../Model/PatternDatabase/Korf/KorfPatternDatabase.h"
+#include "../../../Model/PatternDatabase/CompositePatternDatabase.h"
 #include "../../../Util/ThreadPool.h"
+#include "../../../Util/HugePageBuffer.h"
+#include "../../../Util/Timer.h"
+#include "../../../Util/Random.h"
 #include "../../Searcher/BreadthFirstCubeSearcher.h"
 #include "../../Searcher/PatternDatabaseIndexer.h"
+#include "../../Searcher/ParallelPatternDatabaseIndexer.h"
+#include "../../Searcher/ExternalPatternDatabaseIndexer.h"
 #include "../../Searcher/IDACubeSearcher.h"
+#include "../../Searcher/ParallelIDACubeSearcher.h"
+#include "../../Searcher/InPlaceIDACubeSearcher.h"
+#include "../../Searcher/TranspositionTable.h"
 #include <iostream>
 using std::cout;
 using std::endl;
@@ -38,6 +51,7 @@ using std::istream_iterator;
 using std::unique_ptr;
 #include <atomic>
 using std::atomic_bool;
+using std::atomic_uint;
 
 namespace busybin
 {
@@ -46,20 +60,44 @@ namespace busybin
    */
   class KorfCubeSolver : public CubeSolver
   {
-    CornerPatternDatabase          cornerDB;
-    EdgeG1PatternDatabase          edgeG1DB;
-    EdgeG2PatternDatabase          edgeG2DB;
-    EdgePermutationPatternDatabase edgePermDB;
-    KorfPatternDatabase            korfDB;
+    unique_ptr<PatternDatabase>         pCornerDB;
+    EdgePermutationPatternDatabase      edgePermDB;
+    vector<vector<uint8_t>>             edgeSets;
+    vector<unique_ptr<PatternDatabase>> edgeDBs;
+    unique_ptr<KorfPatternDatabase>     pKorfDB;
 
-    atomic_bool cornerDBIndexed;
-    atomic_bool edgeG1DBIndexed;
-    atomic_bool edgeG2DBIndexed;
-    atomic_bool edgePermDBIndexed;
+    atomic_uint numDBsIndexed;
+
+    unsigned numSearchThreads;
+    uint8_t  splitDepth;
+    bool     mapDatabases;
+    bool     hugePages;
+    bool     inPlaceSearch;
+    bool     adaptiveOrdering;
+    bool     symmetryReduction;
+    size_t   diskIndexMegabytes;
+
+    unique_ptr<TranspositionTable> pTable;
+
+    bool loadDatabase(PatternDatabase& db, const string& filePath);
+    void buildDatabase(DatabaseGoal& goal, RubiksCubeIndexModel& iCube,
+      MoveStore& moveStore, const string& filePath);
+    vector<MOVE> searchSolution(RubiksCubeIndexModel& iCube, bool inPlace,
+      bool useTable, const atomic_bool* pHalt, bool verbose, uint8_t maxBound,
+      unsigned long long& numNodes, const IDACubeSearcher::boundCallback_t&
+        onBound = IDACubeSearcher::boundCallback_t()) const;
+    void printTableStats() const;
+    vector<string> getDatabaseNames() const;
+    void printProbeOrder() const;
+    void printStorageReport() const;
+
+    bool isEdgeUDSymSet(const vector<uint8_t>& edges) const;
+    PatternDatabase* createEdgeDatabase(const vector<uint8_t>& edges) const;
+    string getEdgeDatabaseName(const vector<uint8_t>& edges) const;
+    string getCornerDatabasePath() const;
 
     void indexCornerDatabase();
-    void indexEdgeG1Database();
-    void indexEdgeG2Database();
+    void indexEdgeDatabase(unsigned ind);
     void indexEdgePermDatabase();
     void onIndexComplete();
 
@@ -67,9 +105,30 @@ namespace busybin
     std::function<void()> onInitialized;
 
   public:
-    KorfCubeSolver(RubiksCubeModel* pCube, ThreadPool* pThreadPool);
+    KorfCubeSolver(RubiksCubeModel* pCube, ThreadPool* pThreadPool,
+      unsigned numSearchThreads = 1, uint8_t splitDepth = 2);
+    void setDatabaseMapping(bool mapDatabases, bool hugePages = false);
+    void setEdgePartition(const vector<vector<uint8_t>>& edgeSets);
+    void setInPlaceSearch(bool inPlaceSearch);
+    void setAdaptiveOrdering(bool adaptiveOrdering);
+    void setSymmetryReduction(bool symmetryReduction);
+    void setDiskIndexing(size_t memoryMegabytes);
+    CompositePatternDatabase& getHeuristic();
+    void setTranspositionTableSize(size_t numMegabytes);
     void initialize(std::function<void()> onInitialized);
     void solveCube(RubiksCube& cube);
+    Solution findSolution(const RubiksCubeIndexModel& cube,
+      const atomic_bool* pHalt = nullptr) const;
+    Solution findOptimalSolution(const RubiksCubeIndexModel& cube,
+      const atomic_bool* pHalt,
+      const IDACubeSearcher::boundCallback_t& onBound) const;
+    unsigned long long findAllSolutions(const RubiksCubeIndexModel& cube,
+      unsigned long long maxSolutions = 0,
+      const IDACubeSearcher::solutionCallback_t& onSolution =
+        IDACubeSearcher::solutionCallback_t()) const;
+    void benchmarkLookups(unsigned numStates = 10000000);
+    void benchmarkSearch(const vector<RubiksCubeIndexModel>& cubes,
+      unsigned numBounds = 5);
   };
 }
 
@@ -14,7 +14,8 @@ namespace busybin
     g1DB(),
     g2DB(),
     g3DB(),
-    g4DB()
+    g4DB(),
+    numDBsIndexed(0)
   {
   }
 
@@ -24,11 +25,14 @@ namespace busybin
   void ThistlethwaiteCubeSolver::initialize(std::function<void()> onInitialized)
   {
     CubeSolver::initialize(onInitialized);
+    this->onInitialized = onInitialized;
 
     // Launch an initialization thread.
     cout << "Initializing pattern databases for ThistlethwaiteCubeSolver." << endl;
 
     // Index each pattern database.
+    this->numDBsIndexed = 0;
+
     this->pThreadPool->addJob(bind(&ThistlethwaiteCubeSolver::indexG1Database, this));
     this->pThreadPool->addJob(bind(&ThistlethwaiteCubeSolver::indexG2Database, this));
     this->pThreadPool->addJob(bind(&ThistlethwaiteCubeSolver::indexG3Database, this));
@@ -63,8 +67,9 @@ namespace busybin
       cout << "Goal 1: " << goal.getDescription() << endl;
       indexer.findGoal(goal, iCube, twistStore);
       this->g1DB.toFile(fileName);
-      this->setSolving(false);
     }
+
+    this->onIndexComplete();
   }
 
   /**
@@ -88,8 +93,9 @@ namespace busybin
       cout << "Goal 2: " << goal.getDescription() << endl;
       indexer.findGoal(goal, iCube, g1TwistStore);
       this->g2DB.toFile(fileName);
-      this->setSolving(false);
     }
+
+    this->onIndexComplete();
   }
 
   /**
@@ -113,8 +119,9 @@ namespace busybin
       cout << "Goal 3: " << goal.getDescription() << endl;
       indexer.findGoal(goal, iCube, g2TwistStore);
       this->g3DB.toFile(fileName);
-      this->setSolving(false);
     }
+
+    this->onIndexComplete();
   }
 
   /**
@@ -138,49 +145,49 @@ namespace busybin
       cout << "Goal 4: " << goal.getDescription() << endl;
       indexer.findGoal(goal, iCube, g3TwistStore);
       this->g4DB.toFile(fileName);
-      this->setSolving(false);
     }
+
+    this->onIndexComplete();
   }
 
   /**
-   * Solve the cube.  This is run in a separate thread.
+   * Each index job calls this when it's complete.  When all are done, the
+   * onInitialized callback is invoked (once: only the last job to finish
+   * sees the count reach 4).
    */
-  void ThistlethwaiteCubeSolver::solveCube()
+  void ThistlethwaiteCubeSolver::onIndexComplete()
   {
-    RubiksCubeModel stdCube = *pCube;
-    vector<MOVE>    allMoves;
-    vector<MOVE>    goalMoves;
-
-    cout << "Solving with Thistlethwaite method." << endl;
-
-    cout << "Initial cube state." << endl;
-
-    // First goal: orient the cube with red up and white front.
+    if (++this->numDBsIndexed == 4)
     {
-      BreadthFirstCubeSearcher bfsSearcher;
-      OrientGoal               orientGoal;
-      RotationStore            rotStore(stdCube);
-
-      goalMoves = bfsSearcher.findGoal(orientGoal, stdCube, rotStore);
-
-      this->processGoalMoves(orientGoal, stdCube, 1, allMoves, goalMoves);
+      cout << "Thistlethwaite initialization complete." << endl;
+      this->onInitialized();
     }
+  }
+
+  /**
+   * Solve the cube.  This is run in a separate thread.
+   */
+  void ThistlethwaiteCubeSolver::solveCube(RubiksCube& cube)
+  {
+    // The index model is always oriented with red up and white front, so the
+    // cube doesn't need to be rotated first.
+    RubiksCubeIndexModel& iCube = static_cast<RubiksCubeIndexModel&>(cube);
+    vector<MOVE>          allMoves;
+    vector<MOVE>          goalMoves;
 
-    // The remaining goals use the index model.  (The cube must be oriented
-    // correctly to be converted to an index model.)
-    RubiksCubeIndexModel iCube(stdCube);
+    cout << "Solving with Thistlethwaite method." << endl;
 
-    // Second goal: Orient all edges (G1).
+    // First goal: Orient all edges (G1).
     {
       IDACubeSearcher idaSearcher(&this->g1DB);
       GoalG0_G1       g1Goal;
       TwistStore      twistStore(iCube);
 
       goalMoves = idaSearcher.findGoal(g1Goal, iCube, twistStore);
-      this->processGoalMoves(g1Goal, iCube, 2, allMoves, goalMoves);
+      this->processGoalMoves(g1Goal, iCube, 1, allMoves, goalMoves);
     }
 
-    // Third goal: Orient all corners and position E slice edges.
+    // Second goal: Orient all corners and position E slice edges.
     // Excludes quarter turns of F and B.
     {
       IDACubeSearcher idaSearcher(&this->g2DB);
@@ -188,10 +195,10 @@ namespace busybin
       G1TwistStore    g1TwistStore(iCube);
 
       goalMoves = idaSearcher.findGoal(g2Goal, iCube, g1TwistStore);
-      this->processGoalMoves(g2Goal, iCube, 3, allMoves, goalMoves);
+      this->processGoalMoves(g2Goal, iCube, 2, allMoves, goalMoves);
     }
 
-    // Fourth goal: Get all corners into tetrad-pairs, and get all edges in
+    // Third goal: Get all corners into tetrad-pairs, and get all edges in
     // their slices.
     {
       IDACubeSearcher idaSearcher(&this->g3DB);
@@ -199,7 +206,7 @@ namespace busybin
       G2TwistStore    g2TwistStore(iCube);
 
       goalMoves = idaSearcher.findGoal(g3Goal, iCube, g2TwistStore);
-      this->processGoalMoves(g3Goal, iCube, 4, allMoves, goalMoves);
+      this->processGoalMoves(g3Goal, iCube, 3, allMoves, goalMoves);
     }
 
     // Fourth goal: Solve the cube.
@@ -209,7 +216,7 @@ namespace busybin
       G3TwistStore    g3TwistStore(iCube);
 
       goalMoves = idaSearcher.findGoal(g4Goal, iCube, g3TwistStore);
-      this->processGoalMoves(g4Goal, iCube, 5, allMoves, goalMoves);
+      this->processGoalMoves(g4Goal, iCube, 4, allMoves, goalMoves);
     }
 
     cout << "\n\nSolved the cube in " << allMoves.size() << " moves.\n";
@@ -218,7 +225,7 @@ namespace busybin
     vector<string> allMoveStrings;
 
     for (MOVE move : allMoves)
-      allMoveStrings.push_back(this->pCube->getMove(move));
+      allMoveStrings.push_back(cube.getMove(move));
 
     for (string move : allMoveStrings)
       cout << move << ' ';
@@ -232,11 +239,62 @@ namespace busybin
       cout << move << ' ';
     cout << endl;
 
-    // Display the cube model.
-    cout << "Resulting cube.\n";
-
     // Done solving - re-enable movement.  (Note that solving is set to true in
     // the parent class on keypress.)
     this->setSolving(false);
   }
+
+  /**
+   * Solve a cube without printing anything and return the solution (see
+   * KorfCubeSolver::findSolution).  Each group is reached with its own
+   * search, and the node counts are summed.
+   * @param cube The scrambled cube.
+   * @param pHalt An optional flag that aborts the search when set.
+   */
+  CubeSolver::Solution ThistlethwaiteCubeSolver::findSolution(
+    const RubiksCubeIndexModel& cube, const atomic_bool* pHalt) const
+  {
+    RubiksCubeIndexModel iCube(cube);
+    GoalG0_G1            g1Goal;
+    GoalG1_G2            g2Goal;
+    GoalG2_G3            g3Goal;
+    GoalG3_G4            g4Goal;
+    TwistStore           twistStore(iCube);
+    G1TwistStore         g1TwistStore(iCube);
+    G2TwistStore         g2TwistStore(iCube);
+    G3TwistStore         g3TwistStore(iCube);
+    Timer                timer(true);
+    Solution             solution;
+
+    const PatternDatabase* dbs[]    = {&this->g1DB, &this->g2DB, &this->g3DB, &this->g4DB};
+    Goal*                  goals[]  = {&g1Goal, &g2Goal, &g3Goal, &g4Goal};
+    MoveStore*             stores[] = {&twistStore, &g1TwistStore, &g2TwistStore, &g3TwistStore};
+
+    solution.numNodes   = 0;
+    solution.halted     = false;
+    solution.lowerBound = 0;
+
+    for (unsigned i = 0; i < 4 && !solution.halted; ++i)
+    {
+      IDACubeSearcher idaSearcher(dbs[i]);
+
+      idaSearcher.setVerbose(false);
+      idaSearcher.setHaltFlag(pHalt);
+
+      vector<MOVE> goalMoves = idaSearcher.findGoal(*goals[i], iCube, *stores[i]);
+
+      if (goalMoves.empty() && pHalt && *pHalt && !goals[i]->isSatisfied(iCube))
+        solution.halted = true;
+
+      for (MOVE move : goalMoves)
+        iCube.move(move);
+
+      solution.moves.insert(solution.moves.end(), goalMoves.begin(), goalMoves.end());
+      solution.numNodes += idaSearcher.getNumNodes();
+    }
+
+    solution.elapsedSeconds = timer.getElapsedSeconds();
+
+    return solution;
+  }
 }
@@ -32,6 +32,9 @@ using std::endl;
 using std::vector;
 #include <string>
 using std::string;
+#include <atomic>
+using std::atomic_bool;
+using std::atomic_uint;
 
 namespace busybin
 {
@@ -45,17 +48,22 @@ namespace busybin
     G3PatternDatabase g3DB;
     G4PatternDatabase g4DB;
 
+    atomic_uint numDBsIndexed;
+
+    std::function<void()> onInitialized;
+
     void indexG1Database();
     void indexG2Database();
     void indexG3Database();
     void indexG4Database();
-
-  protected:
-    void solveCube();
+    void onIndexComplete();
 
   public:
     ThistlethwaiteCubeSolver(RubiksCubeModel* pCube, ThreadPool* pThreadPool);
     void initialize(std::function<void()> onInitialized);
+    void solveCube(RubiksCube& cube);
+    Solution findSolution(const RubiksCubeIndexModel& cube,
+      const atomic_bool* pHalt = nullptr) const;
   };
 }
 
@@ -0,0 +1,109 @@
+#include "TwoPhaseCubeSolver.h"
+
+namespace busybin
+{
+  /**
+   * Init.
+   * @param pCube The cube model (may be null when there's no GUI).
+   * @param pThreadPool A ThreadPool pointer for queueing jobs.
+   */
+  TwoPhaseCubeSolver::TwoPhaseCubeSolver(RubiksCubeModel* pCube, ThreadPool* pThreadPool) :
+    CubeSolver(pCube, pThreadPool),
+    targetLength(20),
+    maxSeconds(0.1)
+  {
+  }
+
+  /**
+   * Set when the search stops improving the solution: as soon as it's at most
+   * targetLength moves (0 to never stop early), or after maxSeconds.  A
+   * solution is always returned, even if it takes longer to find.
+   * @param targetLength The target number of moves (20 by default).
+   * @param maxSeconds The time limit in seconds (0.1 by default).
+   */
+  void TwoPhaseCubeSolver::setBudget(uint8_t targetLength, double maxSeconds)
+  {
+    this->targetLength = targetLength;
+    this->maxSeconds   = maxSeconds;
+  }
+
+  /**
+   * Build the move and pruning tables on the thread pool.  They take well
+   * under a second, so nothing is stored on disk.
+   */
+  void TwoPhaseCubeSolver::initialize(std::function<void()> onInitialized)
+  {
+    CubeSolver::initialize(onInitialized);
+
+    cout << "Initializing tables for TwoPhaseCubeSolver." << endl;
+
+    this->pThreadPool->addJob([onInitialized]()
+    {
+      Timer timer(true);
+
+      TwoPhaseTables::getInstance();
+
+      cout << "Two-phase initialization complete in "
+           << timer.getElapsedSeconds() << "s." << endl;
+      onInitialized();
+    });
+  }
+
+  /**
+   * Solve the cube.  This is run in a separate thread.
+   */
+  void TwoPhaseCubeSolver::solveCube(RubiksCube& cube)
+  {
+    RubiksCubeIndexModel& iCube = static_cast<RubiksCubeIndexModel&>(cube);
+    TwoPhaseCubeSearcher  searcher;
+    SolveGoal             solveGoal;
+    vector<MOVE>          allMoves;
+
+    cout << "Solving with the two-phase method." << endl;
+
+    searcher.setTargetLength(this->targetLength);
+    searcher.setMaxSeconds(this->maxSeconds);
+
+    vector<MOVE> goalMoves = searcher.findSolution(iCube);
+
+    this->processGoalMoves(solveGoal, cube, 1, allMoves, goalMoves);
+
+    cout << "\n\nSolved the cube in " << allMoves.size() << " moves.\n";
+
+    for (MOVE move : allMoves)
+      cout << cube.getMove(move) << ' ';
+    cout << endl;
+
+    // Done solving - re-enable movement.  (Note that solving is set to true in
+    // the parent class on keypress.)
+    this->setSolving(false);
+  }
+
+  /**
+   * Solve a cube without printing anything and return the solution (see
+   * KorfCubeSolver::findSolution).
+   * @param cube The scrambled cube.
+   * @param pHalt An optional flag that aborts the search when set.  The best
+   * solution so far is returned.
+   */
+  CubeSolver::Solution TwoPhaseCubeSolver::findSolution(
+    const RubiksCubeIndexModel& cube, const atomic_bool* pHalt) const
+  {
+    TwoPhaseCubeSearcher searcher;
+    Timer                timer(true);
+    Solution             solution;
+
+    searcher.setVerbose(false);
+    searcher.setHaltFlag(pHalt);
+    searcher.setTargetLength(this->targetLength);
+    searcher.setMaxSeconds(this->maxSeconds);
+
+    solution.moves          = searcher.findSolution(cube);
+    solution.numNodes       = searcher.getNumNodes();
+    solution.elapsedSeconds = timer.getElapsedSeconds();
+    solution.halted         = solution.moves.empty() && pHalt && *pHalt;
+    solution.lowerBound     = 0;
+
+    return solution;
+  }
+}
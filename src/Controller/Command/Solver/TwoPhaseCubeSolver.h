@@ -0,0 +1,43 @@
+#ifndef _BUSYBIN_TWO_PHASE_CUBE_SOLVER_H_
+#define _BUSYBIN_TWO_PHASE_CUBE_SOLVER_H_
+
+#include "CubeSolver.h"
+#include "../../Searcher/TwoPhaseCubeSearcher.h"
+#include "../../../Model/RubiksCubeModel.h"
+#include "../../../Model/RubiksCubeIndexModel.h"
+#include "../../../Model/Coordinate/TwoPhaseTables.h"
+#include "../../../Model/Goal/SolveGoal.h"
+#include "../../../Util/ThreadPool.h"
+#include "../../../Util/Timer.h"
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <vector>
+using std::vector;
+#include <atomic>
+using std::atomic_bool;
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * Solver controller for the cube.  Solves using the two-phase (Kociemba)
+   * method: near-optimal solutions in milliseconds, with no pattern database
+   * files.
+   */
+  class TwoPhaseCubeSolver : public CubeSolver
+  {
+    uint8_t targetLength;
+    double  maxSeconds;
+
+  public:
+    TwoPhaseCubeSolver(RubiksCubeModel* pCube, ThreadPool* pThreadPool);
+    void setBudget(uint8_t targetLength, double maxSeconds);
+    void initialize(std::function<void()> onInitialized);
+    void solveCube(RubiksCube& cube);
+    Solution findSolution(const RubiksCubeIndexModel& cube,
+      const atomic_bool* pHalt = nullptr) const;
+  };
+}
+
+#endif
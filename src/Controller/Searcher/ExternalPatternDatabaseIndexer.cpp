@@ -0,0 +1,508 @@
+#include "ExternalPatternDatabaseIndexer.h"
+
+namespace busybin
+{
+  /**
+   * Initialize the indexer.
+   * @param pThreadPool The pool that each slice is scanned on.
+   * @param filePath The database file to build.
+   * @param memoryMegabytes The memory budget.  Half of it holds a slice of the
+   * database (two entries per byte), and half holds the buckets' buffers.
+   */
+  ExternalPatternDatabaseIndexer::ExternalPatternDatabaseIndexer(
+    ThreadPool* pThreadPool, const string& filePath, size_t memoryMegabytes) :
+    pThreadPool(pThreadPool), filePath(filePath),
+    memoryBytes(max(memoryMegabytes, (size_t)1) << 20)
+  {
+  }
+
+  /**
+   * Index every state in the goal's database, writing it to the file.  The
+   * database itself isn't touched; load it from the file when this returns
+   * (mapping it keeps memory bounded).  If the file exists it's replaced.
+   * @param goal The goal holding the database to index.  The database must
+   * implement getCube.
+   * @param solvedCube A solved cube instance.
+   * @param moveStore A MoveStore instance for retrieving moves.
+   */
+  void ExternalPatternDatabaseIndexer::findGoal(
+    DatabaseGoal& goal,
+    RubiksCubeIndexModel& solvedCube,
+    MoveStore& moveStore
+  )
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    AutoTimer        timer;
+    PatternDatabase& db   = *goal.getDatabase();
+    const size_t     size = db.getSize();
+    Checkpoint       checkpoint;
+    vector<MOVE>     moves;
+
+    for (uint8_t i = 0; i < moveStore.getNumMoves(); ++i)
+      moves.push_back(moveStore.getMove(i));
+
+    if (this->readCheckpoint(size, checkpoint))
+    {
+      cout << "Indexer: Resuming " << this->filePath << " at depth "
+           << (unsigned)checkpoint.depth << " (" << checkpoint.indCount
+           << " states indexed)." << endl;
+    }
+    else
+    {
+      // Each slice holds sliceSize entries in half the budget.  The size is
+      // even so that slices start on a byte, and at most 2^32 so that an
+      // entry's offset in its slice fits in a bucket.
+      size_t sliceSize = min(this->memoryBytes & ~(size_t)1, (size_t)1 << 32);
+
+      checkpoint.sliceSize  = max(sliceSize, (size_t)1 << 16);
+      checkpoint.depth      = 0;
+      checkpoint.pass       = PASS::EXPAND;
+      checkpoint.slice      = 0;
+      checkpoint.indCount   = 1;
+      checkpoint.numAtDepth = 1;
+      checkpoint.numSet     = 0;
+      checkpoint.bucketSizes.assign(
+        (size + checkpoint.sliceSize - 1) / checkpoint.sliceSize, 0);
+
+      this->createDatabaseFile(db, db.getDatabaseIndex(solvedCube));
+      this->writeCheckpoint(size, checkpoint);
+    }
+
+    fstream dbFile(this->getPartPath(),
+      std::ios::in | std::ios::out | std::ios::binary);
+
+    if (!dbFile.is_open())
+      throw RubiksCubeException("Failed to open the database file for indexing.");
+
+    // Nibbles top out at 14 (15 marks an unset entry).
+    while (checkpoint.numAtDepth != 0 && checkpoint.depth < 14)
+    {
+      if (checkpoint.pass == PASS::EXPAND)
+      {
+        if (checkpoint.slice == 0)
+        {
+          cout << "Indexer: Finished depth " << (unsigned)checkpoint.depth
+               << ".  Elapsed time " << timer.getElapsedSeconds()
+               << "s.  Indexed " << checkpoint.indCount << " states." << endl;
+        }
+
+        this->expandSlices(db, moves, dbFile, checkpoint);
+
+        checkpoint.pass   = PASS::MERGE;
+        checkpoint.slice  = 0;
+        checkpoint.numSet = 0;
+        this->writeCheckpoint(size, checkpoint);
+      }
+
+      this->mergeSlices(db, dbFile, checkpoint);
+
+      checkpoint.numAtDepth = checkpoint.numSet;
+      checkpoint.indCount  += checkpoint.numSet;
+      checkpoint.numSet     = 0;
+      checkpoint.pass       = PASS::EXPAND;
+      checkpoint.slice      = 0;
+      ++checkpoint.depth;
+      fill(checkpoint.bucketSizes.begin(), checkpoint.bucketSizes.end(), 0);
+      this->writeCheckpoint(size, checkpoint);
+    }
+
+    dbFile.close();
+
+    if (std::rename(this->getPartPath().c_str(), this->filePath.c_str()) != 0)
+      throw RubiksCubeException("Failed to rename the database file.");
+
+    std::remove(this->getCheckpointPath().c_str());
+
+    cout << "Indexer: Indexed " << checkpoint.indCount << " of " << size
+         << " states in " << timer.getElapsedSeconds() << "s." << endl;
+  }
+
+  /**
+   * The file that the database is built in.
+   */
+  string ExternalPatternDatabaseIndexer::getPartPath() const
+  {
+    return this->filePath + ".part";
+  }
+
+  /**
+   * The file that holds the checkpoint.
+   */
+  string ExternalPatternDatabaseIndexer::getCheckpointPath() const
+  {
+    return this->filePath + ".checkpoint";
+  }
+
+  /**
+   * The file that holds a slice's bucket.
+   */
+  string ExternalPatternDatabaseIndexer::getBucketPath(size_t slice) const
+  {
+    return this->filePath + ".bucket" + std::to_string(slice);
+  }
+
+  /**
+   * Write an empty database file (every entry unset) with the root set to 0.
+   * @param db The database, for its size.
+   * @param rootInd The root's index.
+   */
+  void ExternalPatternDatabaseIndexer::createDatabaseFile(
+    const PatternDatabase& db, size_t rootInd) const
+  {
+    const size_t    numBytes = db.getSize() / 2 + 1;
+    vector<uint8_t> block(min(numBytes, (size_t)1 << 20), 0xFF);
+    ofstream        writer(this->getPartPath(),
+      std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!writer.is_open())
+      throw RubiksCubeException("Failed to open file for writing.");
+
+    for (size_t i = 0; i < numBytes; i += block.size())
+    {
+      writer.write(reinterpret_cast<const char*>(block.data()),
+        min(block.size(), numBytes - i));
+    }
+
+    // Even entries are in the high 4 bits.
+    char rootByte = (rootInd & 1) ? (char)0xF0 : (char)0x0F;
+
+    writer.seekp(rootInd >> 1);
+    writer.write(&rootByte, 1);
+
+    if (!writer)
+      throw RubiksCubeException("Failed to write the database file.");
+  }
+
+  /**
+   * Read the checkpoint left by an earlier build.  Returns false if there
+   * isn't one (or its database file is gone), in which case the build starts
+   * over.
+   * @param size The size of the database.
+   * @param checkpoint Set to the checkpoint.
+   */
+  bool ExternalPatternDatabaseIndexer::readCheckpoint(size_t size,
+    Checkpoint& checkpoint) const
+  {
+    ifstream reader(this->getCheckpointPath());
+    ifstream partFile(this->getPartPath());
+    size_t   fileSize;
+    size_t   numBuckets;
+    unsigned depth;
+    unsigned pass;
+
+    if (!reader.is_open() || !partFile.is_open())
+      return false;
+
+    reader >> fileSize >> checkpoint.sliceSize >> depth >> pass
+           >> checkpoint.slice >> checkpoint.indCount
+           >> checkpoint.numAtDepth >> checkpoint.numSet >> numBuckets;
+
+    if (!reader || fileSize != size || checkpoint.sliceSize == 0 ||
+      numBuckets != (size + checkpoint.sliceSize - 1) / checkpoint.sliceSize)
+    {
+      throw RubiksCubeException("Database checkpoint appears to be corrupt.");
+    }
+
+    checkpoint.bucketSizes.resize(numBuckets);
+
+    for (size_t& bucketSize : checkpoint.bucketSizes)
+      reader >> bucketSize;
+
+    if (!reader)
+      throw RubiksCubeException("Database checkpoint appears to be corrupt.");
+
+    checkpoint.depth = (uint8_t)depth;
+    checkpoint.pass  = (PASS)pass;
+
+    return true;
+  }
+
+  /**
+   * Write the checkpoint.  It's written to a temporary file and renamed, so
+   * a kill leaves either the old checkpoint or the new one.
+   * @param size The size of the database.
+   * @param checkpoint The checkpoint.
+   */
+  void ExternalPatternDatabaseIndexer::writeCheckpoint(size_t size,
+    const Checkpoint& checkpoint) const
+  {
+    string   tempPath = this->getCheckpointPath() + ".tmp";
+    ofstream writer(tempPath, std::ios::out | std::ios::trunc);
+
+    if (!writer.is_open())
+      throw RubiksCubeException("Failed to open file for writing.");
+
+    writer << size << ' ' << checkpoint.sliceSize << ' '
+           << (unsigned)checkpoint.depth << ' ' << (unsigned)checkpoint.pass
+           << ' ' << checkpoint.slice << ' ' << checkpoint.indCount << ' '
+           << checkpoint.numAtDepth << ' ' << checkpoint.numSet << ' '
+           << checkpoint.bucketSizes.size() << '\n';
+
+    for (size_t bucketSize : checkpoint.bucketSizes)
+      writer << bucketSize << '\n';
+
+    writer.close();
+
+    if (!writer)
+      throw RubiksCubeException("Failed to write the database checkpoint.");
+
+    if (std::rename(tempPath.c_str(), this->getCheckpointPath().c_str()) != 0)
+      throw RubiksCubeException("Failed to write the database checkpoint.");
+  }
+
+  /**
+   * Read the checkpoint's slice of the database file.
+   * @param dbFile The database file.
+   * @param checkpoint The checkpoint, for the slice.
+   * @param numBytes The size of the database file.
+   * @param slice Set to the slice.  The last slice includes the file's
+   * trailing byte.
+   */
+  void ExternalPatternDatabaseIndexer::readSlice(fstream& dbFile,
+    const Checkpoint& checkpoint, size_t numBytes,
+    vector<uint8_t>& slice) const
+  {
+    size_t begin = checkpoint.slice * (checkpoint.sliceSize / 2);
+    size_t end   = checkpoint.slice + 1 == checkpoint.bucketSizes.size() ?
+      numBytes : begin + checkpoint.sliceSize / 2;
+
+    slice.resize(end - begin);
+
+    dbFile.seekg(begin);
+    dbFile.read(reinterpret_cast<char*>(slice.data()), slice.size());
+
+    if (!dbFile)
+      throw RubiksCubeException("Failed to read the database file.");
+  }
+
+  /**
+   * The expand pass: expand each state at the checkpoint's depth, slice by
+   * slice, appending the children to the buckets.  Resumes at the
+   * checkpoint's slice, dropping anything written to the buckets after the
+   * checkpoint.
+   */
+  void ExternalPatternDatabaseIndexer::expandSlices(const PatternDatabase& db,
+    const vector<RubiksCube::MOVE>& moves, fstream& dbFile,
+    Checkpoint& checkpoint) const
+  {
+    const size_t    size       = db.getSize();
+    const size_t    numSlices  = checkpoint.bucketSizes.size();
+    const size_t    bufferSize = max(this->memoryBytes / 2 / sizeof(uint32_t) /
+      numSlices, (size_t)1 << 16);
+    const uint8_t   depth      = checkpoint.depth;
+    vector<Bucket>  buckets(numSlices);
+    vector<uint8_t> slice;
+    mutex           bufferMutex;
+    mutex           fileMutex;
+
+    for (size_t i = 0; i < numSlices; ++i)
+    {
+      string bucketPath = this->getBucketPath(i);
+
+      // Anything written after the checkpoint is dropped.
+      if (checkpoint.bucketSizes[i] == 0)
+        std::remove(bucketPath.c_str());
+      else if (truncate(bucketPath.c_str(), checkpoint.bucketSizes[i]) != 0)
+        throw RubiksCubeException("Failed to truncate a database bucket.");
+
+      buckets[i].file.open(bucketPath,
+        std::ios::out | std::ios::binary | std::ios::app);
+      buckets[i].fileSize = checkpoint.bucketSizes[i];
+
+      if (!buckets[i].file.is_open())
+        throw RubiksCubeException("Failed to open file for writing.");
+    }
+
+    while (checkpoint.slice < numSlices)
+    {
+      const size_t sliceInd = checkpoint.slice;
+      const size_t base     = sliceInd * checkpoint.sliceSize;
+
+      this->readSlice(dbFile, checkpoint, size / 2 + 1, slice);
+
+      this->pThreadPool->parallelFor(0, min(checkpoint.sliceSize, size - base),
+        [&](size_t begin, size_t end)
+        {
+          RubiksCubeIndexModel         cube;
+          vector<RubiksCubeIndexModel> children(moves.size());
+          vector<const RubiksCube*>    pChildren(moves.size());
+          vector<size_t>               indexes(moves.size());
+          vector<vector<uint32_t>>     offsets(numSlices);
+          vector<vector<uint32_t>>     full;
+          vector<size_t>               fullInds;
+
+          for (unsigned i = 0; i < moves.size(); ++i)
+            pChildren[i] = &children[i];
+
+          for (size_t ind = begin; ind < end; ++ind)
+          {
+            if (ExternalPatternDatabaseIndexer::getEntry(slice, ind) != depth)
+              continue;
+
+            db.getCube(base + ind, cube);
+
+            for (unsigned i = 0; i < moves.size(); ++i)
+            {
+              children[i] = cube;
+              children[i].applyMove(moves[i]);
+            }
+
+            db.getDatabaseIndexes(pChildren.data(), moves.size(),
+              indexes.data());
+
+            for (size_t childInd : indexes)
+            {
+              size_t   childSlice  = childInd / checkpoint.sliceSize;
+              uint32_t childOffset = childInd % checkpoint.sliceSize;
+
+              // Children in this slice are only kept if they're unset.
+              if (childSlice == sliceInd &&
+                ExternalPatternDatabaseIndexer::getEntry(slice, childOffset) != 0xF)
+              {
+                continue;
+              }
+
+              offsets[childSlice].push_back(childOffset);
+            }
+          }
+
+          // Buffers that fill up are swapped out and written after the lock
+          // is released.
+          {
+            lock_guard<mutex> lock(bufferMutex);
+
+            for (size_t i = 0; i < numSlices; ++i)
+            {
+              vector<uint32_t>& buffer = buckets[i].offsets;
+
+              buffer.insert(buffer.end(), offsets[i].begin(), offsets[i].end());
+
+              if (buffer.size() >= bufferSize)
+              {
+                full.emplace_back();
+                full.back().swap(buffer);
+                fullInds.push_back(i);
+              }
+            }
+          }
+
+          for (size_t i = 0; i < full.size(); ++i)
+            this->writeBucket(buckets[fullInds[i]], full[i], fileMutex);
+        }, 1 << 16);
+
+      for (size_t i = 0; i < numSlices; ++i)
+      {
+        this->writeBucket(buckets[i], buckets[i].offsets, fileMutex);
+        buckets[i].file.flush();
+
+        if (!buckets[i].file)
+          throw RubiksCubeException("Failed to write a database bucket.");
+
+        checkpoint.bucketSizes[i] = buckets[i].fileSize;
+      }
+
+      ++checkpoint.slice;
+      this->writeCheckpoint(size, checkpoint);
+    }
+  }
+
+  /**
+   * Sort and deduplicate a run of offsets and append it to a bucket.
+   * @param bucket The bucket.
+   * @param offsets The offsets, which are cleared.
+   * @param fileMutex Guards the buckets' files.
+   */
+  void ExternalPatternDatabaseIndexer::writeBucket(Bucket& bucket,
+    vector<uint32_t>& offsets, mutex& fileMutex) const
+  {
+    if (offsets.empty())
+      return;
+
+    sort(offsets.begin(), offsets.end());
+    offsets.erase(unique(offsets.begin(), offsets.end()), offsets.end());
+
+    {
+      lock_guard<mutex> lock(fileMutex);
+
+      bucket.file.write(reinterpret_cast<const char*>(offsets.data()),
+        offsets.size() * sizeof(uint32_t));
+      bucket.fileSize += offsets.size() * sizeof(uint32_t);
+    }
+
+    offsets.clear();
+  }
+
+  /**
+   * The merge pass: set each slice's unset children to depth + 1, and count
+   * the states at depth + 1.  A slice is written back before its bucket is
+   * removed, so redoing a slice after a kill is harmless.
+   */
+  void ExternalPatternDatabaseIndexer::mergeSlices(const PatternDatabase& db,
+    fstream& dbFile, Checkpoint& checkpoint) const
+  {
+    const size_t     size      = db.getSize();
+    const size_t     numSlices = checkpoint.bucketSizes.size();
+    const uint8_t    nextDepth = checkpoint.depth + 1;
+    vector<uint8_t>  slice;
+    vector<uint32_t> offsets(this->memoryBytes / 2 / sizeof(uint32_t));
+
+    while (checkpoint.slice < numSlices)
+    {
+      const size_t   sliceBegin = checkpoint.slice * (checkpoint.sliceSize / 2);
+      const size_t   base       = checkpoint.slice * checkpoint.sliceSize;
+      string         bucketPath = this->getBucketPath(checkpoint.slice);
+      ifstream       bucketFile(bucketPath, std::ios::in | std::ios::binary);
+      atomic<size_t> numSet(0);
+
+      this->readSlice(dbFile, checkpoint, size / 2 + 1, slice);
+
+      while (bucketFile.is_open() && bucketFile.read(
+        reinterpret_cast<char*>(offsets.data()),
+        offsets.size() * sizeof(uint32_t)).gcount() != 0)
+      {
+        size_t numOffsets = bucketFile.gcount() / sizeof(uint32_t);
+
+        this->pThreadPool->parallelFor(0, numOffsets,
+          [&](size_t begin, size_t end)
+          {
+            for (size_t i = begin; i < end; ++i)
+            {
+              ExternalPatternDatabaseIndexer::setEntryAtomic(slice, offsets[i],
+                nextDepth);
+            }
+          }, 1 << 16);
+      }
+
+      // The states at depth + 1 are counted rather than the sets, since a
+      // slice that's redone may already hold some of them.
+      this->pThreadPool->parallelFor(0, min(checkpoint.sliceSize, size - base),
+        [&](size_t begin, size_t end)
+        {
+          size_t chunkSet = 0;
+
+          for (size_t i = begin; i < end; ++i)
+          {
+            if (ExternalPatternDatabaseIndexer::getEntry(slice, i) == nextDepth)
+              ++chunkSet;
+          }
+
+          numSet.fetch_add(chunkSet);
+        }, 1 << 16);
+
+      dbFile.seekp(sliceBegin);
+      dbFile.write(reinterpret_cast<const char*>(slice.data()), slice.size());
+      dbFile.flush();
+
+      if (!dbFile)
+        throw RubiksCubeException("Failed to write the database file.");
+
+      bucketFile.close();
+      std::remove(bucketPath.c_str());
+
+      checkpoint.numSet += numSet.load();
+      ++checkpoint.slice;
+      this->writeCheckpoint(size, checkpoint);
+    }
+  }
+}
@@ -0,0 +1,151 @@
+#ifndef _BUSYBIN_EXTERNAL_PATTERN_DATABASE_INDEXER_H_
+#define _BUSYBIN_EXTERNAL_PATTERN_DATABASE_INDEXER_H_
+
+#include "../../Model/RubiksCube.h"
+#include "../../Model/RubiksCubeIndexModel.h"
+#include "../../Model/Goal/DatabaseGoal.h"
+#include "../../Model/MoveStore/MoveStore.h"
+#include "../../Model/PatternDatabase/PatternDatabase.h"
+#include "../../Util/AutoTimer.h"
+#include "../../Util/RubiksCubeException.h"
+#include "../../Util/ThreadPool.h"
+#include <vector>
+using std::vector;
+#include <string>
+using std::string;
+#include <fstream>
+using std::fstream;
+using std::ifstream;
+using std::ofstream;
+#include <mutex>
+using std::mutex;
+using std::lock_guard;
+#include <atomic>
+using std::atomic;
+#include <algorithm>
+using std::min;
+using std::max;
+using std::sort;
+using std::unique;
+using std::fill;
+#include <cstdio>
+#include <unistd.h>
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cstddef>
+using std::size_t;
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * Indexes a pattern database that's too large for memory with a
+   * breadth-first search over the database file itself, which is written in
+   * the same format as PatternDatabase::toFile.
+   *
+   * The file is split into slices that fit in the memory budget, and each
+   * depth takes two passes over it.  The expand pass reads each slice in
+   * turn and expands every entry at depth d (see PatternDatabase::getCube),
+   * appending each child's index to a bucket file for the slice that holds
+   * it.  Duplicate detection is delayed: the buckets are sorted and
+   * deduplicated in runs as they're written, and children in the slice
+   * being read are dropped if they're already set.  The merge pass then
+   * reads each slice and its bucket, sets the unset children to d+1, and
+   * writes the slice back.
+   *
+   * After each slice a checkpoint (the depth, the pass, the next slice, and
+   * the length of each bucket) is written beside the database, so a build
+   * that's killed picks up where it left off when it's run again.  The
+   * database is built in a ".part" file that's renamed when it's done.
+   *
+   * Memory use is about the budget plus the pool's threads' working sets;
+   * disk use peaks at the database plus four bytes per child generated at
+   * the widest depth (less what's deduplicated).
+   */
+  class ExternalPatternDatabaseIndexer
+  {
+    enum class PASS : uint8_t {EXPAND, MERGE};
+
+    /**
+     * Where a build is, as written to the checkpoint file.
+     */
+    struct Checkpoint
+    {
+      size_t         sliceSize;
+      uint8_t        depth;
+      PASS           pass;
+      size_t         slice;
+      size_t         indCount;
+      size_t         numAtDepth;
+      size_t         numSet;
+      vector<size_t> bucketSizes;
+    };
+
+    /**
+     * A slice's bucket: the children in it waiting to be written, and the
+     * file they're appended to.
+     */
+    struct Bucket
+    {
+      vector<uint32_t> offsets;
+      ofstream         file;
+      size_t           fileSize;
+    };
+
+    ThreadPool* pThreadPool;
+    string      filePath;
+    size_t      memoryBytes;
+
+    /**
+     * Get entry ind of a slice read into memory (laid out as in NibbleArray).
+     */
+    static inline uint8_t getEntry(const vector<uint8_t>& slice, size_t ind)
+    {
+      return (slice[ind >> 1] >> ((~ind & 1) << 2)) & 0x0F;
+    }
+
+    /**
+     * Atomically set entry ind of a slice to val if it's unset (see
+     * NibbleArray::compareAndSet).
+     */
+    static inline void setEntryAtomic(vector<uint8_t>& slice, size_t ind,
+      uint8_t val)
+    {
+      uint8_t* pByte = &slice[ind >> 1];
+      unsigned shift = (~ind & 1) << 2;
+      uint8_t  cur   = __atomic_load_n(pByte, __ATOMIC_RELAXED);
+
+      while (((cur >> shift) & 0x0F) == 0x0F &&
+        !__atomic_compare_exchange_n(pByte, &cur,
+          (uint8_t)((cur & ~(0x0F << shift)) | (val << shift)), true,
+          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    }
+
+    string getPartPath() const;
+    string getCheckpointPath() const;
+    string getBucketPath(size_t slice) const;
+
+    void createDatabaseFile(const PatternDatabase& db, size_t rootInd) const;
+    bool readCheckpoint(size_t size, Checkpoint& checkpoint) const;
+    void writeCheckpoint(size_t size, const Checkpoint& checkpoint) const;
+
+    void readSlice(fstream& dbFile, const Checkpoint& checkpoint,
+      size_t numBytes, vector<uint8_t>& slice) const;
+    void expandSlices(const PatternDatabase& db,
+      const vector<RubiksCube::MOVE>& moves, fstream& dbFile,
+      Checkpoint& checkpoint) const;
+    void mergeSlices(const PatternDatabase& db, fstream& dbFile,
+      Checkpoint& checkpoint) const;
+    void writeBucket(Bucket& bucket, vector<uint32_t>& offsets,
+      mutex& fileMutex) const;
+
+  public:
+    ExternalPatternDatabaseIndexer(ThreadPool* pThreadPool,
+      const string& filePath, size_t memoryMegabytes);
+    void findGoal(DatabaseGoal& goal, RubiksCubeIndexModel& solvedCube,
+      MoveStore& moveStore);
+  };
+}
+
+#endif
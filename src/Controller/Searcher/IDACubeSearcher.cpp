@@ -2,16 +2,99 @@
 
 namespace busybin
 {
-
-  long long int traversedStatesAtDepth = 0;
   /**
    * Initialize the searcher with a PatternDatabase instance.
    * @param pPatternDatabase A pointer to a PatternDatabase that will be used
    * to get an estimated distance from a scramble to the solved state.
    */
   IDACubeSearcher::IDACubeSearcher(const PatternDatabase* pPatternDB) :
-    CubeSearcher(), pPatternDB(pPatternDB)
+    CubeSearcher(), pPatternDB(pPatternDB), numNodes(0), verbose(true), pHalt(nullptr),
+    maxBound(0xFF), pTable(nullptr)
+  {
+  }
+
+  /**
+   * Get the number of nodes traversed by the last call to findGoal (over all
+   * bounds).
+   */
+  unsigned long long IDACubeSearcher::getNumNodes() const
+  {
+    return this->numNodes;
+  }
+
+  /**
+   * Turn progress output on or off (on by default).  Batch solvers run many
+   * searches at once and turn it off.
+   */
+  void IDACubeSearcher::setVerbose(bool verbose)
+  {
+    this->verbose = verbose;
+  }
+
+  /**
+   * Set a flag that aborts findGoal when it's set (e.g. from another thread
+   * on a timeout).  An aborted search returns no moves; the caller checks
+   * its flag to tell that apart from a solved cube.
+   * @param pHalt A pointer to the flag, or nullptr for none.
+   */
+  void IDACubeSearcher::setHaltFlag(const atomic_bool* pHalt)
+  {
+    this->pHalt = pHalt;
+  }
+
+  /**
+   * Stop findGoal after searching this bound (used for benchmarking).  A
+   * search that stops early returns no moves.
+   * @param maxBound The last bound to search (0xFF, the default, for none).
+   */
+  void IDACubeSearcher::setMaxBound(uint8_t maxBound)
   {
+    this->maxBound = maxBound;
+  }
+
+  /**
+   * Report each bound before it's searched (see boundCallback_t).  The
+   * callback runs on the searching thread.
+   * @param onBound The callback, or an empty function for none (the
+   * default).
+   */
+  void IDACubeSearcher::setBoundCallback(const boundCallback_t& onBound)
+  {
+    this->onBound = onBound;
+  }
+
+  /**
+   * Prune states that were already reached at the same or a shallower depth
+   * in the current iteration, using a shared table (see TranspositionTable).
+   * The table is not used by findAllGoals, since every path to the goal is
+   * wanted there.
+   * @param pTable The table, or nullptr for none (the default).
+   */
+  void IDACubeSearcher::setTranspositionTable(TranspositionTable* pTable)
+  {
+    this->pTable = pTable;
+  }
+
+  /**
+   * Get a transposition table epoch for a new bound, or 0 if the table isn't
+   * used.
+   */
+  uint16_t IDACubeSearcher::getTableEpoch(const GoalCollector* pCollector) const
+  {
+    if (!this->pTable || pCollector)
+      return 0;
+
+    return this->pTable->newEpoch();
+  }
+
+  /**
+   * Release an epoch from getTableEpoch once the bound is searched.
+   * @param epoch The epoch (0 for none, which is ignored).
+   */
+  void IDACubeSearcher::releaseTableEpoch(uint16_t epoch) const
+  {
+    if (epoch != 0)
+      this->pTable->releaseEpoch(epoch);
   }
 
   /**
@@ -25,127 +108,370 @@ namespace busybin
     RubiksCube& cube, MoveStore& moveStore)
   {
     typedef RubiksCube::MOVE MOVE;
-    typedef priority_queue<PrioritizedMove, vector<PrioritizedMove>,
-      greater<PrioritizedMove> > moveQueue_t;
 
     // The IDA searcher uses pattern databases that were made using an index
     // model, so this searcher only works with an index model.
-    RubiksCubeIndexModel& iCube     = static_cast<RubiksCubeIndexModel&>(cube);
-    AutoTimer             timer;
-    stack<Node>           nodeStack;
-    Node                  curNode;
-    array<MOVE, 50>       moves     = {(MOVE)0xFF};
-    bool                  solved    = goal.isSatisfied(iCube);
-    uint8_t               bound     = 0;
-    const uint8_t         numMoves  = moveStore.getNumMoves();
-    uint8_t               nextBound = this->pPatternDB->getNumMoves(iCube);
-
-    cout << "IDA*: Starting at depth " << (unsigned)nextBound << '.' << endl;
+    RubiksCubeIndexModel& iCube = static_cast<RubiksCubeIndexModel&>(cube);
+    moveList_t            moves = {(MOVE)0xFF};
+
+    if (!this->searchBounds(goal, iCube, moveStore, moves, nullptr))
+      return vector<MOVE>();
+
+    return IDACubeSearcher::toMoveVector(moves);
+  }
+
+  /**
+   * Find every optimal solution: the search finishes the bound at which the
+   * goal is first reached instead of stopping at the first goal.  Solutions
+   * are streamed to onSolution as they're found (in search order), so huge
+   * sets never have to be held in memory.
+   * @param goal The goal to achieve.
+   * @param cube The cube to search.
+   * @param moveStore A MoveStore instance for retrieving moves.
+   * @param maxSolutions Stop after this many solutions (0 for all).
+   * @param onSolution Optional; called with each solution.  Leave it empty to
+   * just count the solutions.
+   * @return The number of solutions found.
+   */
+  unsigned long long IDACubeSearcher::findAllGoals(Goal& goal,
+    RubiksCube& cube, MoveStore& moveStore, unsigned long long maxSolutions,
+    const solutionCallback_t& onSolution)
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    RubiksCubeIndexModel& iCube = static_cast<RubiksCubeIndexModel&>(cube);
+    moveList_t            moves = {(MOVE)0xFF};
+    GoalCollector         collector(&onSolution, maxSolutions);
+
+    this->searchBounds(goal, iCube, moveStore, moves, &collector);
+
+    return collector.getNumSolutions();
+  }
+
+  /**
+   * Run IDA* bound by bound until the goal is reached.  Without a collector
+   * the search stops at the first goal, which is left in moves.  With one,
+   * each bound is searched to the end (or until the collector is full), and
+   * the search stops after the first bound that reaches the goal.  Returns
+   * false if the search was halted or hit maxBound.
+   */
+  bool IDACubeSearcher::searchBounds(Goal& goal, RubiksCubeIndexModel& iCube,
+    MoveStore& moveStore, moveList_t& moves, GoalCollector* pCollector)
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    Timer              timer(true);
+    bool               solved    = goal.isSatisfied(iCube);
+    uint8_t            bound     = 0;
+    uint8_t            nextBound = this->pPatternDB->getNumMoves(iCube);
+    unsigned long long traversedStatesAtDepth = 0;
+
+    this->numNodes = 0;
+
+    // A solved cube has one (empty) solution.
+    if (solved && pCollector)
+      pCollector->add(moves);
+
+    if (this->verbose)
+      cout << "IDA*: Starting at depth " << (unsigned)nextBound << '.' << endl;
 
     while (!solved)
     {
-      if (nodeStack.empty())
+      // If nextBound is initialized to 0 above but the cube is not solved,
+      // the DB is bad.
+      if (nextBound == 0)
+        throw RubiksCubeException("IDA: nextBound set to 0.");
+
+      // If the next bound is not updated then all branches were pruned.
+      // This also indicates a bad DB.
+      if (nextBound == 0xFF)
+        throw RubiksCubeException("IDA: nextBound set to 0xFF.");
+
+      bound                  = nextBound;
+      nextBound              = 0xFF;
+      traversedStatesAtDepth = 0;
+
+      if (this->onBound)
+        this->onBound(bound);
+
+      // Start with the scrambled (root) node.  Depth 0, no move required.
+      uint16_t epoch = this->getTableEpoch(pCollector);
+
+      solved = this->searchBound(goal, iCube, (MOVE)0xFF, 0, moveStore, bound,
+        nextBound, moves, traversedStatesAtDepth, this->pHalt, pCollector,
+        epoch);
+
+      this->releaseTableEpoch(epoch);
+
+      this->numNodes += traversedStatesAtDepth;
+
+      if (pCollector && pCollector->getNumSolutions() != 0)
+        solved = true;
+
+      if (!solved && this->pHalt && *this->pHalt)
+        return false;
+
+      if (!solved && bound >= this->maxBound)
+        return false;
+
+      if (!solved && this->verbose)
       {
-        if (bound != 0)
-        {
-          cout << "IDA*: Finished bound " << (unsigned)bound
-               << ".  Elapsed time: " << timer.getElapsedSeconds() << "s. " <<
-               "traversed staes at this bound: " << traversedStatesAtDepth
-               << endl;
-        }
+        cout << "IDA*: Finished bound " << (unsigned)bound
+             << ".  Elapsed time: " << timer.getElapsedSeconds() << "s. " <<
+             "traversed staes at this bound: " << traversedStatesAtDepth
+             << endl;
+      }
+    }
+
+    if (this->verbose)
+    {
+      cout << "IDA*: Goal reached in " << timer.getElapsedSeconds() << "s. "
+           << "traversed staes at this bound: " << traversedStatesAtDepth
+           << endl;
+    }
 
-        traversedStatesAtDepth = 0;
+    return true;
+  }
 
-        // Start with the scrambled (root) node.  Depth 0, no move required.
-        nodeStack.push({iCube, (MOVE)0xFF, 0});
+  /**
+   * Convert a move list (terminated by 0xFF) to a vector.
+   */
+  vector<RubiksCube::MOVE> IDACubeSearcher::toMoveVector(const moveList_t& moves)
+  {
+    vector<RubiksCube::MOVE> moveVec;
+
+    for (unsigned i = 0; i < moves.size() && (uint8_t)moves.at(i) != 0xFF; ++i)
+      moveVec.push_back(moves.at(i));
+
+    return moveVec;
+  }
+
+  /**
+   * Init.
+   * @param pOnSolution Called with each solution, if it's set.
+   * @param maxSolutions The most solutions to collect (0 for no limit).
+   */
+  IDACubeSearcher::GoalCollector::GoalCollector(
+    const solutionCallback_t* pOnSolution, unsigned long long maxSolutions) :
+    pOnSolution(pOnSolution),
+    maxSolutions(maxSolutions),
+    numSolutions(0),
+    stopped(false)
+  {
+  }
+
+  /**
+   * Record a solution (the moves are terminated by 0xFF).  Returns false
+   * when the search should stop: the limit is reached, or the callback asked
+   * to stop.  Thread safe.
+   */
+  bool IDACubeSearcher::GoalCollector::add(const moveList_t& moves)
+  {
+    lock_guard<mutex> lock(this->collectorMutex);
 
-        // If nextBound is initialized to 0 above but the cube is not solved,
-        // the DB is bad.
-        if (nextBound == 0)
-          throw RubiksCubeException("IDA: nextBound set to 0.");
+    if (this->stopped)
+      return false;
 
-        // If the next bound is not updated then all branches were pruned.
-        // This also indicates a bad DB.
-        if (nextBound == 0xFF)
-          throw RubiksCubeException("IDA: nextBound set to 0xFF.");
+    ++this->numSolutions;
 
-        bound     = nextBound;
-        nextBound = 0xFF;
+    if (this->pOnSolution && *this->pOnSolution &&
+      !(*this->pOnSolution)(IDACubeSearcher::toMoveVector(moves)))
+    {
+      this->stopped = true;
+    }
+
+    if (this->numSolutions == this->maxSolutions)
+      this->stopped = true;
+
+    return !this->stopped;
+  }
+
+  /**
+   * Get the number of solutions collected so far.
+   */
+  unsigned long long IDACubeSearcher::GoalCollector::getNumSolutions()
+  {
+    lock_guard<mutex> lock(this->collectorMutex);
+
+    return this->numSolutions;
+  }
+
+  /**
+   * Search the subtree under root, stopping at bound.  This is one iteration
+   * of IDA*, but it can start below the scrambled cube so that independent
+   * subtrees can be searched separately (e.g. in parallel).
+   * @param goal The goal to achieve.
+   * @param root The cube at the root of the subtree.
+   * @param rootMove The move that led to root (0xFF for the scrambled cube).
+   * @param rootDepth The depth of root in the full search tree.
+   * @param moveStore A MoveStore instance for retrieving moves.
+   * @param bound The current IDA* bound.
+   * @param nextBound Lowered to the smallest estimate that exceeds bound.
+   * @param moves The moves leading up to root (moves[0..rootDepth-1]).  If
+   * the goal is reached, this holds the solution, terminated by 0xFF.
+   * @param numNodes Incremented for each node that's traversed.
+   * @param pHalt Optional flag that aborts the search when set.
+   * @param pCollector Optional.  When set, each goal that's reached is added
+   * to it and the search carries on, until the collector says to stop.
+   * @param epoch The transposition table epoch for this bound, or 0 to not
+   * use the table.
+   * @param pSolved Optional flag that's set when another searcher reaches
+   * the goal (parallel search).  It aborts the search like pHalt.
+   */
+  bool IDACubeSearcher::searchBound(Goal& goal,
+    const RubiksCubeIndexModel& root, RubiksCube::MOVE rootMove,
+    uint8_t rootDepth, MoveStore& moveStore, uint8_t bound,
+    uint8_t& nextBound, moveList_t& moves, unsigned long long& numNodes,
+    const atomic_bool* pHalt, GoalCollector* pCollector, uint16_t epoch,
+    const atomic_bool* pSolved) const
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    TranspositionTable::Stats tableStats = {0, 0, 0, 0, 0};
+    bool                      found      = false;
+
+    // The root can be a duplicate when the tree is split (parallel search).
+    if (epoch != 0 && rootDepth < bound)
+    {
+      uint64_t hash = root.getHash();
+
+      if (this->pTable->isDuplicate(hash, rootDepth, epoch, tableStats))
+      {
+        this->pTable->addStats(tableStats);
+        return false;
+      }
+
+      this->pTable->store(hash, rootDepth, epoch, tableStats);
+    }
+
+    // levels[i] holds the successors of the node being searched at depth
+    // rootDepth + i - 1; levels[0] holds just the root.
+    vector<Expansion> levels(bound - rootDepth + 1);
+    int               level    = 0;
+    const uint8_t     numMoves = moveStore.getNumMoves();
+
+    levels[0].clear();
+    levels[0].successors[0] = {root, rootMove, rootDepth};
+    levels[0].insertLast();
+
+    while (level >= 0 && !found)
+    {
+      // The search may have been halted, or another searcher may have found
+      // the goal.
+      if ((pHalt && *pHalt) || (pSolved && *pSolved))
+        break;
+
+      Expansion& expansion = levels[level];
+
+      if (expansion.next == expansion.size)
+      {
+        // All the successors at this level have been searched.
+        --level;
+        continue;
       }
 
-      curNode = nodeStack.top();
-      nodeStack.pop();
-      ++traversedStatesAtDepth;
+      Successor& curNode = expansion.successors[expansion.order[expansion.next++]];
+      uint8_t    depth   = rootDepth + level;
+
+      ++numNodes;
 
       // Keep the list of moves.  The moves end at 0xFF.
-      moves.at(curNode.depth) = (MOVE)0xFF;
+      moves.at(depth) = (MOVE)0xFF;
 
-      if (curNode.depth != 0)
-        moves[curNode.depth - 1] = curNode.move;
+      if (depth != 0)
+        moves[depth - 1] = curNode.move;
 
-      if (curNode.depth == bound)
+      if (depth == bound)
       {
-        if (goal.isSatisfied(curNode.cube))
-          solved = true;
+        if (goal.isSatisfied(curNode.cube) &&
+          (!pCollector || !pCollector->add(moves)))
+        {
+          found = true;
+        }
+
+        continue;
       }
-      else
+
+      // Generate the successors straight into the next level, sorted by
+      // estimated moves so that the most promising one is searched first.
+      // The successors are all generated before any is estimated, so that
+      // the pattern database lookups can be done as one batch.
+      Expansion&                   successors = levels[level + 1];
+      array<const RubiksCube*, 18> succCubes;
+      array<uint64_t, 18>          succHashes;
+      array<uint8_t, 18>           succEstMoves;
+      uint8_t                      numSuccs   = 0;
+
+      // Nodes at the bound are only checked against the goal, so they're
+      // not worth a table entry.
+      bool useTable = epoch != 0 && depth + 1 < bound;
+
+      successors.clear();
+
+      for (uint8_t i = 0; i < numMoves; ++i)
       {
-        // This is used to sort the successors by estimated moves.
-        moveQueue_t successors;
+        MOVE move = moveStore.getMove(i);
 
-        for (uint8_t i = 0; i < numMoves; ++i)
+        if (depth != 0 && this->pruner.prune(move, curNode.move))
+          continue;
+
+        Successor& succ = successors.successors[numSuccs];
+
+        succ.cube = curNode.cube;
+        succ.cube.applyMove(move);
+
+        if (useTable)
         {
-          MOVE move = moveStore.getMove(i);
+          succHashes[numSuccs] = succ.cube.getHash();
 
-          if (curNode.depth == 0 || !this->pruner.prune(move, curNode.move))
+          if (this->pTable->isDuplicate(succHashes[numSuccs], depth + 1,
+            epoch, tableStats))
           {
-            RubiksCubeIndexModel cubeCopy(curNode.cube);
-
-            cubeCopy.move(move);
-
-            uint8_t estSuccMoves = curNode.depth + 1 + this->pPatternDB->getNumMovesEx(
-              cubeCopy, bound, curNode.depth + 1);
-
-            if (estSuccMoves <= bound)
-            {
-              // If the twisted cube is estimated to take fewer move than the
-              // current bound, push it, otherwise it's pruned.
-              successors.push({cubeCopy, move, estSuccMoves});
-            }
-            else if (estSuccMoves < nextBound)
-            {
-              // The next bound is the minimum of all successor node moves that's
-              // greater than the current bound.
-              nextBound = estSuccMoves;
-            }
+            continue;
           }
         }
 
-        while (!successors.empty())
+        succ.move             = move;
+        succCubes[numSuccs++] = &succ.cube;
+      }
+
+      this->pPatternDB->getNumMovesBatch(succCubes.data(), numSuccs, bound,
+        depth + 1, succEstMoves.data());
+
+      for (uint8_t i = 0; i < numSuccs; ++i)
+      {
+        uint8_t estSuccMoves = depth + 1 + succEstMoves[i];
+
+        if (estSuccMoves <= bound)
+        {
+          // If the twisted cube is estimated to take fewer move than the
+          // current bound, keep it, otherwise it's pruned.  Kept successors
+          // are packed to the front (size never passes i).
+          Successor& succ = successors.successors[successors.size];
+
+          if (successors.size != i)
+            succ = successors.successors[i];
+
+          succ.estMoves = estSuccMoves;
+          successors.insertLast();
+
+          if (useTable)
+            this->pTable->store(succHashes[i], depth + 1, epoch, tableStats);
+        }
+        else if (estSuccMoves < nextBound)
         {
-          // Push the nodes in sorted order.
-          nodeStack.push({
-            successors.top().cube,
-            successors.top().move,
-            (uint8_t)(curNode.depth + 1)
-          });
-
-          successors.pop();
+          // The next bound is the minimum of all successor node moves that's
+          // greater than the current bound.
+          nextBound = estSuccMoves;
         }
       }
-    }
-
-    cout << "IDA*: Goal reached in " << timer.getElapsedSeconds() << "s. "
-         << "traversed staes at this bound: " << traversedStatesAtDepth
-         << endl;
 
-    // Convert the move to a vector.
-    vector<MOVE> moveVec;
+      ++level;
+    }
 
-    for (unsigned i = 0; i < moves.size() && (uint8_t)moves.at(i) != 0xFF; ++i)
-      moveVec.push_back(moves.at(i));
+    if (epoch != 0)
+      this->pTable->addStats(tableStats);
 
-    return moveVec;
+    return found;
   }
 }
-
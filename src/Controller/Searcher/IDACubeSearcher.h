@@ -5,21 +5,26 @@
 #include "../../Model/RubiksCubeIndexModel.h"
 #include "../../Model/Goal/Goal.h"
 #include "../../Model/MoveStore/MoveStore.h"
-#include "../../Util/AutoTimer.h"
+#include "../../Util/Timer.h"
 #include "../../Util/RubiksCubeException.h"
 #include "../../Model/PatternDatabase/PatternDatabase.h"
+#include "TranspositionTable.h"
 #include <string>
 using std::string;
 #include <vector>
 using std::vector;
+#include <iostream>
+using std::cout;
+using std::endl;
 #include <array>
 using std::array;
-#include <queue>
-using std::priority_queue;
-#include <stack>
-using std::stack;
+#include <atomic>
+using std::atomic_bool;
 #include <functional>
-using std::greater;
+using std::function;
+#include <mutex>
+using std::mutex;
+using std::lock_guard;
 #include <cstdint>
 
 namespace busybin
@@ -29,32 +34,114 @@ namespace busybin
    */
   class IDACubeSearcher : public CubeSearcher
   {
-    struct PrioritizedMove
+  public:
+    // Called with each solution found by findAllGoals.  Return false to stop
+    // the search.
+    typedef function<bool(const vector<RubiksCube::MOVE>&)> solutionCallback_t;
+
+    // Called with each bound before it's searched.  Every shorter path was
+    // ruled out, so the bound is a lower bound on the solution length.
+    typedef function<void(uint8_t)> boundCallback_t;
+
+  private:
+    struct Successor
     {
       RubiksCubeIndexModel cube;
-      RubiksCube::MOVE move;
-      uint8_t estMoves; // Priority.  Least number of moves to most.
-      bool operator>(const PrioritizedMove& rhs) const
+      RubiksCube::MOVE     move;
+      uint8_t              estMoves;
+    };
+
+    /**
+     * The successors of one node, sorted from least estimated moves to most.
+     * The search keeps one of these per depth and reuses them, so expanding
+     * a node doesn't allocate.  Only the order is sorted; the cubes stay
+     * where they're generated.
+     */
+    struct Expansion
+    {
+      array<Successor, 18> successors;
+      array<uint8_t, 18>   order;
+      uint8_t              size;
+      uint8_t              next;
+
+      void clear()
+      {
+        this->size = this->next = 0;
+      }
+
+      /**
+       * Insert the successor that was just written to successors[size] into
+       * the sorted order.  Ties keep move order.
+       */
+      void insertLast()
       {
-        return this->estMoves > rhs.estMoves;
+        uint8_t est = this->successors[this->size].estMoves;
+        uint8_t i   = this->size;
+
+        for (; i != 0 && this->successors[this->order[i - 1]].estMoves > est; --i)
+          this->order[i] = this->order[i - 1];
+
+        this->order[i] = this->size++;
       }
     };
 
-    struct Node
+  protected:
+    typedef array<RubiksCube::MOVE, 50> moveList_t;
+
+    const PatternDatabase* pPatternDB;
+    unsigned long long     numNodes;
+    bool                   verbose;
+    const atomic_bool*     pHalt;
+    uint8_t                maxBound;
+    TranspositionTable*    pTable;
+    boundCallback_t        onBound;
+
+    /**
+     * Collects the goals reached at one bound when every solution is wanted
+     * (see findAllGoals).  The workers of a parallel search share one.
+     */
+    class GoalCollector
     {
-      RubiksCubeIndexModel cube;
-      RubiksCube::MOVE move;
-      uint8_t depth;
+      const solutionCallback_t* pOnSolution;
+      unsigned long long        maxSolutions;
+      unsigned long long        numSolutions;
+      bool                      stopped;
+      mutex                     collectorMutex;
+
+    public:
+      GoalCollector(const solutionCallback_t* pOnSolution,
+        unsigned long long maxSolutions);
+      bool add(const moveList_t& moves);
+      unsigned long long getNumSolutions();
     };
 
-    const PatternDatabase* pPatternDB;
+    static vector<RubiksCube::MOVE> toMoveVector(const moveList_t& moves);
+
+    bool searchBound(Goal& goal, const RubiksCubeIndexModel& root,
+      RubiksCube::MOVE rootMove, uint8_t rootDepth, MoveStore& moveStore,
+      uint8_t bound, uint8_t& nextBound, moveList_t& moves,
+      unsigned long long& numNodes, const atomic_bool* pHalt = nullptr,
+      GoalCollector* pCollector = nullptr, uint16_t epoch = 0,
+      const atomic_bool* pSolved = nullptr) const;
+    uint16_t getTableEpoch(const GoalCollector* pCollector) const;
+    void releaseTableEpoch(uint16_t epoch) const;
+    bool searchBounds(Goal& goal, RubiksCubeIndexModel& iCube,
+      MoveStore& moveStore, moveList_t& moves, GoalCollector* pCollector);
 
   public:
     IDACubeSearcher(const PatternDatabase* pPatternDB);
     vector<RubiksCube::MOVE> findGoal(Goal& goal, RubiksCube& cube,
       MoveStore& moveStore);
+    virtual unsigned long long findAllGoals(Goal& goal, RubiksCube& cube,
+      MoveStore& moveStore, unsigned long long maxSolutions = 0,
+      const solutionCallback_t& onSolution = solutionCallback_t());
+    unsigned long long getNumNodes() const;
+    void setVerbose(bool verbose);
+    void setHaltFlag(const atomic_bool* pHalt);
+    void setMaxBound(uint8_t maxBound);
+    void setTranspositionTable(TranspositionTable* pTable);
+    void setBoundCallback(const boundCallback_t& onBound);
   };
 }
 
 #endif
-
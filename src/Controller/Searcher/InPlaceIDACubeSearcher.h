@@ -0,0 +1,191 @@
+#ifndef _BUSYBIN_IN_PLACE_IDA_CUBE_SEARCHER_H_
+#define _BUSYBIN_IN_PLACE_IDA_CUBE_SEARCHER_H_
+
+#include "IDACubeSearcher.h"
+#include "../../Model/RubiksCubeIndexModel.h"
+#include "../../Model/Goal/Goal.h"
+#include "../../Model/MoveStore/MoveStore.h"
+#include "../../Model/PatternDatabase/PatternDatabase.h"
+#include "../../Util/Timer.h"
+#include "../../Util/RubiksCubeException.h"
+#include <vector>
+using std::vector;
+#include <array>
+using std::array;
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * IDA* that works on a single cube: each move is applied before the
+   * recursion and undone after it (like IDDFSCubeSearcher), rather than
+   * copying the cube for every child like IDACubeSearcher does.  Successors
+   * are visited in move order, since there are no copies to sort.
+   *
+   * The depth loop is compiled for TMoveStore, so with a final store like
+   * IndexTwistStore the moves and inverses are direct calls into the move
+   * tables.  Any MoveStore works (through virtual calls) with TMoveStore =
+   * MoveStore.  findGoal must be passed a TMoveStore that moves cube.
+   *
+   * Which of the two strategies is faster depends on the hardware (a copy is
+   * 40 bytes; an undo is another table lookup), so KorfCubeSolver can use
+   * either.
+   */
+  template <class TMoveStore>
+  class InPlaceIDACubeSearcher : public IDACubeSearcher
+  {
+    array<RubiksCube::MOVE, 18> storeMoves;
+    uint8_t                     numStoreMoves;
+
+    /**
+     * Search below the node at depth, stopping at bound.
+     * @param goal The goal to achieve.
+     * @param cube The cube, which is moved in place (and restored).
+     * @param moveStore The store that moves cube.
+     * @param depth The depth of the current node.
+     * @param bound The current IDA* bound.
+     * @param nextBound Lowered to the smallest estimate that exceeds bound.
+     * @param moves The moves leading to the current node.  If the goal is
+     * reached, this holds the solution, terminated by 0xFF.
+     */
+    bool searchDepth(Goal& goal, RubiksCubeIndexModel& cube,
+      TMoveStore& moveStore, uint8_t depth, uint8_t bound, uint8_t& nextBound,
+      moveList_t& moves)
+    {
+      typedef RubiksCube::MOVE MOVE;
+
+      ++this->numNodes;
+
+      if (depth == bound)
+        return goal.isSatisfied(cube);
+
+      // Another searcher may have found the goal, or the caller gave up.
+      if (this->pHalt && *this->pHalt)
+        return false;
+
+      for (uint8_t i = 0; i < this->numStoreMoves; ++i)
+      {
+        MOVE move = this->storeMoves[i];
+
+        if (depth != 0 && this->pruner.prune(move, moves[depth - 1]))
+          continue;
+
+        moveStore.move(i);
+
+        uint8_t estSuccMoves = depth + 1 + this->pPatternDB->getNumMovesEx(
+          cube, bound, depth + 1);
+
+        if (estSuccMoves <= bound)
+        {
+          moves[depth]     = move;
+          moves[depth + 1] = (MOVE)0xFF;
+
+          if (this->searchDepth(goal, cube, moveStore, depth + 1, bound,
+            nextBound, moves))
+          {
+            moveStore.invert(i);
+            return true;
+          }
+        }
+        else if (estSuccMoves < nextBound)
+          nextBound = estSuccMoves;
+
+        moveStore.invert(i);
+      }
+
+      moves[depth] = (MOVE)0xFF;
+
+      return false;
+    }
+
+  public:
+    /**
+     * Initialize the searcher with a PatternDatabase instance.
+     * @param pPatternDB A pointer to a PatternDatabase that will be used to
+     * get an estimated distance from a scramble to the solved state.
+     */
+    InPlaceIDACubeSearcher(const PatternDatabase* pPatternDB) :
+      IDACubeSearcher(pPatternDB), numStoreMoves(0)
+    {
+    }
+
+    /**
+     * Search the cube until goal is reached and return the moves required
+     * to achieve goal.  The cube is left as it was.
+     * @param goal The goal to achieve (isSatisfied is called on the goal).
+     * @param cube The cube to search (a RubiksCubeIndexModel).
+     * @param moveStore A TMoveStore that moves cube.
+     */
+    vector<RubiksCube::MOVE> findGoal(Goal& goal, RubiksCube& cube,
+      MoveStore& moveStore)
+    {
+      typedef RubiksCube::MOVE MOVE;
+
+      RubiksCubeIndexModel& iCube     = static_cast<RubiksCubeIndexModel&>(cube);
+      TMoveStore&           store     = static_cast<TMoveStore&>(moveStore);
+      Timer                 timer(true);
+      moveList_t            moves     = {(MOVE)0xFF};
+      bool                  solved    = goal.isSatisfied(iCube);
+      uint8_t               bound     = 0;
+      uint8_t               nextBound = this->pPatternDB->getNumMoves(iCube);
+
+      if (store.getNumMoves() > this->storeMoves.size())
+        throw RubiksCubeException("InPlaceIDACubeSearcher: too many moves in the store.");
+
+      // Copy the move list once, rather than going through the store's
+      // (virtual) getMoves at every node.
+      this->numStoreMoves = store.getNumMoves();
+
+      for (uint8_t i = 0; i < this->numStoreMoves; ++i)
+        this->storeMoves[i] = store.getMove(i);
+
+      this->numNodes = 0;
+
+      if (this->verbose)
+        cout << "IDA* (in place): Starting at depth " << (unsigned)nextBound << '.' << endl;
+
+      while (!solved)
+      {
+        if (nextBound == 0)
+          throw RubiksCubeException("IDA: nextBound set to 0.");
+
+        if (nextBound == 0xFF)
+          throw RubiksCubeException("IDA: nextBound set to 0xFF.");
+
+        bound     = nextBound;
+        nextBound = 0xFF;
+
+        if (this->onBound)
+          this->onBound(bound);
+
+        solved = this->searchDepth(goal, iCube, store, 0, bound, nextBound, moves);
+
+        if (!solved && this->pHalt && *this->pHalt)
+          return vector<MOVE>();
+
+        if (!solved && bound >= this->maxBound)
+          return vector<MOVE>();
+
+        if (!solved && this->verbose)
+        {
+          cout << "IDA* (in place): Finished bound " << (unsigned)bound
+               << ".  Elapsed time: " << timer.getElapsedSeconds() << "s. "
+               << "Traversed states: " << this->numNodes << endl;
+        }
+      }
+
+      if (this->verbose)
+      {
+        cout << "IDA* (in place): Goal reached in " << timer.getElapsedSeconds()
+             << "s.  Traversed states: " << this->numNodes << endl;
+      }
+
+      return IDACubeSearcher::toMoveVector(moves);
+    }
+  };
+}
+
+#endif
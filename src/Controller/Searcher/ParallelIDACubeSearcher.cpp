@@ -0,0 +1,292 @@
+#include "ParallelIDACubeSearcher.h"
+
+namespace busybin
+{
+  /**
+   * Initialize the searcher.
+   * @param pPatternDB A pointer to a PatternDatabase that will be used to get
+   * an estimated distance from a scramble to the solved state.  It's read
+   * concurrently by all the workers.
+   * @param pThreadPool The pool that the subtrees are searched on.
+   * @param splitDepth The depth at which the tree is split into subtrees.  At
+   * depth 2 there are up to 18*15 subtrees for the 18 twists.
+   */
+  ParallelIDACubeSearcher::ParallelIDACubeSearcher(
+    const PatternDatabase* pPatternDB, ThreadPool* pThreadPool,
+    uint8_t splitDepth) :
+    IDACubeSearcher(pPatternDB),
+    pThreadPool(pThreadPool),
+    splitDepth(splitDepth)
+  {
+  }
+
+  /**
+   * Search the cube until goal is reached and return the moves required
+   * to achieve goal.
+   * @param goal The goal to achieve (isSatisfied is called on the goal).  It
+   * is checked concurrently, so it must not hold state.
+   * @param cube The cube to search.
+   * @param moveStore A MoveStore instance for retrieving moves.
+   */
+  vector<RubiksCube::MOVE> ParallelIDACubeSearcher::findGoal(Goal& goal,
+    RubiksCube& cube, MoveStore& moveStore)
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    RubiksCubeIndexModel& iCube    = static_cast<RubiksCubeIndexModel&>(cube);
+    moveList_t            solution = {(MOVE)0xFF};
+
+    // A halted search, or one that hit maxBound, returns no moves.
+    if (!this->searchBounds(goal, iCube, moveStore, solution, nullptr))
+      return vector<MOVE>();
+
+    return IDACubeSearcher::toMoveVector(solution);
+  }
+
+  /**
+   * Find every optimal solution (see IDACubeSearcher::findAllGoals).  The
+   * subtrees of the final bound are searched in parallel, and onSolution is
+   * called from the pool threads, one call at a time.
+   * @param goal The goal to achieve.  It must not hold state.
+   * @param cube The cube to search.
+   * @param moveStore A MoveStore instance for retrieving moves.
+   * @param maxSolutions Stop after this many solutions (0 for all).
+   * @param onSolution Optional; called with each solution.
+   * @return The number of solutions found.
+   */
+  unsigned long long ParallelIDACubeSearcher::findAllGoals(Goal& goal,
+    RubiksCube& cube, MoveStore& moveStore, unsigned long long maxSolutions,
+    const solutionCallback_t& onSolution)
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    RubiksCubeIndexModel& iCube    = static_cast<RubiksCubeIndexModel&>(cube);
+    moveList_t            solution = {(MOVE)0xFF};
+    GoalCollector         collector(&onSolution, maxSolutions);
+
+    this->searchBounds(goal, iCube, moveStore, solution, &collector);
+
+    return collector.getNumSolutions();
+  }
+
+  /**
+   * Run the bounds until the goal is reached.  Without a collector the first
+   * solution found is left in solution; with one, the bound that first
+   * reaches the goal is searched to the end (or until the collector is
+   * full).  Returns false if the search was halted (see setHaltFlag) or hit
+   * maxBound (see setMaxBound).
+   */
+  bool ParallelIDACubeSearcher::searchBounds(Goal& goal,
+    RubiksCubeIndexModel& iCube, MoveStore& moveStore, moveList_t& solution,
+    GoalCollector* pCollector)
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    Timer   timer(true);
+    uint8_t bound     = 0;
+    uint8_t nextBound = this->pPatternDB->getNumMoves(iCube);
+
+    this->numNodes = 0;
+
+    if (goal.isSatisfied(iCube))
+    {
+      if (pCollector)
+        pCollector->add(solution);
+
+      return true;
+    }
+
+    if (this->verbose)
+    {
+      cout << "Parallel IDA*: Starting at depth " << (unsigned)nextBound
+           << " with " << this->pThreadPool->getNumThreads()
+           << " threads." << endl;
+    }
+
+    while (true)
+    {
+      // See IDACubeSearcher::searchBounds.
+      if (nextBound == 0)
+        throw RubiksCubeException("IDA: nextBound set to 0.");
+
+      if (nextBound == 0xFF)
+        throw RubiksCubeException("IDA: nextBound set to 0xFF.");
+
+      bound     = nextBound;
+      nextBound = 0xFF;
+
+      if (this->onBound)
+        this->onBound(bound);
+
+      // Split the tree into independent subtrees.  Pruning near the root
+      // also lowers the next bound.
+      vector<Subtree> subtrees;
+      moveList_t      moves = {(MOVE)0xFF};
+
+      this->splitTree(iCube, moveStore, 0, bound, moves, nextBound, subtrees);
+
+      // The subtrees are handed out one at a time since their sizes vary
+      // wildly.  Idle workers steal the remaining ones.
+      BoundState state;
+      uint16_t   epoch = this->getTableEpoch(pCollector);
+
+      state.solved      = false;
+      state.nextBound   = nextBound;
+      state.numNodes    = 0;
+
+      this->pThreadPool->parallelFor(0, subtrees.size(),
+        [&](size_t begin, size_t end)
+        {
+          this->searchSubtrees(goal, moveStore, bound, subtrees, begin, end,
+            state, pCollector, epoch);
+        }, 1);
+
+      this->releaseTableEpoch(epoch);
+
+      this->numNodes += state.numNodes;
+
+      if (state.solved || (pCollector && pCollector->getNumSolutions() != 0))
+      {
+        if (this->verbose)
+        {
+          cout << "Parallel IDA*: Goal reached in " << timer.getElapsedSeconds()
+               << "s. " << "traversed staes at this bound: " << state.numNodes
+               << endl;
+        }
+
+        solution = state.solution;
+
+        return true;
+      }
+
+      if (this->pHalt && *this->pHalt)
+        return false;
+
+      if (bound >= this->maxBound)
+        return false;
+
+      nextBound = state.nextBound;
+
+      if (this->verbose)
+      {
+        cout << "Parallel IDA*: Finished bound " << (unsigned)bound
+             << " (" << subtrees.size() << " subtrees).  Elapsed time: "
+             << timer.getElapsedSeconds() << "s. "
+             << "traversed staes at this bound: " << state.numNodes << endl;
+      }
+    }
+  }
+
+  /**
+   * Collect the nodes at splitDepth (or at bound, if it's shallower) that
+   * survive pruning.  Children are visited in move order.
+   * @param cube The cube at this node.
+   * @param moveStore A MoveStore instance for retrieving moves.
+   * @param depth The depth of this node.
+   * @param bound The current IDA* bound.
+   * @param moves The moves leading to this node, terminated by 0xFF.
+   * @param nextBound Lowered to the smallest estimate that exceeds bound.
+   * @param subtrees The roots of the subtrees are added here.
+   */
+  void ParallelIDACubeSearcher::splitTree(const RubiksCubeIndexModel& cube,
+    MoveStore& moveStore, uint8_t depth, uint8_t bound, moveList_t& moves,
+    uint8_t& nextBound, vector<Subtree>& subtrees) const
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    if (depth == this->splitDepth || depth == bound)
+    {
+      subtrees.push_back({PackedCube(cube), moves, depth});
+      return;
+    }
+
+    const uint8_t numMoves = moveStore.getNumMoves();
+
+    for (uint8_t i = 0; i < numMoves; ++i)
+    {
+      MOVE move = moveStore.getMove(i);
+
+      if (depth != 0 && this->pruner.prune(move, moves[depth - 1]))
+        continue;
+
+      RubiksCubeIndexModel cubeCopy(cube);
+
+      cubeCopy.applyMove(move);
+
+      uint8_t estSuccMoves = depth + 1 + this->pPatternDB->getNumMovesEx(
+        cubeCopy, bound, depth + 1);
+
+      if (estSuccMoves <= bound)
+      {
+        moves[depth]     = move;
+        moves[depth + 1] = (MOVE)0xFF;
+
+        this->splitTree(cubeCopy, moveStore, depth + 1, bound, moves,
+          nextBound, subtrees);
+
+        moves[depth] = (MOVE)0xFF;
+      }
+      else if (estSuccMoves < nextBound)
+        nextBound = estSuccMoves;
+    }
+  }
+
+  /**
+   * Search the subtrees in [begin, end) until they're exhausted or the goal
+   * is reached.
+   * @param goal The goal to achieve.
+   * @param moveStore A MoveStore instance for retrieving moves.
+   * @param bound The current IDA* bound.
+   * @param subtrees The subtrees to search.
+   * @param begin The index of the first subtree.
+   * @param end One past the index of the last subtree.
+   * @param state State shared by all workers.
+   * @param pCollector Optional; collects every goal (see
+   * IDACubeSearcher::searchBound).  The workers stop when it's full.
+   * @param epoch The transposition table epoch for this bound (0 for none).
+   * The workers share the table.
+   */
+  void ParallelIDACubeSearcher::searchSubtrees(Goal& goal,
+    MoveStore& moveStore, uint8_t bound, const vector<Subtree>& subtrees,
+    size_t begin, size_t end, BoundState& state, GoalCollector* pCollector,
+    uint16_t epoch) const
+  {
+    unsigned long long   numNodes  = 0;
+    uint8_t              nextBound = 0xFF;
+    moveList_t           moves;
+    RubiksCubeIndexModel root;
+
+    for (size_t ind = begin; ind < end && !state.solved &&
+      !(this->pHalt && *this->pHalt); ++ind)
+    {
+      const Subtree& subtree = subtrees[ind];
+      RubiksCube::MOVE rootMove = subtree.depth == 0 ?
+        (RubiksCube::MOVE)0xFF : subtree.moves[subtree.depth - 1];
+
+      moves = subtree.moves;
+      subtree.cube.unpack(root);
+
+      if (this->searchBound(goal, root, rootMove, subtree.depth,
+        moveStore, bound, nextBound, moves, numNodes, this->pHalt, pCollector,
+        epoch, &state.solved))
+      {
+        lock_guard<mutex> lock(state.stateMutex);
+
+        // Only the first solution is kept; any solution at this bound is
+        // optimal.
+        if (!state.solved)
+        {
+          state.solution = moves;
+          state.solved   = true;
+        }
+      }
+    }
+
+    lock_guard<mutex> lock(state.stateMutex);
+
+    state.numNodes += numNodes;
+
+    if (nextBound < state.nextBound)
+      state.nextBound = nextBound;
+  }
+}
@@ -0,0 +1,81 @@
+#ifndef _BUSYBIN_PARALLEL_IDA_CUBE_SEARCHER_H_
+#define _BUSYBIN_PARALLEL_IDA_CUBE_SEARCHER_H_
+
+#include "IDACubeSearcher.h"
+#include "../../Model/RubiksCubeIndexModel.h"
+#include "../../Model/PackedCube.h"
+#include "../../Model/Goal/Goal.h"
+#include "../../Model/MoveStore/MoveStore.h"
+#include "../../Model/PatternDatabase/PatternDatabase.h"
+#include "../../Util/Timer.h"
+#include "../../Util/RubiksCubeException.h"
+#include "../../Util/ThreadPool.h"
+#include <vector>
+using std::vector;
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <mutex>
+using std::mutex;
+using std::lock_guard;
+#include <atomic>
+using std::atomic;
+using std::atomic_bool;
+#include <cstddef>
+using std::size_t;
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * IDA* searcher that splits the search tree into independent subtrees at a
+   * fixed depth and searches the subtrees in parallel on a ThreadPool.  Each
+   * bound is split anew, and all the workers stop as soon as any of them
+   * reaches the goal.  The pattern database is shared by the workers and
+   * must not be modified during the search.
+   */
+  class ParallelIDACubeSearcher : public IDACubeSearcher
+  {
+    // A subtree root.  The cube is packed: a bound can split into many
+    // subtrees.
+    struct Subtree
+    {
+      PackedCube cube;
+      moveList_t moves;
+      uint8_t depth;
+    };
+
+    // State shared by the workers while searching one bound.
+    struct BoundState
+    {
+      atomic_bool        solved;
+      mutex              stateMutex;
+      uint8_t            nextBound;
+      unsigned long long numNodes;
+      moveList_t         solution;
+    };
+
+    ThreadPool* pThreadPool;
+    uint8_t     splitDepth;
+
+    void splitTree(const RubiksCubeIndexModel& cube, MoveStore& moveStore,
+      uint8_t depth, uint8_t bound, moveList_t& moves, uint8_t& nextBound,
+      vector<Subtree>& subtrees) const;
+    void searchSubtrees(Goal& goal, MoveStore& moveStore, uint8_t bound,
+      const vector<Subtree>& subtrees, size_t begin, size_t end,
+      BoundState& state, GoalCollector* pCollector, uint16_t epoch) const;
+    bool searchBounds(Goal& goal, RubiksCubeIndexModel& iCube,
+      MoveStore& moveStore, moveList_t& solution, GoalCollector* pCollector);
+
+  public:
+    ParallelIDACubeSearcher(const PatternDatabase* pPatternDB,
+      ThreadPool* pThreadPool, uint8_t splitDepth = 2);
+    vector<RubiksCube::MOVE> findGoal(Goal& goal, RubiksCube& cube,
+      MoveStore& moveStore);
+    unsigned long long findAllGoals(Goal& goal, RubiksCube& cube,
+      MoveStore& moveStore, unsigned long long maxSolutions = 0,
+      const solutionCallback_t& onSolution = solutionCallback_t());
+  };
+}
+
+#endif
@@ -0,0 +1,159 @@
+#include "ParallelPatternDatabaseIndexer.h"
+
+namespace busybin
+{
+  /**
+   * Initialize the indexer.
+   * @param pThreadPool The pool that the database is scanned on.
+   */
+  ParallelPatternDatabaseIndexer::ParallelPatternDatabaseIndexer(
+    ThreadPool* pThreadPool) : pThreadPool(pThreadPool)
+  {
+  }
+
+  /**
+   * Index every state in the goal's database.
+   * @param goal The goal holding the database to index.  The database must
+   * implement getCube.
+   * @param solvedCube A solved cube instance.
+   * @param moveStore A MoveStore instance for retrieving moves.
+   */
+  void ParallelPatternDatabaseIndexer::findGoal(
+    DatabaseGoal& goal,
+    RubiksCubeIndexModel& solvedCube,
+    MoveStore& moveStore
+  )
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    AutoTimer        timer;
+    PatternDatabase& db       = *goal.getDatabase();
+    const size_t     size     = db.getSize();
+    size_t           indCount = 0;
+    size_t           numAtDepth;
+    vector<MOVE>     moves;
+
+    for (uint8_t i = 0; i < moveStore.getNumMoves(); ++i)
+      moves.push_back(moveStore.getMove(i));
+
+    // Index the root node in the database.
+    if (db.setNumMovesAtomic(db.getDatabaseIndex(solvedCube), 0))
+      ++indCount;
+
+    numAtDepth = indCount;
+
+    // Nibbles top out at 14 (15 marks an unset entry).
+    for (uint8_t depth = 0; numAtDepth != 0 && depth < 14; ++depth)
+    {
+      cout << "Indexer: Finished depth " << (unsigned)depth << ".  Elapsed time "
+           << timer.getElapsedSeconds() << "s.  Indexed " << indCount
+           << " states." << endl;
+
+      // Expanding the frontier touches numAtDepth states; searching backward
+      // touches every unset state, but most of them find a neighbor early.
+      bool           reverse = numAtDepth > size - indCount;
+      atomic<size_t> numSet(0);
+
+      this->pThreadPool->parallelFor(0, size,
+        [this, &db, &moves, depth, reverse, &numSet](size_t begin, size_t end)
+        {
+          size_t chunkSet = reverse ?
+            this->reverseExpandChunk(db, moves, depth, begin, end) :
+            this->expandChunk(db, moves, depth, begin, end);
+
+          numSet.fetch_add(chunkSet);
+        }, 1 << 16);
+
+      numAtDepth = numSet.load();
+      indCount  += numAtDepth;
+      db.setNumItems(indCount);
+    }
+
+    cout << "Indexer: Indexed " << indCount << " of " << size
+         << " states in " << timer.getElapsedSeconds() << "s." << endl;
+  }
+
+  /**
+   * Expand each state at depth in [begin, end), setting its unset children
+   * to depth + 1.  Returns the number of children set.  The children of a
+   * state are indexed together (see PatternDatabase::getDatabaseIndexes).
+   */
+  size_t ParallelPatternDatabaseIndexer::expandChunk(PatternDatabase& db,
+    const vector<RubiksCube::MOVE>& moves, uint8_t depth, size_t begin,
+    size_t end) const
+  {
+    RubiksCubeIndexModel         cube;
+    vector<RubiksCubeIndexModel> children(moves.size());
+    vector<const RubiksCube*>    pChildren(moves.size());
+    vector<size_t>               indexes(moves.size());
+    size_t                       numSet = 0;
+
+    for (unsigned i = 0; i < moves.size(); ++i)
+      pChildren[i] = &children[i];
+
+    for (size_t ind = begin; ind < end; ++ind)
+    {
+      if (db.getNumMoves(ind) != depth)
+        continue;
+
+      db.getCube(ind, cube);
+
+      for (unsigned i = 0; i < moves.size(); ++i)
+      {
+        children[i] = cube;
+        children[i].applyMove(moves[i]);
+      }
+
+      db.getDatabaseIndexes(pChildren.data(), moves.size(), indexes.data());
+
+      for (size_t childInd : indexes)
+      {
+        if (db.setNumMovesAtomic(childInd, depth + 1))
+          ++numSet;
+      }
+    }
+
+    return numSet;
+  }
+
+  /**
+   * Set each unset state in [begin, end) that has a neighbor at depth to
+   * depth + 1.  Returns the number of states set.  Symmetry-reduced
+   * databases have entries that no scramble indexes to; they're left unset.
+   */
+  size_t ParallelPatternDatabaseIndexer::reverseExpandChunk(
+    PatternDatabase& db, const vector<RubiksCube::MOVE>& moves, uint8_t depth,
+    size_t begin, size_t end) const
+  {
+    RubiksCubeIndexModel cube;
+    size_t               numSet = 0;
+
+    for (size_t ind = begin; ind < end; ++ind)
+    {
+      if (db.getNumMoves(ind) != 0xF)
+        continue;
+
+      db.getCube(ind, cube);
+
+      if (db.getDatabaseIndex(cube) != ind)
+        continue;
+
+      for (RubiksCube::MOVE move : moves)
+      {
+        RubiksCubeIndexModel cubeCopy(cube);
+
+        cubeCopy.applyMove(move);
+
+        if (db.getNumMoves(db.getDatabaseIndex(cubeCopy)) == depth)
+        {
+          if (db.setNumMovesAtomic(ind, depth + 1))
+            ++numSet;
+
+          break;
+        }
+      }
+    }
+
+    return numSet;
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef _BUSYBIN_PARALLEL_PATTERN_DATABASE_INDEXER_H_
+#define _BUSYBIN_PARALLEL_PATTERN_DATABASE_INDEXER_H_
+
+#include "../../Model/RubiksCube.h"
+#include "../../Model/RubiksCubeIndexModel.h"
+#include "../../Model/Goal/DatabaseGoal.h"
+#include "../../Model/MoveStore/MoveStore.h"
+#include "../../Model/PatternDatabase/PatternDatabase.h"
+#include "../../Util/AutoTimer.h"
+#include "../../Util/ThreadPool.h"
+#include <vector>
+using std::vector;
+#include <atomic>
+using std::atomic;
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cstddef>
+using std::size_t;
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * Indexes a pattern database with a breadth-first search that works
+   * directly on the database, which doubles as the search frontier.  To
+   * index depth d+1, every entry at depth d is turned back into a cube (see
+   * PatternDatabase::getCube) and expanded, and each unset child is set to
+   * d+1.  Once more than half the database is set, the search runs
+   * backward instead: each unset entry is checked for a neighbor at depth d.
+   * Either way the database is scanned in parallel chunks on a ThreadPool,
+   * and no memory is needed beyond the database itself.
+   *
+   * The moves in the MoveStore must be closed under inverses (as are the
+   * twists), otherwise the backward search would be wrong.
+   */
+  class ParallelPatternDatabaseIndexer
+  {
+    ThreadPool* pThreadPool;
+
+    size_t expandChunk(PatternDatabase& db, const vector<RubiksCube::MOVE>& moves,
+      uint8_t depth, size_t begin, size_t end) const;
+    size_t reverseExpandChunk(PatternDatabase& db,
+      const vector<RubiksCube::MOVE>& moves, uint8_t depth, size_t begin,
+      size_t end) const;
+
+  public:
+    ParallelPatternDatabaseIndexer(ThreadPool* pThreadPool);
+    void findGoal(DatabaseGoal& goal, RubiksCubeIndexModel& solvedCube,
+      MoveStore& moveStore);
+  };
+}
+
+#endif
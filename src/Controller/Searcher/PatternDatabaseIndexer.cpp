@@ -17,13 +17,14 @@ namespace busybin
   {
     typedef RubiksCube::MOVE MOVE;
 
-    AutoTimer   timer;
-    MovePruner  pruner;
-    unsigned    curDepth = 0;
-    unsigned    indCount = 0;
-    stack<Node> nodeStack;
-    Node        curNode;
-    uint8_t     numMoves = moveStore.getNumMoves();
+    AutoTimer            timer;
+    MovePruner           pruner;
+    unsigned             curDepth = 0;
+    unsigned             indCount = 0;
+    stack<Node>          nodeStack;
+    Node                 curNode;
+    RubiksCubeIndexModel curCube;
+    uint8_t              numMoves = moveStore.getNumMoves();
 
     // Index the root node in the database.
     goal.index(solvedCube, 0);
@@ -41,11 +42,12 @@ namespace busybin
         ++curDepth;
 
         // Push on the root node.
-        nodeStack.push({solvedCube, (MOVE)0xFF, 0});
+        nodeStack.push({PackedCube(solvedCube), (MOVE)0xFF, 0});
       }
 
       curNode = nodeStack.top();
       nodeStack.pop();
+      curNode.cube.unpack(curCube);
 
       for (uint8_t i = 0; i < numMoves; ++i)
       {
@@ -53,14 +55,14 @@ namespace busybin
 
         if (curNode.depth == 0 || !pruner.prune(move, curNode.move))
         {
-          RubiksCubeIndexModel cubeCopy(curNode.cube);
+          RubiksCubeIndexModel cubeCopy(curCube);
           uint8_t              cubeCopyDepth = (uint8_t)(curNode.depth + 1);
 
-          cubeCopy.move(move);
+          cubeCopy.applyMove(move);
 
           // This cube state may have been encountered at an earlier depth, in
           // which case it can be skipped.
-          uint32_t dbInd = goal.getDatabaseIndex(cubeCopy);
+          size_t   dbInd = goal.getDatabaseIndex(cubeCopy);
 
           if (goal.getNumMoves(dbInd) < cubeCopyDepth)
             continue;
@@ -72,7 +74,7 @@ namespace busybin
               ++indCount;
           }
           else
-            nodeStack.push({cubeCopy, move, (uint8_t)cubeCopyDepth});
+            nodeStack.push({PackedCube(cubeCopy), move, (uint8_t)cubeCopyDepth});
         }
       }
     }
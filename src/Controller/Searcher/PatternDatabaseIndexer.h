@@ -4,6 +4,7 @@
 #include "MovePruner.h"
 #include "../../Model/RubiksCube.h"
 #include "../../Model/RubiksCubeIndexModel.h"
+#include "../../Model/PackedCube.h"
 #include "../../Model/Goal/DatabaseGoal.h"
 #include "../../Model/MoveStore/MoveStore.h"
 #include "../../Util/AutoTimer.h"
@@ -21,9 +22,10 @@ namespace busybin
    */
   class PatternDatabaseIndexer
   {
+    // The cube is packed, since the stack holds many nodes per depth.
     struct Node
     {
-      RubiksCubeIndexModel cube;
+      PackedCube cube;
       RubiksCube::MOVE move;
       uint8_t depth;
     };
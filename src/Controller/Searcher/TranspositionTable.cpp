@@ -0,0 +1,251 @@
+#include "TranspositionTable.h"
+
+namespace busybin
+{
+  /**
+   * Allocate the table.
+   * @param numMegabytes The table size.  It's rounded down to a power of 2
+   * buckets.
+   */
+  TranspositionTable::TranspositionTable(size_t numMegabytes) :
+    nextEpoch(1),
+    heldEpochs(65536, false),
+    heldAtClear(65536, false),
+    numHeldEpochs(0),
+    probes(0),
+    hits(0),
+    pruned(0),
+    stores(0),
+    replacements(0)
+  {
+    size_t numBuckets = 1;
+    size_t maxBuckets = numMegabytes * 1048576 / (BUCKET_SIZE * sizeof(uint64_t));
+
+    if (maxBuckets == 0)
+      throw RubiksCubeException("TranspositionTable: the table needs at least one bucket.");
+
+    while (numBuckets * 2 <= maxBuckets)
+      numBuckets *= 2;
+
+    this->entries.assign(numBuckets * BUCKET_SIZE, 0);
+    this->bucketMask = numBuckets - 1;
+  }
+
+  /**
+   * The key is the top 40 bits of the hash.  The bucket comes from the low
+   * bits.
+   */
+  uint64_t TranspositionTable::getKey(uint64_t hash)
+  {
+    return hash >> 24;
+  }
+
+  /**
+   * Pack an entry: key (40 bits), depth (8 bits), epoch (16 bits).
+   */
+  uint64_t TranspositionTable::makeEntry(uint64_t key, uint8_t depth,
+    uint16_t epoch)
+  {
+    return (key << 24) | ((uint64_t)depth << 16) | epoch;
+  }
+
+  uint8_t TranspositionTable::getDepth(uint64_t entry)
+  {
+    return (uint8_t)(entry >> 16);
+  }
+
+  uint16_t TranspositionTable::getEpoch(uint64_t entry)
+  {
+    return (uint16_t)entry;
+  }
+
+  /**
+   * Get an epoch for a new IDA* iteration.  The epoch is held until it's
+   * released with releaseEpoch.  Epoch 0 marks an empty entry, so it's
+   * skipped when the counter wraps.  At that point every epoch has been
+   * used, so the table is cleared before any is handed out again; otherwise
+   * stale entries from old searches would match the new iterations.  Epochs
+   * that are held during the clear keep storing entries afterward, so they
+   * are skipped until the next clear.
+   */
+  uint16_t TranspositionTable::newEpoch()
+  {
+    lock_guard<mutex> lock(this->epochMutex);
+
+    if (this->numHeldEpochs >= 65534)
+      throw RubiksCubeException("TranspositionTable: too many iterations hold an epoch.");
+
+    while (this->nextEpoch == 0 || this->heldAtClear[this->nextEpoch])
+    {
+      if (this->nextEpoch == 0)
+      {
+        for (uint64_t& entry : this->entries)
+          __atomic_store_n(&entry, 0, __ATOMIC_RELAXED);
+
+        this->heldAtClear = this->heldEpochs;
+      }
+
+      ++this->nextEpoch;
+    }
+
+    this->heldEpochs[this->nextEpoch] = true;
+    ++this->numHeldEpochs;
+
+    return this->nextEpoch++;
+  }
+
+  /**
+   * Release an epoch when its iteration is done with the table.  The epoch's
+   * entries stay in the table until they're replaced or the epoch wraps.
+   * @param epoch An epoch from newEpoch.
+   */
+  void TranspositionTable::releaseEpoch(uint16_t epoch)
+  {
+    lock_guard<mutex> lock(this->epochMutex);
+
+    if (epoch == 0 || !this->heldEpochs[epoch])
+      throw RubiksCubeException("TranspositionTable: released an epoch that isn't held.");
+
+    this->heldEpochs[epoch] = false;
+    --this->numHeldEpochs;
+  }
+
+  /**
+   * Check if a state was already reached at depth or shallower in this
+   * epoch.  If so, it can be pruned.
+   * @param hash The state's hash.
+   * @param depth The depth at which the state was reached.
+   * @param epoch The epoch of the current iteration.
+   * @param stats Local statistics, which are updated.
+   */
+  bool TranspositionTable::isDuplicate(uint64_t hash, uint8_t depth,
+    uint16_t epoch, Stats& stats) const
+  {
+    const uint64_t* pBucket = &this->entries[(hash & this->bucketMask) * BUCKET_SIZE];
+    uint64_t        key     = TranspositionTable::getKey(hash);
+
+    ++stats.probes;
+
+    for (unsigned i = 0; i < BUCKET_SIZE; ++i)
+    {
+      uint64_t entry = __atomic_load_n(&pBucket[i], __ATOMIC_RELAXED);
+
+      if (entry >> 24 == key && TranspositionTable::getEpoch(entry) == epoch)
+      {
+        ++stats.hits;
+
+        if (TranspositionTable::getDepth(entry) <= depth)
+        {
+          ++stats.pruned;
+          return true;
+        }
+
+        return false;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * Record that a state was reached at depth in this epoch.  An existing
+   * entry for the state is updated, otherwise a stale or the deepest entry
+   * in the bucket is replaced.
+   * @param hash The state's hash.
+   * @param depth The depth at which the state was reached.
+   * @param epoch The epoch of the current iteration.
+   * @param stats Local statistics, which are updated.
+   */
+  void TranspositionTable::store(uint64_t hash, uint8_t depth, uint16_t epoch,
+    Stats& stats)
+  {
+    uint64_t* pBucket = &this->entries[(hash & this->bucketMask) * BUCKET_SIZE];
+    uint64_t  key     = TranspositionTable::getKey(hash);
+    unsigned  victim  = 0;
+    int       victimScore = -1;
+
+    for (unsigned i = 0; i < BUCKET_SIZE; ++i)
+    {
+      uint64_t entry = __atomic_load_n(&pBucket[i], __ATOMIC_RELAXED);
+      int      score;
+
+      if (TranspositionTable::getEpoch(entry) != epoch)
+      {
+        // Empty or from another iteration: free to take.
+        score = 0x100;
+      }
+      else if (entry >> 24 == key)
+      {
+        // Same state.  Keep the shallowest depth.
+        if (depth < TranspositionTable::getDepth(entry))
+        {
+          __atomic_store_n(&pBucket[i],
+            TranspositionTable::makeEntry(key, depth, epoch), __ATOMIC_RELAXED);
+        }
+
+        return;
+      }
+      else
+        score = TranspositionTable::getDepth(entry);
+
+      if (score > victimScore)
+      {
+        victim      = i;
+        victimScore = score;
+      }
+    }
+
+    // Only replace a live entry with a shallower one.
+    if (victimScore != 0x100 && victimScore <= depth)
+      return;
+
+    if (victimScore != 0x100)
+      ++stats.replacements;
+
+    ++stats.stores;
+
+    __atomic_store_n(&pBucket[victim],
+      TranspositionTable::makeEntry(key, depth, epoch), __ATOMIC_RELAXED);
+  }
+
+  /**
+   * Add a searcher's local statistics to the totals.
+   */
+  void TranspositionTable::addStats(const Stats& stats)
+  {
+    this->probes       += stats.probes;
+    this->hits         += stats.hits;
+    this->pruned       += stats.pruned;
+    this->stores       += stats.stores;
+    this->replacements += stats.replacements;
+  }
+
+  /**
+   * Get the totals since the last reset.
+   */
+  TranspositionTable::Stats TranspositionTable::getStats() const
+  {
+    return {this->probes, this->hits, this->pruned, this->stores,
+      this->replacements};
+  }
+
+  /**
+   * Reset the statistics.
+   */
+  void TranspositionTable::resetStats()
+  {
+    this->probes       = 0;
+    this->hits         = 0;
+    this->pruned       = 0;
+    this->stores       = 0;
+    this->replacements = 0;
+  }
+
+  /**
+   * Get the number of entries (the table holds this many states).
+   */
+  size_t TranspositionTable::getNumEntries() const
+  {
+    return this->entries.size();
+  }
+}
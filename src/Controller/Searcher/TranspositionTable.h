@@ -0,0 +1,99 @@
+#ifndef _BUSYBIN_TRANSPOSITION_TABLE_H_
+#define _BUSYBIN_TRANSPOSITION_TABLE_H_
+
+#include "../../Util/RubiksCubeException.h"
+#include <vector>
+using std::vector;
+#include <atomic>
+using std::atomic;
+#include <mutex>
+using std::mutex;
+using std::lock_guard;
+#include <cstddef>
+using std::size_t;
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * A fixed-size table of cube states seen during an IDA* iteration, used to
+   * prune duplicates: a node can be skipped if the same state was already
+   * reached at the same or a shallower depth in the same iteration, because
+   * its subtree is (or is being) searched with at least as many moves to
+   * spare.
+   *
+   * Entries are keyed by a 64-bit state hash (RubiksCubeIndexModel::getHash).
+   * Each is one 64-bit word (40 key bits, the depth, and a 16-bit epoch), so
+   * the table is read and written with plain atomic loads and stores and no
+   * locks.  Concurrent writers can lose an update, which only costs a missed
+   * prune.  Every iteration (of every search sharing the table) gets its own
+   * epoch, and entries from other epochs never match, so the table doesn't
+   * have to be cleared between iterations.  An iteration holds its epoch
+   * until it calls releaseEpoch.  The table is cleared when the epoch wraps,
+   * so that entries from 65535 iterations ago can't match again, and epochs
+   * that are still held then aren't handed out until the next wrap: a long
+   * iteration never shares its epoch with a newer one, even across many
+   * short solves.  At most 65534 iterations can hold an epoch at once.
+   *
+   * The entries are in buckets of 4 (32 bytes, half a cache line).  When a
+   * bucket is full, an entry from another epoch is replaced first, otherwise
+   * the deepest entry (it prunes the smallest subtree).
+   *
+   * A false key match prunes a state that wasn't seen.  With 40 key bits on
+   * top of the bucket bits that's rare enough to ignore, but a search that
+   * uses the table is not strictly guaranteed to be optimal.
+   */
+  class TranspositionTable
+  {
+  public:
+    struct Stats
+    {
+      unsigned long long probes;
+      unsigned long long hits;
+      unsigned long long pruned;
+      unsigned long long stores;
+      unsigned long long replacements;
+    };
+
+  private:
+    static const unsigned BUCKET_SIZE = 4;
+
+    vector<uint64_t> entries;
+    size_t           bucketMask;
+    uint16_t         nextEpoch;
+    vector<bool>     heldEpochs;
+    vector<bool>     heldAtClear;
+    size_t           numHeldEpochs;
+    mutex            epochMutex;
+
+    atomic<unsigned long long> probes;
+    atomic<unsigned long long> hits;
+    atomic<unsigned long long> pruned;
+    atomic<unsigned long long> stores;
+    atomic<unsigned long long> replacements;
+
+    TranspositionTable(const TranspositionTable&);
+    TranspositionTable& operator=(const TranspositionTable&);
+
+    static uint64_t getKey(uint64_t hash);
+    static uint64_t makeEntry(uint64_t key, uint8_t depth, uint16_t epoch);
+    static uint8_t getDepth(uint64_t entry);
+    static uint16_t getEpoch(uint64_t entry);
+
+  public:
+    TranspositionTable(size_t numMegabytes);
+
+    uint16_t newEpoch();
+    void releaseEpoch(uint16_t epoch);
+    bool isDuplicate(uint64_t hash, uint8_t depth, uint16_t epoch,
+      Stats& stats) const;
+    void store(uint64_t hash, uint8_t depth, uint16_t epoch, Stats& stats);
+
+    void addStats(const Stats& stats);
+    Stats getStats() const;
+    void resetStats();
+    size_t getNumEntries() const;
+  };
+}
+
+#endif
@@ -0,0 +1,280 @@
+#include "TwoPhaseCubeSearcher.h"
+
+namespace busybin
+{
+  /**
+   * Init.  The tables are built on first use.  By default the search stops
+   * at the first solution of 20 moves or fewer, or after 100ms.
+   */
+  TwoPhaseCubeSearcher::TwoPhaseCubeSearcher() :
+    tables(TwoPhaseTables::getInstance()),
+    numNodes(0),
+    verbose(true),
+    pHalt(nullptr),
+    targetLength(20),
+    maxSeconds(0.1),
+    bestLength(0xFF),
+    stopped(false),
+    timer(false)
+  {
+    for (unsigned last = 0; last < 18; ++last)
+    {
+      for (unsigned move = 0; move < 18; ++move)
+      {
+        this->pruneAfter[last][move] = this->pruner.prune(
+          (RubiksCube::MOVE)move, (RubiksCube::MOVE)last);
+      }
+    }
+
+    this->pruneAfter[NO_MOVE].fill(false);
+
+    this->isPhase2Move.fill(false);
+
+    for (unsigned m = 0; m < TwoPhaseTables::NUM_PHASE2_MOVES; ++m)
+      this->isPhase2Move[(unsigned)this->tables.getPhase2Move(m)] = true;
+  }
+
+  /**
+   * Get the number of nodes (both phases) expanded by the last search.
+   */
+  unsigned long long TwoPhaseCubeSearcher::getNumNodes() const
+  {
+    return this->numNodes;
+  }
+
+  /**
+   * Print each improved solution (on by default).
+   */
+  void TwoPhaseCubeSearcher::setVerbose(bool verbose)
+  {
+    this->verbose = verbose;
+  }
+
+  /**
+   * Set a flag that aborts findSolution when it's set (e.g. from another
+   * thread).  The best solution found so far is returned, which is empty if
+   * there isn't one yet.
+   */
+  void TwoPhaseCubeSearcher::setHaltFlag(const atomic_bool* pHalt)
+  {
+    this->pHalt = pHalt;
+  }
+
+  /**
+   * Stop as soon as a solution of at most this many moves is found (0 to
+   * search until the time is up).
+   */
+  void TwoPhaseCubeSearcher::setTargetLength(uint8_t targetLength)
+  {
+    this->targetLength = targetLength;
+  }
+
+  /**
+   * Stop improving the solution after this many seconds.  The search always
+   * runs until it has one solution.
+   */
+  void TwoPhaseCubeSearcher::setMaxSeconds(double maxSeconds)
+  {
+    this->maxSeconds = maxSeconds;
+  }
+
+  /**
+   * Find a solution of at most the target length, or the shortest one found
+   * within the time limit.
+   * @param cube The scrambled cube.
+   */
+  vector<RubiksCube::MOVE> TwoPhaseCubeSearcher::findSolution(
+    const RubiksCubeIndexModel& cube)
+  {
+    uint16_t co    = this->tables.getCornerOrientation(cube);
+    uint16_t eo    = this->tables.getEdgeOrientation(cube);
+    uint16_t slice = this->tables.getSlicePosition(cube);
+
+    this->root       = cube;
+    this->numNodes   = 0;
+    this->bestLength = 0xFF;
+    this->stopped    = false;
+    this->bestMoves.clear();
+    this->timer.restart();
+
+    for (uint8_t depth = this->tables.getPhase1Moves(co, eo, slice);
+      depth <= MAX_PHASE1_MOVES && depth < this->bestLength && !this->stopped;
+      ++depth)
+    {
+      this->searchPhase1(co, eo, slice, 0, depth);
+    }
+
+    if (this->verbose)
+    {
+      cout << "Two-phase: Finished in " << this->timer.getElapsedSeconds()
+           << "s.  Nodes: " << this->numNodes << endl;
+    }
+
+    return this->bestMoves;
+  }
+
+  /**
+   * Search for phase 1 solutions of exactly depth + remaining moves, and
+   * finish each one with phase 2.
+   * @param co The corner orientation coordinate.
+   * @param eo The edge orientation coordinate.
+   * @param slice The slice position coordinate.
+   * @param depth The number of phase 1 moves so far.
+   * @param remaining The number of phase 1 moves left.
+   */
+  void TwoPhaseCubeSearcher::searchPhase1(uint16_t co, uint16_t eo,
+    uint16_t slice, uint8_t depth, uint8_t remaining)
+  {
+    if ((++this->numNodes & 0xFFF) == 0)
+      this->checkStop();
+
+    if (this->stopped)
+      return;
+
+    if (remaining == 0)
+    {
+      // A phase 1 solution that ends with a G2 twist was tried at a shorter
+      // depth.
+      if (this->tables.isPhase1Solved(co, eo, slice) && (depth == 0 ||
+        !this->isPhase2Move[(unsigned)this->phase1Moves[depth - 1]]))
+      {
+        this->startPhase2(depth);
+      }
+
+      return;
+    }
+
+    if (this->tables.getPhase1Moves(co, eo, slice) > remaining)
+      return;
+
+    unsigned lastMove = depth == 0 ? (unsigned)NO_MOVE :
+      (unsigned)this->phase1Moves[depth - 1];
+
+    for (unsigned m = 0; m < 18 && !this->stopped; ++m)
+    {
+      if (this->pruneAfter[lastMove][m])
+        continue;
+
+      RubiksCube::MOVE move = (RubiksCube::MOVE)m;
+
+      this->phase1Moves[depth] = move;
+
+      this->searchPhase1(
+        this->tables.moveCornerOrientation(co, move),
+        this->tables.moveEdgeOrientation(eo, move),
+        this->tables.moveSlicePosition(slice, move),
+        depth + 1, remaining - 1);
+    }
+  }
+
+  /**
+   * Solve the cube in G2 that phase 1 reached, with fewer moves than the best
+   * solution so far.
+   * @param phase1Length The number of phase 1 moves.
+   */
+  void TwoPhaseCubeSearcher::startPhase2(uint8_t phase1Length)
+  {
+    // The phase 2 coordinates are only defined in G2, so they're read from a
+    // cube rather than followed through phase 1.
+    RubiksCubeIndexModel cube(this->root);
+
+    for (uint8_t i = 0; i < phase1Length; ++i)
+      cube.move(this->phase1Moves[i]);
+
+    uint16_t cp        = this->tables.getCornerPermutation(cube);
+    uint16_t ep        = this->tables.getUDEdgePermutation(cube);
+    uint8_t  sp        = this->tables.getSlicePermutation(cube);
+    unsigned lastMove  = phase1Length == 0 ? (unsigned)NO_MOVE :
+      (unsigned)this->phase1Moves[phase1Length - 1];
+    int      maxLength = (int)this->bestLength - 1 - phase1Length;
+
+    if (maxLength > MAX_PHASE2_MOVES)
+      maxLength = MAX_PHASE2_MOVES;
+
+    for (int bound = this->tables.getPhase2Moves(cp, ep, sp);
+      bound <= maxLength && !this->stopped; ++bound)
+    {
+      if (this->searchPhase2(cp, ep, sp, 0, bound, lastMove))
+      {
+        this->bestLength = phase1Length + bound;
+        this->bestMoves.assign(this->phase1Moves.begin(),
+          this->phase1Moves.begin() + phase1Length);
+        this->bestMoves.insert(this->bestMoves.end(), this->phase2Moves.begin(),
+          this->phase2Moves.begin() + bound);
+
+        if (this->verbose)
+        {
+          cout << "Two-phase: Found a " << (unsigned)this->bestLength
+               << "-move solution (" << (unsigned)phase1Length << " + "
+               << bound << ") in " << this->timer.getElapsedSeconds() << "s."
+               << endl;
+        }
+
+        this->checkStop();
+
+        return;
+      }
+    }
+  }
+
+  /**
+   * Search for a phase 2 solution of exactly depth + remaining moves.
+   * @param cp The corner permutation coordinate.
+   * @param ep The U/D edge permutation coordinate.
+   * @param sp The slice permutation coordinate.
+   * @param depth The number of phase 2 moves so far.
+   * @param remaining The number of phase 2 moves left.
+   * @param lastMove The last move (phase 1 or 2), or NO_MOVE.
+   */
+  bool TwoPhaseCubeSearcher::searchPhase2(uint16_t cp, uint16_t ep,
+    uint8_t sp, uint8_t depth, uint8_t remaining, unsigned lastMove)
+  {
+    if ((++this->numNodes & 0xFFF) == 0)
+      this->checkStop();
+
+    if (this->stopped)
+      return false;
+
+    if (remaining == 0)
+      return cp == 0 && ep == 0 && sp == 0;
+
+    if (this->tables.getPhase2Moves(cp, ep, sp) > remaining)
+      return false;
+
+    for (unsigned m = 0; m < TwoPhaseTables::NUM_PHASE2_MOVES; ++m)
+    {
+      RubiksCube::MOVE move = this->tables.getPhase2Move(m);
+
+      if (this->pruneAfter[lastMove][(unsigned)move])
+        continue;
+
+      this->phase2Moves[depth] = move;
+
+      if (this->searchPhase2(
+        this->tables.moveCornerPermutation(cp, m),
+        this->tables.moveUDEdgePermutation(ep, m),
+        this->tables.moveSlicePermutation(sp, m),
+        depth + 1, remaining - 1, (unsigned)move))
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * Set the stopped flag if the search was halted, or if there's a solution
+   * and it's short enough or the time is up.
+   */
+  void TwoPhaseCubeSearcher::checkStop()
+  {
+    if (this->pHalt && *this->pHalt)
+      this->stopped = true;
+    else if (!this->bestMoves.empty() || this->bestLength == 0)
+    {
+      this->stopped = this->bestLength <= this->targetLength ||
+        this->timer.getElapsedSeconds() >= this->maxSeconds;
+    }
+  }
+}
@@ -0,0 +1,89 @@
+#ifndef _BUSYBIN_TWO_PHASE_CUBE_SEARCHER_H_
+#define _BUSYBIN_TWO_PHASE_CUBE_SEARCHER_H_
+
+#include "MovePruner.h"
+#include "../../Model/RubiksCube.h"
+#include "../../Model/RubiksCubeIndexModel.h"
+#include "../../Model/Coordinate/TwoPhaseTables.h"
+#include "../../Util/Timer.h"
+#include <vector>
+using std::vector;
+#include <array>
+using std::array;
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <atomic>
+using std::atomic_bool;
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * Two-phase (Kociemba) searcher.  Phase 1 is an IDA* search over the
+   * TwoPhaseTables phase 1 coordinates that takes the cube into G2 with all
+   * 18 twists, and every phase 1 solution is finished by an IDA* search over
+   * the phase 2 coordinates with the G2 twists.  Neither phase keeps a cube;
+   * only the coordinates are moved.
+   *
+   * The first solution usually takes a few milliseconds.  Phase 1 solutions
+   * of increasing length are then tried, each phase 2 search bounded by the
+   * best total so far, until the solution is at most the target length or
+   * the time is up.  Phase 1 solutions that end with a G2 twist are skipped,
+   * because they were already tried as a shorter phase 1 solution.
+   */
+  class TwoPhaseCubeSearcher
+  {
+    typedef array<RubiksCube::MOVE, 32> moveList_t;
+
+    // Phase 1 needs at most 12 moves and phase 2 at most 18.  Longer phase 1
+    // solutions are only tried because they can shorten phase 2.
+    enum { MAX_PHASE1_MOVES = 20 };
+    enum { MAX_PHASE2_MOVES = 18 };
+
+    // The row of pruneAfter used when there's no previous move.
+    enum { NO_MOVE = 18 };
+
+    const TwoPhaseTables& tables;
+    MovePruner            pruner;
+
+    // pruneAfter[lastMove][move] is set when move can't follow lastMove.
+    array<array<bool, 18>, 19> pruneAfter;
+
+    // Set for the G2 twists.
+    array<bool, 18> isPhase2Move;
+
+    unsigned long long numNodes;
+    bool               verbose;
+    const atomic_bool* pHalt;
+    uint8_t            targetLength;
+    double             maxSeconds;
+
+    // The state of the current search.
+    RubiksCubeIndexModel     root;
+    moveList_t               phase1Moves;
+    moveList_t               phase2Moves;
+    vector<RubiksCube::MOVE> bestMoves;
+    uint8_t                  bestLength;
+    bool                     stopped;
+    Timer                    timer;
+
+    void searchPhase1(uint16_t co, uint16_t eo, uint16_t slice,
+      uint8_t depth, uint8_t remaining);
+    void startPhase2(uint8_t phase1Length);
+    bool searchPhase2(uint16_t cp, uint16_t ep, uint8_t sp, uint8_t depth,
+      uint8_t remaining, unsigned lastMove);
+    void checkStop();
+
+  public:
+    TwoPhaseCubeSearcher();
+    vector<RubiksCube::MOVE> findSolution(const RubiksCubeIndexModel& cube);
+    unsigned long long getNumNodes() const;
+    void setVerbose(bool verbose);
+    void setHaltFlag(const atomic_bool* pHalt);
+    void setTargetLength(uint8_t targetLength);
+    void setMaxSeconds(double maxSeconds);
+  };
+}
+
+#endif
@@ -0,0 +1,632 @@
+#include "SolverServer.h"
+#include "../../Util/StringUtils.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace busybin
+{
+  namespace
+  {
+    // How often timeouts are checked.
+    const int POLL_INTERVAL_MS = 20;
+
+    // Lines longer than this are dropped (and the connection closed).
+    const size_t MAX_LINE_LENGTH = 4096;
+
+    string socketError(const string& what)
+    {
+      return "SolverServer: " + what + ": " + strerror(errno);
+    }
+  }
+
+  /**
+   * Init.  The solvers must be initialized, and they must stay in scope.
+   * @param pKorfSolver The optimal solver.
+   * @param pThistlethwaiteSolver The fast solver.
+   * @param pTwoPhaseSolver The near-optimal solver.
+   * @param pAnytimeSolver The solver that returns the best solution found by
+   * the timeout (see AnytimeCubeSolver).
+   * @param pThreadPool The pool that solves are run on.
+   * @param maxOptimalSolves The number of optimal solves that can run at
+   * once.  Should be less than the number of pool threads.
+   */
+  SolverServer::SolverServer(const CubeSolver* pKorfSolver,
+    const CubeSolver* pThistlethwaiteSolver, const CubeSolver* pTwoPhaseSolver,
+    const CubeSolver* pAnytimeSolver, ThreadPool* pThreadPool,
+    unsigned maxOptimalSolves) :
+    pKorfSolver(pKorfSolver),
+    pThistlethwaiteSolver(pThistlethwaiteSolver),
+    pTwoPhaseSolver(pTwoPhaseSolver),
+    pAnytimeSolver(pAnytimeSolver),
+    pThreadPool(pThreadPool),
+    maxOptimalSolves(maxOptimalSolves ? maxOptimalSolves : 1),
+    listenFd(-1),
+    numOptimalSolves(0)
+  {
+  }
+
+  /**
+   * Close the listening socket.
+   */
+  SolverServer::~SolverServer()
+  {
+    if (this->listenFd != -1)
+      ::close(this->listenFd);
+  }
+
+  /**
+   * Listen on a Unix domain socket.  An existing socket file is replaced.
+   * @param path The path of the socket file.
+   */
+  void SolverServer::listenUnix(const string& path)
+  {
+    sockaddr_un addr;
+
+    if (path.size() >= sizeof(addr.sun_path))
+      throw RubiksCubeException("SolverServer: socket path is too long.");
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    this->listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (this->listenFd == -1)
+      throw RubiksCubeException(socketError("socket"));
+
+    unlink(path.c_str());
+
+    if (bind(this->listenFd, (sockaddr*)&addr, sizeof(addr)) == -1)
+      throw RubiksCubeException(socketError("bind " + path));
+
+    if (listen(this->listenFd, SOMAXCONN) == -1)
+      throw RubiksCubeException(socketError("listen"));
+
+    cout << "SolverServer: listening on " << path << '.' << endl;
+  }
+
+  /**
+   * Listen on a TCP port on the loopback interface.
+   * @param port The port number.
+   */
+  void SolverServer::listenTcp(uint16_t port)
+  {
+    sockaddr_in addr;
+    int         reuse = 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    this->listenFd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (this->listenFd == -1)
+      throw RubiksCubeException(socketError("socket"));
+
+    setsockopt(this->listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if (bind(this->listenFd, (sockaddr*)&addr, sizeof(addr)) == -1)
+      throw RubiksCubeException(socketError("bind"));
+
+    if (listen(this->listenFd, SOMAXCONN) == -1)
+      throw RubiksCubeException(socketError("listen"));
+
+    cout << "SolverServer: listening on 127.0.0.1:" << port << '.' << endl;
+  }
+
+  /**
+   * Serve requests forever.  All the socket I/O happens on this thread; the
+   * solves run on the pool and write their own responses.
+   */
+  void SolverServer::run()
+  {
+    if (this->listenFd == -1)
+      throw RubiksCubeException("SolverServer: not listening.");
+
+    while (true)
+    {
+      vector<pollfd> fds;
+
+      fds.push_back({this->listenFd, POLLIN, 0});
+
+      for (const shared_ptr<Connection>& pConnection : this->connections)
+        fds.push_back({pConnection->fd, POLLIN, 0});
+
+      if (poll(fds.data(), fds.size(), POLL_INTERVAL_MS) == -1 && errno != EINTR)
+        throw RubiksCubeException(socketError("poll"));
+
+      // Connections are closed after the loop so that the indexes line up.
+      vector<shared_ptr<Connection> > closed;
+
+      for (size_t i = 1; i < fds.size(); ++i)
+      {
+        if (fds[i].revents && !this->readConnection(this->connections[i - 1]))
+          closed.push_back(this->connections[i - 1]);
+      }
+
+      for (shared_ptr<Connection>& pConnection : closed)
+        this->closeConnection(pConnection);
+
+      if (fds[0].revents & POLLIN)
+        this->acceptConnection();
+
+      this->checkTimeouts();
+    }
+  }
+
+  /**
+   * Accept a new client.
+   */
+  void SolverServer::acceptConnection()
+  {
+    int fd = accept(this->listenFd, nullptr, nullptr);
+
+    if (fd == -1)
+      return;
+
+    shared_ptr<Connection> pConnection = make_shared<Connection>();
+
+    pConnection->fd = fd;
+    this->connections.push_back(pConnection);
+  }
+
+  /**
+   * Read from a client and handle each complete line.  Returns false if the
+   * connection should be closed.
+   */
+  bool SolverServer::readConnection(shared_ptr<Connection> pConnection)
+  {
+    char    buffer[4096];
+    ssize_t numRead = recv(pConnection->fd, buffer, sizeof(buffer), 0);
+
+    if (numRead <= 0)
+      return numRead == -1 && (errno == EINTR || errno == EAGAIN);
+
+    pConnection->inBuffer.append(buffer, numRead);
+
+    string::size_type pos;
+
+    while ((pos = pConnection->inBuffer.find('\n')) != string::npos)
+    {
+      string line = pConnection->inBuffer.substr(0, pos);
+
+      pConnection->inBuffer.erase(0, pos + 1);
+
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+
+      this->handleLine(pConnection, line);
+    }
+
+    return pConnection->inBuffer.size() <= MAX_LINE_LENGTH;
+  }
+
+  /**
+   * Close a client connection.  Its outstanding requests are halted without
+   * a response.
+   */
+  void SolverServer::closeConnection(shared_ptr<Connection> pConnection)
+  {
+    {
+      lock_guard<mutex> requestLock(this->requestMutex);
+
+      map<string, requestPtr_t>& connRequests = this->requests[pConnection.get()];
+
+      for (auto& idRequest : connRequests)
+      {
+        idRequest.second->status = STATUS::CANCELLED;
+        idRequest.second->halt   = true;
+      }
+
+      this->requests.erase(pConnection.get());
+    }
+
+    {
+      lock_guard<mutex> writeLock(pConnection->writeMutex);
+
+      ::close(pConnection->fd);
+      pConnection->fd = -1;
+    }
+
+    for (auto it = this->connections.begin(); it != this->connections.end(); ++it)
+    {
+      if (*it == pConnection)
+      {
+        this->connections.erase(it);
+        break;
+      }
+    }
+  }
+
+  /**
+   * Handle one request line.
+   */
+  void SolverServer::handleLine(shared_ptr<Connection> pConnection,
+    const string& line)
+  {
+    istringstream args(line);
+    string        command;
+
+    if (!(args >> command))
+      return;
+
+    if (command == "SOLVE")
+      this->handleSolve(pConnection, args);
+    else if (command == "CANCEL")
+    {
+      string id;
+
+      args >> id;
+      this->handleCancel(pConnection, id);
+    }
+    else if (command == "PING")
+      this->send(*pConnection, "{\"status\":\"pong\"}");
+    else
+    {
+      this->send(*pConnection, "{\"status\":\"error\",\"error\":\"Unknown command " +
+        StringUtils::JsonEscape(command) + ".\"}");
+    }
+  }
+
+  /**
+   * Queue a solve: SOLVE <id> <korf|thistlethwaite|twophase|anytime> <timeout ms> <scramble>.
+   */
+  void SolverServer::handleSolve(shared_ptr<Connection> pConnection,
+    istringstream& args)
+  {
+    requestPtr_t pRequest = make_shared<Request>();
+    string       method;
+    double       timeoutMs = 0;
+    string       scramble;
+
+    if (!(args >> pRequest->id >> method >> timeoutMs))
+    {
+      this->send(*pConnection, this->jsonResponse(pRequest->id, "error") +
+        ",\"error\":\"Expected SOLVE <id> <korf|thistlethwaite|twophase|anytime> <timeout ms> <scramble>.\"}");
+      return;
+    }
+
+    getline(args, scramble);
+
+    vector<RubiksCube::MOVE> moves;
+
+    if (!RubiksCube::parseMoves(scramble, moves))
+    {
+      this->send(*pConnection, this->jsonResponse(pRequest->id, "error") +
+        ",\"error\":\"Invalid move.\"}");
+      return;
+    }
+
+    if (method == "korf")
+    {
+      pRequest->pSolver = this->pKorfSolver;
+      pRequest->optimal = true;
+    }
+    else if (method == "thistlethwaite")
+    {
+      pRequest->pSolver = this->pThistlethwaiteSolver;
+      pRequest->optimal = false;
+    }
+    else if (method == "twophase")
+    {
+      pRequest->pSolver = this->pTwoPhaseSolver;
+      pRequest->optimal = false;
+    }
+    else if (method == "anytime")
+    {
+      pRequest->pSolver = this->pAnytimeSolver;
+      pRequest->optimal = true;
+    }
+    else
+    {
+      this->send(*pConnection, this->jsonResponse(pRequest->id, "error") +
+        ",\"error\":\"Unknown method.\"}");
+      return;
+    }
+
+    for (RubiksCube::MOVE move : moves)
+      pRequest->cube.move(move);
+
+    pRequest->pConnection    = pConnection;
+    pRequest->timeoutSeconds = timeoutMs / 1000;
+
+    {
+      lock_guard<mutex> requestLock(this->requestMutex);
+
+      map<string, requestPtr_t>& connRequests = this->requests[pConnection.get()];
+
+      if (connRequests.count(pRequest->id))
+      {
+        this->send(*pConnection, this->jsonResponse(pRequest->id, "error") +
+          ",\"error\":\"Duplicate id.\"}");
+        return;
+      }
+
+      connRequests[pRequest->id] = pRequest;
+
+      if (pRequest->optimal && this->numOptimalSolves == this->maxOptimalSolves)
+      {
+        this->optimalQueue.push_back(pRequest);
+        return;
+      }
+
+      if (pRequest->optimal)
+        ++this->numOptimalSolves;
+    }
+
+    this->dispatch(pRequest);
+  }
+
+  /**
+   * Cancel a request.  A request that's waiting for an optimal slot is
+   * answered right away; one that's dispatched or running is answered by
+   * runRequest, so each request gets a single response.
+   */
+  void SolverServer::handleCancel(shared_ptr<Connection> pConnection,
+    const string& id)
+  {
+    requestPtr_t pRequest;
+
+    {
+      lock_guard<mutex> requestLock(this->requestMutex);
+
+      map<string, requestPtr_t>& connRequests = this->requests[pConnection.get()];
+      auto                       it           = connRequests.find(id);
+
+      if (it == connRequests.end())
+        return;
+
+      pRequest = it->second;
+
+      STATUS expected = STATUS::RUNNING;
+
+      if (pRequest->status.compare_exchange_strong(expected, STATUS::CANCELLED))
+      {
+        pRequest->halt = true;
+        return;
+      }
+
+      if (pRequest->status != STATUS::QUEUED)
+        return;
+
+      // Still waiting for a slot?
+      bool waiting = false;
+
+      for (auto qIt = this->optimalQueue.begin(); qIt != this->optimalQueue.end(); ++qIt)
+      {
+        if (*qIt == pRequest)
+        {
+          this->optimalQueue.erase(qIt);
+          waiting = true;
+          break;
+        }
+      }
+
+      if (!waiting)
+      {
+        // Dispatched but not started.  runRequest sees the cancellation and
+        // answers, unless the search starts first, in which case it's
+        // halted like a running one.
+        expected = STATUS::QUEUED;
+
+        if (!pRequest->status.compare_exchange_strong(expected, STATUS::CANCELLED))
+        {
+          expected = STATUS::RUNNING;
+          pRequest->status.compare_exchange_strong(expected, STATUS::CANCELLED);
+        }
+
+        pRequest->halt = true;
+        return;
+      }
+
+      pRequest->status = STATUS::CANCELLED;
+    }
+
+    this->finishRequest(pRequest, this->jsonResponse(id, "cancelled") + '}');
+  }
+
+  /**
+   * Run a request on the pool.
+   */
+  void SolverServer::dispatch(requestPtr_t pRequest)
+  {
+    this->pThreadPool->addJob([this, pRequest]() { this->runRequest(pRequest); });
+  }
+
+  /**
+   * Solve a request (on a pool thread) and send the response.
+   */
+  void SolverServer::runRequest(requestPtr_t pRequest)
+  {
+    STATUS expected = STATUS::QUEUED;
+
+    if (pRequest->status.compare_exchange_strong(expected, STATUS::RUNNING))
+    {
+      try
+      {
+        CubeSolver::Solution solution =
+          pRequest->pSolver->findSolution(pRequest->cube, &pRequest->halt);
+
+        // An anytime solve that times out still has a solution.
+        if (!solution.halted && pRequest->status != STATUS::CANCELLED)
+        {
+          ostringstream response;
+          string        moves;
+
+          for (RubiksCube::MOVE move : solution.moves)
+          {
+            if (!moves.empty())
+              moves += ' ';
+
+            moves += pRequest->cube.getMove(move);
+          }
+
+          response << this->jsonResponse(pRequest->id, "solved")
+                   << ",\"solution\":\"" << moves << '"'
+                   << ",\"length\":" << solution.moves.size()
+                   << ",\"lowerBound\":" << (unsigned)solution.lowerBound
+                   << ",\"nodes\":" << solution.numNodes
+                   << ",\"seconds\":" << pRequest->timer.getElapsedSeconds()
+                   << '}';
+
+          this->finishRequest(pRequest, response.str());
+        }
+        else if (pRequest->status == STATUS::TIMEOUT)
+          this->finishRequest(pRequest, this->jsonResponse(pRequest->id, "timeout") + '}');
+        else
+          this->finishRequest(pRequest, this->jsonResponse(pRequest->id, "cancelled") + '}');
+      }
+      catch (const exception& ex)
+      {
+        this->finishRequest(pRequest, this->jsonResponse(pRequest->id, "error") +
+          ",\"error\":\"" + StringUtils::JsonEscape(ex.what()) + "\"}");
+      }
+    }
+    else if (pRequest->status == STATUS::TIMEOUT)
+      this->finishRequest(pRequest, this->jsonResponse(pRequest->id, "timeout") + '}');
+    else
+      this->finishRequest(pRequest, this->jsonResponse(pRequest->id, "cancelled") + '}');
+
+    if (!pRequest->optimal)
+      return;
+
+    // Hand the optimal slot to the next queued request.
+    requestPtr_t pNext;
+
+    {
+      lock_guard<mutex> requestLock(this->requestMutex);
+
+      if (this->optimalQueue.empty())
+        --this->numOptimalSolves;
+      else
+      {
+        pNext = this->optimalQueue.front();
+        this->optimalQueue.pop_front();
+      }
+    }
+
+    if (pNext)
+      this->dispatch(pNext);
+  }
+
+  /**
+   * Send a request's response and forget the request.
+   */
+  void SolverServer::finishRequest(requestPtr_t pRequest, const string& response)
+  {
+    {
+      lock_guard<mutex> requestLock(this->requestMutex);
+
+      auto connIt = this->requests.find(pRequest->pConnection.get());
+
+      if (connIt != this->requests.end())
+      {
+        auto it = connIt->second.find(pRequest->id);
+
+        if (it != connIt->second.end() && it->second == pRequest)
+          connIt->second.erase(it);
+      }
+    }
+
+    this->send(*pRequest->pConnection, response);
+  }
+
+  /**
+   * Halt running requests that are past their timeout, and answer queued
+   * ones.
+   */
+  void SolverServer::checkTimeouts()
+  {
+    vector<requestPtr_t> expired;
+
+    {
+      lock_guard<mutex> requestLock(this->requestMutex);
+
+      for (auto& connRequests : this->requests)
+      {
+        for (auto& idRequest : connRequests.second)
+        {
+          Request& request = *idRequest.second;
+
+          if (request.timeoutSeconds <= 0 ||
+            request.timer.getElapsedSeconds() < request.timeoutSeconds)
+          {
+            continue;
+          }
+
+          STATUS expected = STATUS::RUNNING;
+
+          if (request.status.compare_exchange_strong(expected, STATUS::TIMEOUT))
+            request.halt = true;
+          else if (expected == STATUS::QUEUED)
+          {
+            for (auto qIt = this->optimalQueue.begin(); qIt != this->optimalQueue.end(); ++qIt)
+            {
+              if (*qIt == idRequest.second)
+              {
+                this->optimalQueue.erase(qIt);
+                request.status = STATUS::TIMEOUT;
+                expired.push_back(idRequest.second);
+                break;
+              }
+            }
+          }
+        }
+      }
+    }
+
+    for (requestPtr_t& pRequest : expired)
+      this->finishRequest(pRequest, this->jsonResponse(pRequest->id, "timeout") + '}');
+  }
+
+  /**
+   * Write a line to a client.  Lines from different threads don't interleave,
+   * and writes to a closed connection are dropped.
+   */
+  void SolverServer::send(Connection& connection, const string& line)
+  {
+    lock_guard<mutex> writeLock(connection.writeMutex);
+
+    if (connection.fd == -1)
+      return;
+
+    string      data = line + '\n';
+    const char* pos  = data.data();
+    size_t      left = data.size();
+
+    while (left != 0)
+    {
+      ssize_t numSent = ::send(connection.fd, pos, left, MSG_NOSIGNAL);
+
+      if (numSent == -1)
+      {
+        if (errno == EINTR)
+          continue;
+
+        // The reader will notice that the connection is gone.
+        return;
+      }
+
+      pos  += numSent;
+      left -= numSent;
+    }
+  }
+
+  /**
+   * Start a JSON response (without the closing brace, so that fields can be
+   * added).
+   */
+  string SolverServer::jsonResponse(const string& id, const string& status) const
+  {
+    return "{\"id\":\"" + StringUtils::JsonEscape(id) + "\",\"status\":\"" +
+      status + '"';
+  }
+}
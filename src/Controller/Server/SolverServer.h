@@ -0,0 +1,130 @@
+#ifndef _BUSYBIN_SOLVER_SERVER_H_
+#define _BUSYBIN_SOLVER_SERVER_H_
+
+#include "../Command/Solver/CubeSolver.h"
+#include "../../Model/RubiksCube.h"
+#include "../../Model/RubiksCubeIndexModel.h"
+#include "../../Util/RubiksCubeException.h"
+#include "../../Util/ThreadPool.h"
+#include "../../Util/Timer.h"
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+#include <deque>
+using std::deque;
+#include <map>
+using std::map;
+#include <memory>
+using std::shared_ptr;
+using std::make_shared;
+#include <mutex>
+using std::mutex;
+using std::lock_guard;
+#include <atomic>
+using std::atomic;
+using std::atomic_bool;
+#include <sstream>
+using std::istringstream;
+using std::ostringstream;
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * A long-running server that keeps the solvers' pattern databases in memory
+   * and solves scrambles sent over a Unix domain socket or a localhost TCP
+   * port.  The protocol is line based.  Requests:
+   *
+   *   SOLVE <id> <korf|thistlethwaite|twophase|anytime> <timeout ms, 0 for none> <scramble>
+   *   CANCEL <id>
+   *   PING
+   *
+   * Each SOLVE gets one JSON line back when it finishes, tagged with its id,
+   * whose status is solved, timeout, cancelled, or error.  Ids are chosen by
+   * the client and are scoped to the connection.  PING gets {"status":"pong"}.
+   * An anytime solve treats the timeout as a deadline: it's answered with the
+   * best solution found by then, and its lowerBound shows how far from
+   * optimal that can be.
+   *
+   * Solves run on the ThreadPool, one per thread.  Optimal (Korf and anytime)
+   * solves can take minutes, so at most maxOptimalSolves of them run at once
+   * and the rest wait in a queue; keeping that below the pool size leaves
+   * threads for Thistlethwaite and two-phase solves, which take milliseconds.
+   */
+  class SolverServer
+  {
+    enum class STATUS : uint8_t {QUEUED, RUNNING, TIMEOUT, CANCELLED};
+
+    struct Connection
+    {
+      int    fd;
+      string inBuffer;
+      mutex  writeMutex;
+    };
+
+    struct Request
+    {
+      string                 id;
+      shared_ptr<Connection> pConnection;
+      const CubeSolver*      pSolver;
+      bool                   optimal;
+      RubiksCubeIndexModel   cube;
+      Timer                  timer;
+      double                 timeoutSeconds;
+      atomic<STATUS>         status;
+      atomic_bool            halt;
+
+      Request() : timer(true), status(STATUS::QUEUED), halt(false) {}
+    };
+
+    typedef shared_ptr<Request> requestPtr_t;
+
+    const CubeSolver* pKorfSolver;
+    const CubeSolver* pThistlethwaiteSolver;
+    const CubeSolver* pTwoPhaseSolver;
+    const CubeSolver* pAnytimeSolver;
+    ThreadPool*       pThreadPool;
+    unsigned          maxOptimalSolves;
+    int               listenFd;
+
+    // Guards the fields below.
+    mutex                                        requestMutex;
+    map<Connection*, map<string, requestPtr_t> > requests;
+    deque<requestPtr_t>                          optimalQueue;
+    unsigned                                     numOptimalSolves;
+
+    vector<shared_ptr<Connection> > connections;
+
+    SolverServer(const SolverServer&);
+    SolverServer& operator=(const SolverServer&);
+
+    void acceptConnection();
+    bool readConnection(shared_ptr<Connection> pConnection);
+    void closeConnection(shared_ptr<Connection> pConnection);
+    void handleLine(shared_ptr<Connection> pConnection, const string& line);
+    void handleSolve(shared_ptr<Connection> pConnection, istringstream& args);
+    void handleCancel(shared_ptr<Connection> pConnection, const string& id);
+    void dispatch(requestPtr_t pRequest);
+    void runRequest(requestPtr_t pRequest);
+    void finishRequest(requestPtr_t pRequest, const string& response);
+    void checkTimeouts();
+    void send(Connection& connection, const string& line);
+    string jsonResponse(const string& id, const string& status) const;
+
+  public:
+    SolverServer(const CubeSolver* pKorfSolver,
+      const CubeSolver* pThistlethwaiteSolver, const CubeSolver* pTwoPhaseSolver,
+      const CubeSolver* pAnytimeSolver, ThreadPool* pThreadPool,
+      unsigned maxOptimalSolves = 1);
+    ~SolverServer();
+    void listenUnix(const string& path);
+    void listenTcp(uint16_t port);
+    void run();
+  };
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "CoordinateMoveTables.h"
+
+namespace busybin
+{
+  /**
+   * Build the corner orientation and permutation move tables.
+   */
+  CoordinateMoveTables::CoordinateMoveTables()
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    this->cornerOrientationMoves.resize(NUM_CORNER_ORIENTATIONS * NUM_MOVES);
+    this->cornerPermutationMoves.resize(NUM_CORNER_PERMUTATIONS * NUM_MOVES);
+
+    for (unsigned co = 0; co < NUM_CORNER_ORIENTATIONS; ++co)
+    {
+      // Decode the base-3 number.  The 8th orientation makes the sum of all
+      // orientations a multiple of 3.
+      array<uint8_t, 8> ori;
+      unsigned          num = co;
+      unsigned          sum = 0;
+
+      for (int i = 6; i >= 0; --i)
+      {
+        ori[i] = num % 3;
+        num   /= 3;
+        sum   += ori[i];
+      }
+
+      ori[7] = (3 - sum % 3) % 3;
+
+      for (unsigned m = 0; m < NUM_MOVES; ++m)
+      {
+        const RubiksCubeIndexModel::MoveTable& table =
+          RubiksCubeIndexModel::getMoveTable((MOVE)m);
+        unsigned newCo = 0;
+
+        for (unsigned i = 0; i < 7; ++i)
+          newCo = newCo * 3 + (ori[table.cornerPerm[i]] + table.cornerTwist[i]) % 3;
+
+        this->cornerOrientationMoves[co * NUM_MOVES + m] = newCo;
+      }
+    }
+
+    for (unsigned cp = 0; cp < NUM_CORNER_PERMUTATIONS; ++cp)
+    {
+      array<uint8_t, 8> perm = this->cornerPermIndexer.unrank(cp);
+
+      for (unsigned m = 0; m < NUM_MOVES; ++m)
+      {
+        const RubiksCubeIndexModel::MoveTable& table =
+          RubiksCubeIndexModel::getMoveTable((MOVE)m);
+        array<uint8_t, 8> newPerm;
+
+        for (unsigned i = 0; i < 8; ++i)
+          newPerm[i] = perm[table.cornerPerm[i]];
+
+        this->cornerPermutationMoves[cp * NUM_MOVES + m] =
+          this->cornerPermIndexer.rank(newPerm);
+      }
+    }
+  }
+
+  /**
+   * Get the tables, building them on the first call (thread safe).
+   */
+  const CoordinateMoveTables& CoordinateMoveTables::getInstance()
+  {
+    static const CoordinateMoveTables tables;
+
+    return tables;
+  }
+
+  /**
+   * Get the corner orientation coordinate of a cube.
+   */
+  uint16_t CoordinateMoveTables::getCornerOrientation(
+    const RubiksCubeIndexModel& cube) const
+  {
+    uint16_t co = 0;
+
+    for (unsigned i = 0; i < 7; ++i)
+      co = co * 3 + cube.getCornerOrientation((RubiksCube::CORNER)i);
+
+    return co;
+  }
+
+  /**
+   * Get the corner permutation coordinate of a cube.
+   */
+  uint16_t CoordinateMoveTables::getCornerPermutation(
+    const RubiksCubeIndexModel& cube) const
+  {
+    array<uint8_t, 8> perm;
+
+    for (unsigned i = 0; i < 8; ++i)
+      perm[i] = cube.getCornerIndex((RubiksCube::CORNER)i);
+
+    return this->cornerPermIndexer.rank(perm);
+  }
+}
@@ -0,0 +1,72 @@
+#ifndef _BUSYBIN_COORDINATE_MOVE_TABLES_H_
+#define _BUSYBIN_COORDINATE_MOVE_TABLES_H_
+
+#include "../RubiksCube.h"
+#include "../RubiksCubeIndexModel.h"
+#include "../PatternDatabase/PermutationIndexer.h"
+#include <cstdint>
+#include <cstddef>
+using std::size_t;
+#include <array>
+using std::array;
+#include <vector>
+using std::vector;
+
+namespace busybin
+{
+  /**
+   * Precomputed move tables over the corner coordinates.  A coordinate is a
+   * number that describes part of the cube's state, and a move table gives
+   * the coordinate after each of the 18 face twists, so a search can follow
+   * the coordinates without keeping a cube at all.  The two-phase solver
+   * (TwoPhaseTables) uses these for its corner coordinates.
+   *
+   * - Corner orientation (3^7): the orientations of the corners at positions
+   *   0-6 as a base-3 number.
+   * - Corner permutation (8!): the rank of the corner permutation (position
+   *   to cubie).
+   *
+   * The tables take about 1.5MB and are built on first use.
+   */
+  class CoordinateMoveTables
+  {
+  public:
+    enum { NUM_MOVES = 18 };
+    enum { NUM_CORNER_ORIENTATIONS = 2187 };
+    enum { NUM_CORNER_PERMUTATIONS = 40320 };
+
+  private:
+    vector<uint16_t> cornerOrientationMoves;
+    vector<uint16_t> cornerPermutationMoves;
+
+    PermutationIndexer<8> cornerPermIndexer;
+
+    CoordinateMoveTables();
+    CoordinateMoveTables(const CoordinateMoveTables&);
+    CoordinateMoveTables& operator=(const CoordinateMoveTables&);
+
+  public:
+    static const CoordinateMoveTables& getInstance();
+
+    /**
+     * Get the corner orientation coordinate after a move.
+     */
+    uint16_t moveCornerOrientation(uint16_t co, RubiksCube::MOVE move) const
+    {
+      return this->cornerOrientationMoves[co * NUM_MOVES + (unsigned)move];
+    }
+
+    /**
+     * Get the corner permutation coordinate after a move.
+     */
+    uint16_t moveCornerPermutation(uint16_t cp, RubiksCube::MOVE move) const
+    {
+      return this->cornerPermutationMoves[cp * NUM_MOVES + (unsigned)move];
+    }
+
+    uint16_t getCornerOrientation(const RubiksCubeIndexModel& cube) const;
+    uint16_t getCornerPermutation(const RubiksCubeIndexModel& cube) const;
+  };
+}
+
+#endif
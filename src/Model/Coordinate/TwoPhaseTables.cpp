@@ -0,0 +1,363 @@
+#include "TwoPhaseTables.h"
+
+namespace busybin
+{
+  /**
+   * Build all the tables.
+   */
+  TwoPhaseTables::TwoPhaseTables() :
+    coordTables(CoordinateMoveTables::getInstance()),
+    phase2Moves
+    ({{
+      RubiksCube::MOVE::L2,
+      RubiksCube::MOVE::R2,
+      RubiksCube::MOVE::U,
+      RubiksCube::MOVE::UPRIME,
+      RubiksCube::MOVE::U2,
+      RubiksCube::MOVE::D,
+      RubiksCube::MOVE::DPRIME,
+      RubiksCube::MOVE::D2,
+      RubiksCube::MOVE::F2,
+      RubiksCube::MOVE::B2
+    }}),
+    cornerSlicePruning(NUM_CORNER_ORIENTATIONS * NUM_SLICE_POSITIONS),
+    edgeSlicePruning(NUM_EDGE_ORIENTATIONS * NUM_SLICE_POSITIONS),
+    orientationPruning(NUM_CORNER_ORIENTATIONS * NUM_EDGE_ORIENTATIONS),
+    cornerPermPruning(NUM_CORNER_PERMUTATIONS * NUM_SLICE_PERMUTATIONS),
+    edgePermPruning(NUM_UD_EDGE_PERMUTATIONS * NUM_SLICE_PERMUTATIONS)
+  {
+    this->buildPhase1Tables();
+    this->buildPhase2Tables();
+  }
+
+  /**
+   * Get the tables, building them on the first call (thread safe).
+   */
+  const TwoPhaseTables& TwoPhaseTables::getInstance()
+  {
+    static const TwoPhaseTables tables;
+
+    return tables;
+  }
+
+  /**
+   * Build the edge orientation and slice position move tables, and the phase
+   * 1 pruning tables.
+   */
+  void TwoPhaseTables::buildPhase1Tables()
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    this->edgeOrientationMoves.resize(NUM_EDGE_ORIENTATIONS * NUM_MOVES);
+
+    for (unsigned eo = 0; eo < NUM_EDGE_ORIENTATIONS; ++eo)
+    {
+      // The 12th orientation makes the number of flipped edges even.
+      array<uint8_t, 12> ori;
+
+      for (unsigned i = 0; i < 11; ++i)
+        ori[i] = (eo >> (10 - i)) & 1;
+
+      ori[11] = __builtin_popcount(eo) & 1;
+
+      for (unsigned m = 0; m < NUM_MOVES; ++m)
+      {
+        const RubiksCubeIndexModel::MoveTable& table =
+          RubiksCubeIndexModel::getMoveTable((MOVE)m);
+        unsigned newEo = 0;
+
+        for (unsigned i = 0; i < 11; ++i)
+          newEo = (newEo << 1) | (ori[table.edgePerm[i]] ^ table.edgeFlip[i]);
+
+        this->edgeOrientationMoves[eo * NUM_MOVES + m] = newEo;
+      }
+    }
+
+    // The slice positions are moved as sets (bit masks) of 4 positions.
+    this->slicePositionMoves.resize(NUM_SLICE_POSITIONS * NUM_MOVES);
+
+    for (unsigned mask = 0; mask < 4096; ++mask)
+    {
+      if (__builtin_popcount(mask) != 4)
+        continue;
+
+      array<uint8_t, 4> pos;
+      unsigned          numPos = 0;
+
+      for (uint8_t i = 0; i < 12; ++i)
+      {
+        if (mask & (1 << i))
+          pos[numPos++] = i;
+      }
+
+      uint16_t slice = this->slicePositionIndexer.rank(pos);
+
+      if (mask == 0xF0)
+        this->solvedSlicePosition = slice;
+
+      for (unsigned m = 0; m < NUM_MOVES; ++m)
+      {
+        const RubiksCubeIndexModel::MoveTable& table =
+          RubiksCubeIndexModel::getMoveTable((MOVE)m);
+        array<uint8_t, 4> newPos;
+
+        numPos = 0;
+
+        // The new position i holds the edge from position edgePerm[i].
+        for (uint8_t i = 0; i < 12; ++i)
+        {
+          if (mask & (1 << table.edgePerm[i]))
+            newPos[numPos++] = i;
+        }
+
+        this->slicePositionMoves[slice * NUM_MOVES + m] =
+          this->slicePositionIndexer.rank(newPos);
+      }
+    }
+
+    this->buildPruningTable(this->cornerSlicePruning, NUM_SLICE_POSITIONS,
+      NUM_MOVES,
+      [this](uint32_t co, unsigned m)
+      {
+        return this->moveCornerOrientation(co, (MOVE)m);
+      },
+      [this](uint32_t slice, unsigned m)
+      {
+        return this->moveSlicePosition(slice, (MOVE)m);
+      },
+      this->solvedSlicePosition);
+
+    this->buildPruningTable(this->edgeSlicePruning, NUM_SLICE_POSITIONS,
+      NUM_MOVES,
+      [this](uint32_t eo, unsigned m)
+      {
+        return this->moveEdgeOrientation(eo, (MOVE)m);
+      },
+      [this](uint32_t slice, unsigned m)
+      {
+        return this->moveSlicePosition(slice, (MOVE)m);
+      },
+      this->solvedSlicePosition);
+
+    this->buildPruningTable(this->orientationPruning, NUM_EDGE_ORIENTATIONS,
+      NUM_MOVES,
+      [this](uint32_t co, unsigned m)
+      {
+        return this->moveCornerOrientation(co, (MOVE)m);
+      },
+      [this](uint32_t eo, unsigned m)
+      {
+        return this->moveEdgeOrientation(eo, (MOVE)m);
+      },
+      0);
+  }
+
+  /**
+   * Build the U/D edge and slice permutation move tables, and the phase 2
+   * pruning tables.
+   */
+  void TwoPhaseTables::buildPhase2Tables()
+  {
+    // The U and D edges are positions (and edges) 0-3 and 8-11.  They're
+    // numbered 0-7 in the U/D edge permutation.
+    const array<uint8_t, 8> udPositions = {{0, 1, 2, 3, 8, 9, 10, 11}};
+
+    this->udEdgePermutationMoves.resize(NUM_UD_EDGE_PERMUTATIONS * NUM_PHASE2_MOVES);
+
+    for (unsigned ep = 0; ep < NUM_UD_EDGE_PERMUTATIONS; ++ep)
+    {
+      array<uint8_t, 8> perm = this->udEdgeIndexer.unrank(ep);
+
+      for (unsigned m = 0; m < NUM_PHASE2_MOVES; ++m)
+      {
+        const RubiksCubeIndexModel::MoveTable& table =
+          RubiksCubeIndexModel::getMoveTable(this->phase2Moves[m]);
+        array<uint8_t, 8> newPerm;
+
+        for (unsigned i = 0; i < 8; ++i)
+        {
+          uint8_t from = table.edgePerm[udPositions[i]];
+
+          newPerm[i] = perm[from < 4 ? from : from - 4];
+        }
+
+        this->udEdgePermutationMoves[ep * NUM_PHASE2_MOVES + m] =
+          this->udEdgeIndexer.rank(newPerm);
+      }
+    }
+
+    // The E-slice edges are positions (and edges) 4-7.
+    this->slicePermutationMoves.resize(NUM_SLICE_PERMUTATIONS * NUM_PHASE2_MOVES);
+
+    for (unsigned sp = 0; sp < NUM_SLICE_PERMUTATIONS; ++sp)
+    {
+      array<uint8_t, 4> perm = this->sliceIndexer.unrank(sp);
+
+      for (unsigned m = 0; m < NUM_PHASE2_MOVES; ++m)
+      {
+        const RubiksCubeIndexModel::MoveTable& table =
+          RubiksCubeIndexModel::getMoveTable(this->phase2Moves[m]);
+        array<uint8_t, 4> newPerm;
+
+        for (unsigned i = 0; i < 4; ++i)
+          newPerm[i] = perm[table.edgePerm[i + 4] - 4];
+
+        this->slicePermutationMoves[sp * NUM_PHASE2_MOVES + m] =
+          this->sliceIndexer.rank(newPerm);
+      }
+    }
+
+    auto moveSlicePerm = [this](uint32_t sp, unsigned m)
+    {
+      return this->moveSlicePermutation(sp, m);
+    };
+
+    this->buildPruningTable(this->cornerPermPruning, NUM_SLICE_PERMUTATIONS,
+      NUM_PHASE2_MOVES,
+      [this](uint32_t cp, unsigned m)
+      {
+        return this->moveCornerPermutation(cp, m);
+      },
+      moveSlicePerm, 0);
+
+    this->buildPruningTable(this->edgePermPruning, NUM_SLICE_PERMUTATIONS,
+      NUM_PHASE2_MOVES,
+      [this](uint32_t ep, unsigned m)
+      {
+        return this->moveUDEdgePermutation(ep, m);
+      },
+      moveSlicePerm, 0);
+  }
+
+  /**
+   * Fill a pruning table over a pair of coordinates (first * numSecond +
+   * second) with a breadth-first search from the solved pair.  The first
+   * coordinate of a solved cube is always 0.
+   * @param table The table, which must be initialized to 0xF.
+   * @param numSecond The number of values of the second coordinate.
+   * @param numMoves The number of moves (18 or 10).
+   * @param moveFirst Moves the first coordinate.
+   * @param moveSecond Moves the second coordinate.
+   * @param solvedSecond The second coordinate of a solved cube.
+   */
+  void TwoPhaseTables::buildPruningTable(NibbleArray& table,
+    unsigned numSecond, unsigned numMoves, const moveFunc_t& moveFirst,
+    const moveFunc_t& moveSecond, uint32_t solvedSecond) const
+  {
+    vector<uint32_t> frontier(1, solvedSecond);
+    vector<uint32_t> next;
+    uint8_t          depth = 0;
+
+    table.set(solvedSecond, 0);
+
+    while (!frontier.empty())
+    {
+      ++depth;
+      next.clear();
+
+      for (uint32_t index : frontier)
+      {
+        uint32_t first  = index / numSecond;
+        uint32_t second = index % numSecond;
+
+        for (unsigned m = 0; m < numMoves; ++m)
+        {
+          uint32_t newIndex = moveFirst(first, m) * numSecond + moveSecond(second, m);
+
+          if (table.get(newIndex) == 0xF)
+          {
+            table.set(newIndex, depth);
+            next.push_back(newIndex);
+          }
+        }
+      }
+
+      frontier.swap(next);
+    }
+  }
+
+  /**
+   * Get the corner orientation coordinate of a cube.
+   */
+  uint16_t TwoPhaseTables::getCornerOrientation(
+    const RubiksCubeIndexModel& cube) const
+  {
+    return this->coordTables.getCornerOrientation(cube);
+  }
+
+  /**
+   * Get the edge orientation coordinate of a cube.
+   */
+  uint16_t TwoPhaseTables::getEdgeOrientation(
+    const RubiksCubeIndexModel& cube) const
+  {
+    uint16_t eo = 0;
+
+    for (unsigned i = 0; i < 11; ++i)
+      eo = (eo << 1) | cube.getEdgeOrientation((RubiksCube::EDGE)i);
+
+    return eo;
+  }
+
+  /**
+   * Get the slice position coordinate of a cube.
+   */
+  uint16_t TwoPhaseTables::getSlicePosition(
+    const RubiksCubeIndexModel& cube) const
+  {
+    array<uint8_t, 4> pos;
+    unsigned          numPos = 0;
+
+    for (uint8_t i = 0; i < 12; ++i)
+    {
+      uint8_t edgeInd = cube.getEdgeIndex((RubiksCube::EDGE)i);
+
+      if (edgeInd >= 4 && edgeInd < 8)
+        pos[numPos++] = i;
+    }
+
+    return this->slicePositionIndexer.rank(pos);
+  }
+
+  /**
+   * Get the corner permutation coordinate of a cube.
+   */
+  uint16_t TwoPhaseTables::getCornerPermutation(
+    const RubiksCubeIndexModel& cube) const
+  {
+    return this->coordTables.getCornerPermutation(cube);
+  }
+
+  /**
+   * Get the U/D edge permutation coordinate of a cube in G2.
+   */
+  uint16_t TwoPhaseTables::getUDEdgePermutation(
+    const RubiksCubeIndexModel& cube) const
+  {
+    const array<uint8_t, 8> udPositions = {{0, 1, 2, 3, 8, 9, 10, 11}};
+    array<uint8_t, 8>       perm;
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+      uint8_t edgeInd = cube.getEdgeIndex((RubiksCube::EDGE)udPositions[i]);
+
+      perm[i] = edgeInd < 4 ? edgeInd : edgeInd - 4;
+    }
+
+    return this->udEdgeIndexer.rank(perm);
+  }
+
+  /**
+   * Get the slice permutation coordinate of a cube in G2.
+   */
+  uint8_t TwoPhaseTables::getSlicePermutation(
+    const RubiksCubeIndexModel& cube) const
+  {
+    array<uint8_t, 4> perm;
+
+    for (unsigned i = 0; i < 4; ++i)
+      perm[i] = cube.getEdgeIndex((RubiksCube::EDGE)(i + 4)) - 4;
+
+    return this->sliceIndexer.rank(perm);
+  }
+}
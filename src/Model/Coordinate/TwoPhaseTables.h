@@ -0,0 +1,203 @@
+#ifndef _BUSYBIN_TWO_PHASE_TABLES_H_
+#define _BUSYBIN_TWO_PHASE_TABLES_H_
+
+#include "CoordinateMoveTables.h"
+#include "../RubiksCube.h"
+#include "../RubiksCubeIndexModel.h"
+#include "../PatternDatabase/PermutationIndexer.h"
+#include "../PatternDatabase/CombinationIndexer.h"
+#include "../../Util/NibbleArray.h"
+#include <cstdint>
+#include <cstddef>
+using std::size_t;
+#include <array>
+using std::array;
+#include <vector>
+using std::vector;
+#include <functional>
+using std::function;
+
+namespace busybin
+{
+  /**
+   * Move and pruning tables for the two-phase (Kociemba) solver.
+   *
+   * Phase 1 moves the cube into G2 = <L2,R2,U,D,F2,B2> (the Thistlethwaite
+   * G2 group, see GoalG1_G2) with all 18 twists.  Its coordinates are:
+   *
+   * - Corner orientation (3^7), as in CoordinateMoveTables.
+   * - Edge orientation (2^11): the orientations of the edges at positions
+   *   0-10 as a binary number.
+   * - Slice position (12C4): the rank of the set of positions that hold the
+   *   E-slice edges (FR, FL, BL, BR).
+   *
+   * Phase 2 solves the cube with the G2 twists (see G2TwistStore).  Its
+   * coordinates are:
+   *
+   * - Corner permutation (8!), as in CoordinateMoveTables.
+   * - U and D edge permutation (8!): the rank of the permutation of the 8
+   *   edges in the U and D layers.
+   * - Slice permutation (4!): the rank of the permutation of the E-slice
+   *   edges.
+   *
+   * Each phase is pruned with the max of tables over pairs of its
+   * coordinates, which hold the exact number of moves to solve the pair (three
+   * tables for phase 1 and two for phase 2).  The tables take about 5MB and
+   * are built on first use.
+   */
+  class TwoPhaseTables
+  {
+  public:
+    enum { NUM_MOVES = 18 };
+    enum { NUM_PHASE2_MOVES = 10 };
+    enum { NUM_CORNER_ORIENTATIONS = 2187 };
+    enum { NUM_EDGE_ORIENTATIONS = 2048 };
+    enum { NUM_SLICE_POSITIONS = 495 };
+    enum { NUM_CORNER_PERMUTATIONS = 40320 };
+    enum { NUM_UD_EDGE_PERMUTATIONS = 40320 };
+    enum { NUM_SLICE_PERMUTATIONS = 24 };
+
+  private:
+    // Gives a coordinate after a move (by number).
+    typedef function<uint32_t(uint32_t, unsigned)> moveFunc_t;
+
+    const CoordinateMoveTables& coordTables;
+
+    // The G2 twists, in G2TwistStore order.  Phase 2 moves are numbered by
+    // their index in this array.
+    array<RubiksCube::MOVE, NUM_PHASE2_MOVES> phase2Moves;
+
+    vector<uint16_t> edgeOrientationMoves;
+    vector<uint16_t> slicePositionMoves;
+    vector<uint16_t> udEdgePermutationMoves;
+    vector<uint8_t>  slicePermutationMoves;
+
+    // The slice position coordinate of a solved cube.
+    uint16_t solvedSlicePosition;
+
+    // Phase 1: corner orientation x slice position, edge orientation x slice
+    // position, and corner orientation x edge orientation.  Phase 2: corner
+    // permutation x slice permutation and U/D edge permutation x slice
+    // permutation.
+    NibbleArray cornerSlicePruning;
+    NibbleArray edgeSlicePruning;
+    NibbleArray orientationPruning;
+    NibbleArray cornerPermPruning;
+    NibbleArray edgePermPruning;
+
+    PermutationIndexer<8>     udEdgeIndexer;
+    PermutationIndexer<4>     sliceIndexer;
+    CombinationIndexer<12, 4> slicePositionIndexer;
+
+    TwoPhaseTables();
+    TwoPhaseTables(const TwoPhaseTables&);
+    TwoPhaseTables& operator=(const TwoPhaseTables&);
+
+    void buildPhase1Tables();
+    void buildPhase2Tables();
+    void buildPruningTable(NibbleArray& table, unsigned numSecond,
+      unsigned numMoves, const moveFunc_t& moveFirst,
+      const moveFunc_t& moveSecond, uint32_t solvedIndex) const;
+
+  public:
+    static const TwoPhaseTables& getInstance();
+
+    /**
+     * Get the G2 twist with the given phase 2 move number.
+     */
+    RubiksCube::MOVE getPhase2Move(unsigned ind) const
+    {
+      return this->phase2Moves[ind];
+    }
+
+    /**
+     * Get the corner orientation coordinate after a move.
+     */
+    uint16_t moveCornerOrientation(uint16_t co, RubiksCube::MOVE move) const
+    {
+      return this->coordTables.moveCornerOrientation(co, move);
+    }
+
+    /**
+     * Get the edge orientation coordinate after a move.
+     */
+    uint16_t moveEdgeOrientation(uint16_t eo, RubiksCube::MOVE move) const
+    {
+      return this->edgeOrientationMoves[eo * NUM_MOVES + (unsigned)move];
+    }
+
+    /**
+     * Get the slice position coordinate after a move.
+     */
+    uint16_t moveSlicePosition(uint16_t slice, RubiksCube::MOVE move) const
+    {
+      return this->slicePositionMoves[slice * NUM_MOVES + (unsigned)move];
+    }
+
+    /**
+     * Get the corner permutation coordinate after a phase 2 move.
+     */
+    uint16_t moveCornerPermutation(uint16_t cp, unsigned phase2Move) const
+    {
+      return this->coordTables.moveCornerPermutation(cp,
+        this->phase2Moves[phase2Move]);
+    }
+
+    /**
+     * Get the U/D edge permutation coordinate after a phase 2 move.
+     */
+    uint16_t moveUDEdgePermutation(uint16_t ep, unsigned phase2Move) const
+    {
+      return this->udEdgePermutationMoves[ep * NUM_PHASE2_MOVES + phase2Move];
+    }
+
+    /**
+     * Get the slice permutation coordinate after a phase 2 move.
+     */
+    uint8_t moveSlicePermutation(uint8_t sp, unsigned phase2Move) const
+    {
+      return this->slicePermutationMoves[sp * NUM_PHASE2_MOVES + phase2Move];
+    }
+
+    /**
+     * Check if the phase 1 coordinates are in G2.
+     */
+    bool isPhase1Solved(uint16_t co, uint16_t eo, uint16_t slice) const
+    {
+      return co == 0 && eo == 0 && slice == this->solvedSlicePosition;
+    }
+
+    /**
+     * Get a lower bound on the number of moves to G2.
+     */
+    uint8_t getPhase1Moves(uint16_t co, uint16_t eo, uint16_t slice) const
+    {
+      uint8_t cornerMoves = this->cornerSlicePruning.get(co * NUM_SLICE_POSITIONS + slice);
+      uint8_t edgeMoves   = this->edgeSlicePruning.get(eo * NUM_SLICE_POSITIONS + slice);
+      uint8_t oriMoves    = this->orientationPruning.get(co * NUM_EDGE_ORIENTATIONS + eo);
+      uint8_t moves       = cornerMoves > edgeMoves ? cornerMoves : edgeMoves;
+
+      return moves > oriMoves ? moves : oriMoves;
+    }
+
+    /**
+     * Get a lower bound on the number of G2 twists to solve a cube in G2.
+     */
+    uint8_t getPhase2Moves(uint16_t cp, uint16_t ep, uint8_t sp) const
+    {
+      uint8_t cornerMoves = this->cornerPermPruning.get(cp * NUM_SLICE_PERMUTATIONS + sp);
+      uint8_t edgeMoves   = this->edgePermPruning.get(ep * NUM_SLICE_PERMUTATIONS + sp);
+
+      return cornerMoves > edgeMoves ? cornerMoves : edgeMoves;
+    }
+
+    uint16_t getCornerOrientation(const RubiksCubeIndexModel& cube) const;
+    uint16_t getEdgeOrientation(const RubiksCubeIndexModel& cube) const;
+    uint16_t getSlicePosition(const RubiksCubeIndexModel& cube) const;
+    uint16_t getCornerPermutation(const RubiksCubeIndexModel& cube) const;
+    uint16_t getUDEdgePermutation(const RubiksCubeIndexModel& cube) const;
+    uint8_t getSlicePermutation(const RubiksCubeIndexModel& cube) const;
+  };
+}
+
+#endif
@@ -36,7 +36,7 @@ namespace busybin
    * @param ind An index into the database.
    * @param numMoves The number of moves required to get to this cube state.
    */
-  bool DatabaseGoal::index(const uint32_t ind, uint8_t numMoves)
+  bool DatabaseGoal::index(const size_t ind, uint8_t numMoves)
   {
     return this->pDatabase->setNumMoves(ind, numMoves);
   }
@@ -54,7 +54,7 @@ namespace busybin
    * Get the number of moves using an index into the database.
    * @param ind The database index.
    */
-  uint8_t DatabaseGoal::getNumMoves(const uint32_t ind) const
+  uint8_t DatabaseGoal::getNumMoves(const size_t ind) const
   {
     return this->pDatabase->getNumMoves(ind);
   }
@@ -63,8 +63,16 @@ namespace busybin
    * Get the index for the cube (proxy to PatternDatabase#getDatabaseIndex).
    * @param cube
    */
-  uint32_t DatabaseGoal::getDatabaseIndex(const RubiksCube& cube) const
+  size_t DatabaseGoal::getDatabaseIndex(const RubiksCube& cube) const
   {
     return this->pDatabase->getDatabaseIndex(cube);
   }
+
+  /**
+   * Get the database that the goal fills.
+   */
+  PatternDatabase* DatabaseGoal::getDatabase() const
+  {
+    return this->pDatabase;
+  }
 }
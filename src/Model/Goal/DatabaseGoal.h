@@ -15,10 +15,11 @@ namespace busybin
     DatabaseGoal(PatternDatabase* pDatabase);
     bool isSatisfied(RubiksCube& cube);
     bool index(const RubiksCube& cube, uint8_t numMoves);
-    bool index(const uint32_t ind,  uint8_t numMoves);
+    bool index(const size_t ind,  uint8_t numMoves);
     uint8_t getNumMoves(const RubiksCube& cube) const;
-    uint8_t getNumMoves(const uint32_t ind) const;
-    uint32_t getDatabaseIndex(const RubiksCube& cube) const;
+    uint8_t getNumMoves(const size_t ind) const;
+    size_t getDatabaseIndex(const RubiksCube& cube) const;
+    PatternDatabase* getDatabase() const;
   };
 }
 
@@ -0,0 +1,22 @@
+#include "CornerSymDatabaseGoal.h"
+
+namespace busybin
+{
+  /**
+   * Init, storing a pointer to the database.
+   * @param pDatabase A pointer to a pattern database.
+   */
+  CornerSymDatabaseGoal::CornerSymDatabaseGoal(CornerSymPatternDatabase* pDatabase) :
+    DatabaseGoal(pDatabase)
+  {
+  }
+
+  /**
+   * Describe the goal.
+   */
+  string CornerSymDatabaseGoal::getDescription() const
+  {
+    return "Create a symmetry-reduced database of all corner states.";
+  }
+}
+
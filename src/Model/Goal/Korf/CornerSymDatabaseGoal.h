@@ -0,0 +1,20 @@
+#ifndef _BUSYBIN_CORNER_SYM_DATABASE_GOAL_H_
+#define _BUSYBIN_CORNER_SYM_DATABASE_GOAL_H_
+
+#include "../DatabaseGoal.h"
+#include "../../PatternDatabase/Korf/CornerSymPatternDatabase.h"
+#include <cstddef>
+using std::size_t;
+
+namespace busybin
+{
+  class CornerSymDatabaseGoal : public DatabaseGoal
+  {
+  public:
+    CornerSymDatabaseGoal(CornerSymPatternDatabase* pDatabase);
+    string getDescription() const;
+  };
+}
+
+#endif
+
@@ -4,10 +4,13 @@ namespace busybin
 {
   /**
    * Init, storing a pointer to the database.
-   * @param pDatabase A pointer to a pattern database.
+   * @param pDatabase A pointer to an EdgePatternDatabase.
+   * @param numEdges The number of edges the database tracks.
    */
-  EdgeDatabaseGoal::EdgeDatabaseGoal(EdgePatternDatabase* pDatabase) :
-    DatabaseGoal(pDatabase)
+  EdgeDatabaseGoal::EdgeDatabaseGoal(PatternDatabase* pDatabase,
+    unsigned numEdges) :
+    DatabaseGoal(pDatabase),
+    numEdges(numEdges)
   {
   }
 
@@ -16,7 +19,8 @@ namespace busybin
    */
   string EdgeDatabaseGoal::getDescription() const
   {
-    return "Create a database of 7 of the 12 edge states.";
+    return "Create a database of " + to_string(this->numEdges) +
+      " of the 12 edge states.";
   }
 }
 
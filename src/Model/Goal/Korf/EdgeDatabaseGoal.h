@@ -2,7 +2,10 @@
 #define _BUSYBIN_EDGE_DATABASE_GOAL_H_
 
 #include "../DatabaseGoal.h"
-#include "../../PatternDatabase/Korf/EdgePatternDatabase.h"
+#include "../../PatternDatabase/PatternDatabase.h"
+#include <string>
+using std::string;
+using std::to_string;
 #include <cstddef>
 using std::size_t;
 
@@ -10,8 +13,10 @@ namespace busybin
 {
   class EdgeDatabaseGoal : public DatabaseGoal
   {
+    unsigned numEdges;
+
   public:
-    EdgeDatabaseGoal(EdgePatternDatabase* pDatabase);
+    EdgeDatabaseGoal(PatternDatabase* pDatabase, unsigned numEdges = 7);
     string getDescription() const;
   };
 }
@@ -0,0 +1,22 @@
+#include "EdgeUDSymDatabaseGoal.h"
+
+namespace busybin
+{
+  /**
+   * Init, storing a pointer to the database.
+   * @param pDatabase A pointer to a pattern database.
+   */
+  EdgeUDSymDatabaseGoal::EdgeUDSymDatabaseGoal(EdgeUDSymPatternDatabase* pDatabase) :
+    DatabaseGoal(pDatabase)
+  {
+  }
+
+  /**
+   * Describe the goal.
+   */
+  string EdgeUDSymDatabaseGoal::getDescription() const
+  {
+    return "Create a symmetry-reduced database of the 8 U and D layer edge states.";
+  }
+}
+
@@ -0,0 +1,20 @@
+#ifndef _BUSYBIN_EDGE_UD_SYM_DATABASE_GOAL_H_
+#define _BUSYBIN_EDGE_UD_SYM_DATABASE_GOAL_H_
+
+#include "../DatabaseGoal.h"
+#include "../../PatternDatabase/Korf/EdgeUDSymPatternDatabase.h"
+#include <cstddef>
+using std::size_t;
+
+namespace busybin
+{
+  class EdgeUDSymDatabaseGoal : public DatabaseGoal
+  {
+  public:
+    EdgeUDSymDatabaseGoal(EdgeUDSymPatternDatabase* pDatabase);
+    string getDescription() const;
+  };
+}
+
+#endif
+
@@ -0,0 +1,13 @@
+#include "IndexTwistStore.h"
+
+namespace busybin
+{
+  /**
+   * Init.
+   */
+  IndexTwistStore::IndexTwistStore(RubiksCubeIndexModel& cube) :
+    TwistStore(cube),
+    pIndexCube(&cube)
+  {
+  }
+}
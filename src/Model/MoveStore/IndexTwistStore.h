@@ -0,0 +1,47 @@
+#ifndef _BUSYBIN_INDEX_TWIST_STORE_H_
+#define _BUSYBIN_INDEX_TWIST_STORE_H_
+
+#include "TwistStore.h"
+#include "../RubiksCube.h"
+#include "../RubiksCubeIndexModel.h"
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * The same twists as TwistStore, but for a RubiksCubeIndexModel only.
+   * Moves and inverses go straight to the model's move tables, and the class
+   * is final, so a search that's templated on this store (see
+   * InPlaceIDACubeSearcher) makes direct, inlinable calls instead of virtual
+   * ones.
+   */
+  class IndexTwistStore final : public TwistStore
+  {
+    RubiksCubeIndexModel* pIndexCube;
+
+  public:
+    IndexTwistStore(RubiksCubeIndexModel& cube);
+
+    /**
+     * Move using an index (the index is the MOVE).
+     */
+    void move(uint8_t ind)
+    {
+      this->pIndexCube->applyMove((RubiksCube::MOVE)ind);
+    }
+
+    /**
+     * Undo a move.  The inverse of a quarter turn is the other quarter turn
+     * of the same face; half turns are their own inverses.
+     */
+    void invert(uint8_t ind)
+    {
+      static const uint8_t inverse[3] = {1, 0, 2};
+
+      this->pIndexCube->applyMove(
+        (RubiksCube::MOVE)(ind - ind % 3 + inverse[ind % 3]));
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,283 @@
+#include "PackedCube.h"
+
+#include <type_traits>
+#include <initializer_list>
+
+#if defined(__BMI2__) && defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+namespace busybin
+{
+  static_assert(sizeof(PackedCube) == 16, "PackedCube must be two words.");
+  static_assert(std::is_trivially_copyable<PackedCube>::value,
+    "PackedCube must be trivially copyable.");
+
+  /**
+   * Initialize a solved cube.
+   */
+  PackedCube::PackedCube() :
+    edges(PackedCube::getSolvedEdges()),
+    corners(PackedCube::getSolvedCorners())
+  {
+  }
+
+  /**
+   * Pack an index model.
+   */
+  PackedCube::PackedCube(const RubiksCubeIndexModel& cube) :
+    edges(0),
+    corners(0)
+  {
+    const array<RubiksCubeIndexModel::Cubie, 12>& cubeEdges   = cube.getEdges();
+    const array<RubiksCubeIndexModel::Cubie, 8>&  cubeCorners = cube.getCorners();
+
+    for (unsigned i = 0; i < 12; ++i)
+    {
+      this->edges |= (uint64_t)(cubeEdges[i].index |
+        (cubeEdges[i].orientation << 4)) << (i * 5);
+    }
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+      this->corners |= (uint64_t)(cubeCorners[i].index |
+        (cubeCorners[i].orientation << 3)) << (i * 5);
+    }
+  }
+
+  /**
+   * Pack a model.  Like the RubiksCubeIndexModel, the model must be oriented
+   * with red on top and white up front.
+   */
+  PackedCube::PackedCube(const RubiksCubeModel& cube) :
+    PackedCube(RubiksCubeIndexModel(cube))
+  {
+  }
+
+  /**
+   * Unpack the state into an index model.
+   * @param cube The cube to set up (the cubies are overwritten).
+   */
+  void PackedCube::unpack(RubiksCubeIndexModel& cube) const
+  {
+    for (unsigned i = 0; i < 12; ++i)
+    {
+      cube.setEdge((EDGE)i, this->getEdgeIndex((EDGE)i),
+        this->getEdgeOrientation((EDGE)i));
+    }
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+      cube.setCorner((CORNER)i, this->getCornerIndex((CORNER)i),
+        this->getCornerOrientation((CORNER)i));
+    }
+  }
+
+  /**
+   * Unpack the state into a new index model.
+   */
+  RubiksCubeIndexModel PackedCube::toIndexModel() const
+  {
+    RubiksCubeIndexModel cube;
+
+    this->unpack(cube);
+
+    return cube;
+  }
+
+  /**
+   * Unpack the state into a new model, with red on top and white up front.
+   */
+  RubiksCubeModel PackedCube::toModel() const
+  {
+    return RubiksCubeModel(this->toIndexModel());
+  }
+
+  /**
+   * Get the cubie index of the edge at a position.
+   */
+  uint8_t PackedCube::getEdgeIndex(EDGE ind) const
+  {
+    return (this->edges >> ((unsigned)ind * 5)) & 0xF;
+  }
+
+  /**
+   * Get the orientation of the edge at a position.
+   */
+  uint8_t PackedCube::getEdgeOrientation(EDGE ind) const
+  {
+    return (this->edges >> ((unsigned)ind * 5 + 4)) & 0x1;
+  }
+
+  /**
+   * Get the cubie index of the corner at a position.
+   */
+  uint8_t PackedCube::getCornerIndex(CORNER ind) const
+  {
+    return (this->corners >> ((unsigned)ind * 5)) & 0x7;
+  }
+
+  /**
+   * Get the orientation of the corner at a position.
+   */
+  uint8_t PackedCube::getCornerOrientation(CORNER ind) const
+  {
+    return (this->corners >> ((unsigned)ind * 5 + 3)) & 0x3;
+  }
+
+  /**
+   * Set the edge at a position.
+   * @param ind The position.
+   * @param index The edge cubie, 0-11.
+   * @param orientation The orientation, 0-1.
+   */
+  void PackedCube::setEdge(EDGE ind, uint8_t index, uint8_t orientation)
+  {
+    unsigned shift = (unsigned)ind * 5;
+
+    this->edges = (this->edges & ~((uint64_t)0x1F << shift)) |
+      ((uint64_t)(index | (orientation << 4)) << shift);
+  }
+
+  /**
+   * Set the corner at a position.
+   * @param ind The position.
+   * @param index The corner cubie, 0-7.
+   * @param orientation The orientation, 0-2.
+   */
+  void PackedCube::setCorner(CORNER ind, uint8_t index, uint8_t orientation)
+  {
+    unsigned shift = (unsigned)ind * 5;
+
+    this->corners = (this->corners & ~((uint64_t)0x1F << shift)) |
+      ((uint64_t)(index | (orientation << 3)) << shift);
+  }
+
+  /**
+   * Apply a face twist (L through B2) using the RubiksCubeIndexModel's move
+   * tables.
+   */
+  void PackedCube::applyMove(RubiksCube::MOVE move)
+  {
+    const RubiksCubeIndexModel::MoveTable& table =
+      RubiksCubeIndexModel::getMoveTable(move);
+
+#if defined(__BMI2__) && defined(__SSSE3__)
+    // Deposit each 5-bit cubie in a byte, so that the twist is a byte
+    // shuffle (by the permutation itself) and a byte add.  Lanes past the
+    // last cubie hold garbage, and they're dropped when the bytes are
+    // extracted.
+    const uint64_t BYTE_MASK = 0x1F1F1F1F1F1F1F1Full;
+
+    __m128i edgeBytes = _mm_set_epi64x(
+      _pdep_u64(this->edges >> 40, BYTE_MASK),
+      _pdep_u64(this->edges, BYTE_MASK));
+    __m128i edgePerm  = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(table.edgePerm.data()));
+    __m128i edgeFlip  = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(table.edgeFlip.data()));
+
+    // The flips are 0 or 1, so shifting 16-bit lanes moves each byte's bit
+    // to bit 4 without crossing into the next byte.
+    edgeBytes = _mm_xor_si128(_mm_shuffle_epi8(edgeBytes, edgePerm),
+      _mm_slli_epi16(edgeFlip, 4));
+
+    this->edges =
+      _pext_u64(_mm_cvtsi128_si64(edgeBytes), BYTE_MASK) |
+      (_pext_u64(_mm_cvtsi128_si64(_mm_unpackhi_epi64(edgeBytes, edgeBytes)),
+        0x1F1F1F1Full) << 40);
+
+    // Corner orientations end up in 0-4 (bits 3-5), and 3 is subtracted
+    // from those over 2.
+    __m128i cornerBytes = _mm_cvtsi64_si128(
+      _pdep_u64(this->corners, BYTE_MASK));
+    __m128i cornerPerm  = _mm_loadl_epi64(
+      reinterpret_cast<const __m128i*>(table.cornerPerm.data()));
+    __m128i cornerTwist = _mm_loadl_epi64(
+      reinterpret_cast<const __m128i*>(table.cornerTwist.data()));
+
+    cornerBytes = _mm_add_epi8(_mm_shuffle_epi8(cornerBytes, cornerPerm),
+      _mm_slli_epi16(cornerTwist, 3));
+    cornerBytes = _mm_sub_epi8(cornerBytes, _mm_and_si128(_mm_set1_epi8(3 << 3),
+      _mm_cmpgt_epi8(cornerBytes, _mm_set1_epi8((3 << 3) - 1))));
+
+    this->corners = _pext_u64(_mm_cvtsi128_si64(cornerBytes), BYTE_MASK);
+#else
+    uint64_t oldEdges   = this->edges;
+    uint64_t oldCorners = this->corners;
+
+    this->edges   = 0;
+    this->corners = 0;
+
+    for (unsigned i = 0; i < 12; ++i)
+    {
+      uint64_t edge = (oldEdges >> (table.edgePerm[i] * 5)) & 0x1F;
+
+      this->edges |= (edge ^ (table.edgeFlip[i] << 4)) << (i * 5);
+    }
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+      uint64_t corner = (oldCorners >> (table.cornerPerm[i] * 5)) & 0x1F;
+      uint64_t ori    = (corner >> 3) + table.cornerTwist[i];
+
+      if (ori >= 3)
+        ori -= 3;
+
+      this->corners |= ((corner & 0x7) | (ori << 3)) << (i * 5);
+    }
+#endif
+  }
+
+  /**
+   * Check if the cube is solved.
+   */
+  bool PackedCube::isSolved() const
+  {
+    return this->edges == PackedCube::getSolvedEdges() &&
+      this->corners == PackedCube::getSolvedCorners();
+  }
+
+  /**
+   * Get a 64-bit hash of the state.  It's mixed like
+   * RubiksCubeIndexModel::getHash, but from the packed words, so the two
+   * hashes differ.
+   */
+  uint64_t PackedCube::getHash() const
+  {
+    uint64_t hash = 0;
+
+    for (uint64_t word : {this->edges, this->corners})
+    {
+      hash  = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+      hash ^= hash >> 29;
+    }
+
+    return hash;
+  }
+
+  /**
+   * Check if two states are the same.
+   */
+  bool PackedCube::operator==(const PackedCube& rhs) const
+  {
+    return this->edges == rhs.edges && this->corners == rhs.corners;
+  }
+
+  /**
+   * Check if two states differ.
+   */
+  bool PackedCube::operator!=(const PackedCube& rhs) const
+  {
+    return !(*this == rhs);
+  }
+
+  /**
+   * Order states by their packed words (for sorting and sets).
+   */
+  bool PackedCube::operator<(const PackedCube& rhs) const
+  {
+    return this->edges != rhs.edges ? this->edges < rhs.edges :
+      this->corners < rhs.corners;
+  }
+}
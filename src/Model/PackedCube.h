@@ -0,0 +1,75 @@
+#ifndef _BUSYBIN_PACKED_CUBE_H_
+#define _BUSYBIN_PACKED_CUBE_H_
+
+#include "RubiksCube.h"
+#include "RubiksCubeModel.h"
+#include "RubiksCubeIndexModel.h"
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * A cube state packed in two 64-bit words, for storing many states at
+   * once (search stacks, frontiers, and the like).  It's 16 bytes, where a
+   * RubiksCubeIndexModel is 56 (40 bytes of cubies, the centers, which
+   * never change, and a vtable pointer).  It's trivially copyable, so
+   * containers of them can be copied and written to disk as raw memory.
+   *
+   * Each cubie takes 5 bits, with the same index and orientation as the
+   * RubiksCubeIndexModel.
+   *
+   * edges:   12 x (4-bit index | 1-bit orientation << 4), edge 0 lowest.
+   * corners:  8 x (3-bit index | 2-bit orientation << 3), corner 0 lowest.
+   *
+   * Only face twists (L through B2) can be applied, as with
+   * RubiksCubeIndexModel::applyMove.  Unpack the state to index it or to
+   * apply other moves.
+   */
+  class PackedCube
+  {
+    typedef RubiksCube::EDGE EDGE;
+    typedef RubiksCube::CORNER CORNER;
+
+    uint64_t edges;
+    uint64_t corners;
+
+    static constexpr uint64_t getSolvedEdges(unsigned i = 0)
+    {
+      return i == 12 ? 0 :
+        ((uint64_t)i << (i * 5)) | PackedCube::getSolvedEdges(i + 1);
+    }
+
+    static constexpr uint64_t getSolvedCorners(unsigned i = 0)
+    {
+      return i == 8 ? 0 :
+        ((uint64_t)i << (i * 5)) | PackedCube::getSolvedCorners(i + 1);
+    }
+
+  public:
+    PackedCube();
+    explicit PackedCube(const RubiksCubeIndexModel& cube);
+    explicit PackedCube(const RubiksCubeModel& cube);
+
+    void unpack(RubiksCubeIndexModel& cube) const;
+    RubiksCubeIndexModel toIndexModel() const;
+    RubiksCubeModel toModel() const;
+
+    uint8_t getEdgeIndex(EDGE ind) const;
+    uint8_t getEdgeOrientation(EDGE ind) const;
+    uint8_t getCornerIndex(CORNER ind) const;
+    uint8_t getCornerOrientation(CORNER ind) const;
+    void setEdge(EDGE ind, uint8_t index, uint8_t orientation);
+    void setCorner(CORNER ind, uint8_t index, uint8_t orientation);
+
+    void applyMove(RubiksCube::MOVE move);
+
+    bool isSolved() const;
+    uint64_t getHash() const;
+
+    bool operator==(const PackedCube& rhs) const;
+    bool operator!=(const PackedCube& rhs) const;
+    bool operator<(const PackedCube& rhs) const;
+  };
+}
+
+#endif
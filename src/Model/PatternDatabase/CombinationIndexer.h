@@ -27,6 +27,14 @@ namespace busybin
       }
     }
 
+    /**
+     * Get the number of combinations: NCK.
+     */
+    uint32_t getNumCombinations() const
+    {
+      return this->choices[N][K];
+    }
+
     /**
      * Get the rank of a combination.
      * @param comb A combination array in ascending order.
@@ -49,6 +57,31 @@ namespace busybin
 
       return rank - 1;
     }
+
+    /**
+     * Get the combination with the given rank (the inverse of rank).  The
+     * combination is in ascending order.
+     */
+    array<uint8_t, K> unrank(uint32_t rank) const
+    {
+      // Per rank, nCk - 1 - rank is the sum of ((n-1-c_i)C(k-i)), which is
+      // unique for each combination (the combinatorial number system).  Each
+      // element is the smallest one (after the last) whose term still fits.
+      array<uint8_t, K> comb;
+      uint32_t          remaining = this->choices[N][K] - 1 - rank;
+      uint8_t           c         = 0;
+
+      for (unsigned i = 0; i < K; ++i, ++c)
+      {
+        while (this->choices[N - 1 - c][K - i] > remaining)
+          ++c;
+
+        comb[i]    = c;
+        remaining -= this->choices[N - 1 - c][K - i];
+      }
+
+      return comb;
+    }
   };
 }
 
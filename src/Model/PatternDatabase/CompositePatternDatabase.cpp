@@ -0,0 +1,508 @@
+#include "CompositePatternDatabase.h"
+
+namespace busybin
+{
+  /**
+   * Init with no databases.  Adaptive ordering is on.
+   */
+  CompositePatternDatabase::CompositePatternDatabase() :
+    PatternDatabase(0),
+    numSamples(0),
+    probeOrder(0),
+    adaptive(true),
+    sampleInterval(256),
+    reorderInterval(4096)
+  {
+  }
+
+  /**
+   * Store a database, and return its index.
+   */
+  unsigned CompositePatternDatabase::addDatabaseTerm(PatternDatabase* pDatabase)
+  {
+    this->databases.push_back(pDatabase);
+    this->inflatedDBs.push_back(HugePageBuffer());
+
+    return this->databases.size() - 1;
+  }
+
+  /**
+   * Add a database as its own term (it's combined with the others by max).
+   * Terms are probed in the order they're added until the adaptive ordering
+   * has measured them.  Call before searching.
+   * @param pDatabase The database (it must stay in scope).
+   */
+  void CompositePatternDatabase::addDatabase(PatternDatabase* pDatabase)
+  {
+    this->addAdditiveDatabases({pDatabase});
+  }
+
+  /**
+   * Add a group of databases as one term: the sum of their estimates.  The
+   * sum is only admissible if no move is counted by more than one of the
+   * databases, e.g. databases over disjoint sets of cubies that only count
+   * the moves of their own cubies.  Call before searching.
+   * @param databases The databases (they must stay in scope).
+   */
+  void CompositePatternDatabase::addAdditiveDatabases(
+    const vector<PatternDatabase*>& databases)
+  {
+    if (this->terms.size() == CompositePatternDatabase::MAX_TERMS)
+      throw RubiksCubeException("CompositePatternDatabase: Too many terms.");
+
+    unsigned         termInd = this->terms.size();
+    vector<unsigned> term;
+
+    for (PatternDatabase* pDatabase : databases)
+      term.push_back(this->addDatabaseTerm(pDatabase));
+
+    this->terms.push_back(term);
+
+    // New terms are probed last.
+    this->probeOrder = this->probeOrder | ((uint64_t)termInd << (termInd * 4));
+    this->termStats[termInd].numCutoffs  = 0;
+    this->termStats[termInd].nanoseconds = 0;
+  }
+
+  /**
+   * Get the databases, in the order they were added.
+   */
+  const vector<PatternDatabase*>& CompositePatternDatabase::getDatabases() const
+  {
+    return this->databases;
+  }
+
+  /**
+   * Turn the adaptive probe ordering on or off.  When off, the terms are
+   * probed in the current order (the order they were added, unless they've
+   * already been reordered).
+   * @param adaptive Whether to adapt the order.
+   * @param sampleInterval One in this many lookups is sampled.
+   * @param reorderInterval The terms are reordered after this many samples.
+   */
+  void CompositePatternDatabase::setAdaptiveOrdering(bool adaptive,
+    unsigned sampleInterval, unsigned reorderInterval)
+  {
+    this->adaptive        = adaptive;
+    this->sampleInterval  = sampleInterval;
+    this->reorderInterval = reorderInterval;
+  }
+
+  /**
+   * Get the order the terms are currently probed in, as term indexes (terms
+   * are numbered in the order they were added).
+   */
+  vector<unsigned> CompositePatternDatabase::getProbeOrder() const
+  {
+    vector<unsigned> order;
+    uint64_t         packed = this->probeOrder;
+
+    for (unsigned i = 0; i < this->terms.size(); ++i, packed >>= 4)
+      order.push_back(packed & 0xF);
+
+    return order;
+  }
+
+  /**
+   * Get a term's estimate.  Additive terms stop summing once the bound is
+   * exceeded.
+   */
+  uint8_t CompositePatternDatabase::getTermMoves(const vector<unsigned>& term,
+    const RubiksCube& cube, const uint8_t boundHint,
+    const uint8_t depthHint) const
+  {
+    uint8_t numMoves = 0;
+
+    for (unsigned dbInd : term)
+    {
+      numMoves += this->getDatabaseMoves(dbInd,
+        this->databases[dbInd]->getDatabaseIndex(cube));
+
+      if (numMoves + depthHint > boundHint)
+        break;
+    }
+
+    return numMoves;
+  }
+
+  /**
+   * Get a term's estimate from precomputed database indexes (indexes[i] is
+   * the index into database i).  Additive terms stop summing once the bound
+   * is exceeded.
+   */
+  uint8_t CompositePatternDatabase::getTermMoves(const vector<unsigned>& term,
+    const size_t* indexes, const uint8_t boundHint,
+    const uint8_t depthHint) const
+  {
+    uint8_t numMoves = 0;
+
+    for (unsigned dbInd : term)
+    {
+      numMoves += this->getDatabaseMoves(dbInd, indexes[dbInd]);
+
+      if (numMoves + depthHint > boundHint)
+        break;
+    }
+
+    return numMoves;
+  }
+
+  /**
+   * Get the estimated number of moves it would take to get from a cube state
+   * to a scrambled state.  The estimate is the max of all the terms.
+   */
+  uint8_t CompositePatternDatabase::getNumMoves(const RubiksCube& cube) const
+  {
+    uint8_t max = 0;
+
+    for (const vector<unsigned>& term : this->terms)
+    {
+      uint8_t estMoves = this->getTermMoves(term, cube, 0xFF, 0);
+
+      if (estMoves > max)
+        max = estMoves;
+    }
+
+    return max;
+  }
+
+  /**
+   * Get the estimated number of moves it would take to get from a cube state
+   * to a scrambled state.  This is faster than getNumMoves because as soon as
+   * one of the terms' estimates exceeds the boundHint this method returns.
+   */
+  uint8_t CompositePatternDatabase::getNumMovesEx(const RubiksCube& cube,
+    const uint8_t boundHint, const uint8_t depthHint) const
+  {
+    if (this->isSampled())
+      return this->sampleNumMoves(cube, boundHint, depthHint);
+
+    uint64_t order = this->probeOrder.load(std::memory_order_relaxed);
+    uint8_t  max   = 0;
+
+    // Check the estimated moves from each term, and return it as soon as one
+    // exceeds the bound.
+    for (unsigned i = 0; i < this->terms.size(); ++i, order >>= 4)
+    {
+      uint8_t estMoves = this->getTermMoves(this->terms[order & 0xF], cube,
+        boundHint, depthHint);
+
+      if (estMoves + depthHint > boundHint)
+        return estMoves;
+
+      if (estMoves > max)
+        max = estMoves;
+    }
+
+    // Return the max estimate if none exceeds the bound.
+    return max;
+  }
+
+  /**
+   * Get the estimated number of moves for a batch of cubes.  The terms are
+   * probed in order as in getNumMovesEx, but each term is probed for the
+   * whole batch at once: the database indexes of all the cubes that haven't
+   * exceeded the bound yet are computed and their entries prefetched, then
+   * the entries are read.  The reads don't wait on each other, and no index
+   * is computed for a cube that an earlier term already pruned.  Sampled
+   * cubes are looked up one at a time, as in getNumMovesEx.
+   */
+  void CompositePatternDatabase::getNumMovesBatch(
+    const RubiksCube* const* cubes, const unsigned numCubes,
+    const uint8_t boundHint, const uint8_t depthHint, uint8_t* estMoves) const
+  {
+    if (this->databases.size() > CompositePatternDatabase::MAX_BATCH_DATABASES)
+    {
+      PatternDatabase::getNumMovesBatch(cubes, numCubes, boundHint, depthHint,
+        estMoves);
+      return;
+    }
+
+    size_t            indexes[BATCH_SIZE][MAX_BATCH_DATABASES];
+    unsigned          open[BATCH_SIZE];
+    const RubiksCube* openCubes[BATCH_SIZE];
+    size_t            openIndexes[BATCH_SIZE];
+
+    for (unsigned first = 0; first < numCubes; first += BATCH_SIZE)
+    {
+      const RubiksCube* const* batch     = cubes + first;
+      uint8_t*                 batchEst  = estMoves + first;
+      unsigned                 batchSize = numCubes - first < BATCH_SIZE ?
+        numCubes - first : BATCH_SIZE;
+      unsigned                 numOpen   = 0;
+
+      for (unsigned i = 0; i < batchSize; ++i)
+      {
+        if (this->isSampled())
+          batchEst[i] = this->sampleNumMoves(*batch[i], boundHint, depthHint);
+        else
+        {
+          batchEst[i]     = 0;
+          open[numOpen++] = i;
+        }
+      }
+
+      uint64_t order = this->probeOrder.load(std::memory_order_relaxed);
+
+      for (unsigned t = 0; t < this->terms.size() && numOpen != 0;
+        ++t, order >>= 4)
+      {
+        const vector<unsigned>& term = this->terms[order & 0xF];
+
+        // The open cubes are indexed together, which lets the databases
+        // rank them with SIMD instructions.
+        for (unsigned j = 0; j < numOpen; ++j)
+          openCubes[j] = batch[open[j]];
+
+        for (unsigned dbInd : term)
+        {
+          this->databases[dbInd]->getDatabaseIndexes(openCubes, numOpen,
+            openIndexes);
+
+          for (unsigned j = 0; j < numOpen; ++j)
+          {
+            indexes[open[j]][dbInd] = openIndexes[j];
+            this->prefetchDatabaseMoves(dbInd, openIndexes[j]);
+          }
+        }
+
+        // Cubes whose estimate exceeds the bound are done.
+        unsigned numStillOpen = 0;
+
+        for (unsigned j = 0; j < numOpen; ++j)
+        {
+          unsigned i        = open[j];
+          uint8_t  estMoves = this->getTermMoves(term, indexes[i], boundHint,
+            depthHint);
+
+          if (estMoves > batchEst[i])
+            batchEst[i] = estMoves;
+
+          if (estMoves + depthHint <= boundHint)
+            open[numStillOpen++] = i;
+        }
+
+        numOpen = numStillOpen;
+      }
+    }
+  }
+
+  /**
+   * Returns true if this lookup should be sampled: one in sampleInterval
+   * lookups when the ordering is adaptive.
+   */
+  bool CompositePatternDatabase::isSampled() const
+  {
+    // Shared by all composites on the thread; it only spaces out the
+    // samples.
+    static thread_local unsigned numLookups = 0;
+
+    if (!this->adaptive || ++numLookups < this->sampleInterval)
+      return false;
+
+    numLookups = 0;
+    return true;
+  }
+
+  /**
+   * Probe every term, timing each and counting the ones that exceed the
+   * bound, and reorder the terms every reorderInterval samples.  Returns the
+   * max estimate.
+   */
+  uint8_t CompositePatternDatabase::sampleNumMoves(const RubiksCube& cube,
+    const uint8_t boundHint, const uint8_t depthHint) const
+  {
+    uint8_t max = 0;
+
+    for (unsigned i = 0; i < this->terms.size(); ++i)
+    {
+      clock::time_point start    = clock::now();
+      uint8_t           estMoves = this->getTermMoves(this->terms[i], cube,
+        0xFF, 0);
+      clock::time_point end      = clock::now();
+
+      this->termStats[i].nanoseconds.fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+        std::memory_order_relaxed);
+
+      if (estMoves + depthHint > boundHint)
+        this->termStats[i].numCutoffs.fetch_add(1, std::memory_order_relaxed);
+
+      if (estMoves > max)
+        max = estMoves;
+    }
+
+    if (this->numSamples.fetch_add(1, std::memory_order_relaxed) + 1 >=
+      this->reorderInterval)
+    {
+      this->numSamples = 0;
+      this->reorder();
+    }
+
+    return max;
+  }
+
+  /**
+   * Order the terms by their measured cost per cutoff, cheapest first.  If
+   * the terms were independent, that would minimize the expected cost of a
+   * lookup.  The measurements are then halved, so the order follows the
+   * search as it goes deeper.
+   */
+  void CompositePatternDatabase::reorder() const
+  {
+    vector<double>   costs(this->terms.size());
+    vector<unsigned> order(this->terms.size());
+
+    for (unsigned i = 0; i < this->terms.size(); ++i)
+    {
+      unsigned long long numCutoffs  = this->termStats[i].numCutoffs;
+      unsigned long long nanoseconds = this->termStats[i].nanoseconds;
+
+      // Terms that never prune go last, cheapest first.
+      costs[i] = numCutoffs == 0 ? 1e18 + nanoseconds :
+        (double)nanoseconds / numCutoffs;
+      order[i] = i;
+
+      this->termStats[i].numCutoffs  = numCutoffs / 2;
+      this->termStats[i].nanoseconds = nanoseconds / 2;
+    }
+
+    sort(order.begin(), order.end(), [&costs](unsigned lhs, unsigned rhs)
+    {
+      return costs[lhs] < costs[rhs];
+    });
+
+    uint64_t packed = 0;
+
+    for (unsigned i = 0; i < order.size(); ++i)
+      packed |= (uint64_t)order[i] << (i * 4);
+
+    this->probeOrder.store(packed, std::memory_order_relaxed);
+  }
+
+  /**
+   * Set the number of moves in all databases.  Returns true if any is changed.
+   */
+  bool CompositePatternDatabase::setNumMoves(const RubiksCube& cube,
+    const uint8_t numMoves)
+  {
+    bool changed = false;
+
+    for (PatternDatabase* pDB : this->databases)
+    {
+      if (pDB->setNumMoves(cube, numMoves))
+        changed = true;
+    }
+
+    return changed;
+  }
+
+  /**
+   * Returns true if all databases are full.
+   */
+  bool CompositePatternDatabase::isFull() const
+  {
+    for (const PatternDatabase* pDB : this->databases)
+    {
+      if (!pDB->isFull())
+        return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Inflate all databases for faster access.  Databases added later are read
+   * packed.
+   * @param pThreadPool An optional ThreadPool for inflating in parallel.
+   * @param hugePages Try to put the inflated copies on huge pages.
+   */
+  void CompositePatternDatabase::inflate(ThreadPool* pThreadPool,
+    bool hugePages)
+  {
+    for (unsigned i = 0; i < this->databases.size(); ++i)
+      this->inflatedDBs[i] = this->databases[i]->inflate(pThreadPool, hugePages);
+  }
+
+  /**
+   * Get the inflated copy of a database (empty if it's not inflated).
+   * @param dbInd The database's index, in the order they were added.
+   */
+  const HugePageBuffer& CompositePatternDatabase::getInflatedDatabase(
+    unsigned dbInd) const
+  {
+    return this->inflatedDBs.at(dbInd);
+  }
+
+  /**
+   * Reset all databases.
+   */
+  void CompositePatternDatabase::reset()
+  {
+    for (unsigned i = 0; i < this->databases.size(); ++i)
+    {
+      this->inflatedDBs[i].free();
+      this->databases[i]->reset();
+    }
+  }
+
+  /**
+   * Returns true if all databases are memory mapped.
+   */
+  bool CompositePatternDatabase::isMapped() const
+  {
+    for (const PatternDatabase* pDB : this->databases)
+    {
+      if (!pDB->isMapped())
+        return false;
+    }
+
+    return true;
+  }
+
+  size_t CompositePatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  {
+    throw RubiksCubeException("CompositePatternDatabase::getDatabaseIndex not implemented.");
+  }
+
+  bool CompositePatternDatabase::setNumMoves(const size_t ind, const uint8_t numMoves)
+  {
+    throw RubiksCubeException("CompositePatternDatabase::setNumMoves not implemented.");
+  }
+
+  uint8_t CompositePatternDatabase::getNumMoves(const size_t ind) const
+  {
+    throw RubiksCubeException("CompositePatternDatabase::getNumMoves not implemented.");
+  }
+
+  size_t CompositePatternDatabase::getSize() const
+  {
+    throw RubiksCubeException("CompositePatternDatabase::getSize not implemented.");
+  }
+
+  size_t CompositePatternDatabase::getNumItems() const
+  {
+    throw RubiksCubeException("CompositePatternDatabase::getNumItems not implemented.");
+  }
+
+  void CompositePatternDatabase::toFile(const string& filePath) const
+  {
+    throw RubiksCubeException("CompositePatternDatabase::toFile not implemented.");
+  }
+
+  bool CompositePatternDatabase::fromFile(const string& filePath)
+  {
+    throw RubiksCubeException("CompositePatternDatabase::fromFile not implemented.");
+  }
+
+  bool CompositePatternDatabase::mapFile(const string& filePath, bool hugePages)
+  {
+    throw RubiksCubeException("CompositePatternDatabase::mapFile not implemented.");
+  }
+
+  HugePageBuffer CompositePatternDatabase::inflate(ThreadPool* pThreadPool,
+    bool hugePages) const
+  {
+    throw RubiksCubeException("CompositePatternDatabase::inflate not implemented.");
+  }
+}
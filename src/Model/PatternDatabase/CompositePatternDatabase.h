@@ -0,0 +1,157 @@
+#ifndef _BUSYBIN_COMPOSITE_PATTERN_DATABASE_
+#define _BUSYBIN_COMPOSITE_PATTERN_DATABASE_
+
+#include "PatternDatabase.h"
+#include "../RubiksCube.h"
+#include "../../Util/RubiksCubeException.h"
+#include "../../Util/ThreadPool.h"
+#include "../../Util/HugePageBuffer.h"
+#include <cstdint>
+#include <cstddef>
+using std::size_t;
+#include <vector>
+using std::vector;
+#include <array>
+using std::array;
+#include <atomic>
+using std::atomic;
+#include <chrono>
+#include <algorithm>
+using std::sort;
+
+namespace busybin
+{
+  /**
+   * A heuristic composed of any number of pattern databases.  Each term of
+   * the heuristic is either a single database or the sum of a group of
+   * additive databases (databases over disjoint sets of cubies, where each
+   * move is only counted by one of them), and the estimate is the max of the
+   * terms.
+   *
+   * getNumMovesEx returns as soon as one term exceeds the bound, so the order
+   * that the terms are probed in matters.  The order is adapted at runtime:
+   * a sample of the lookups probes every term, timing each and counting how
+   * often it alone would have pruned the node, and the terms are then
+   * ordered by cost per cutoff.  That puts the cheapest, most often pruning
+   * term first.
+   *
+   * getNumMovesBatch looks up a batch of cubes (e.g. all the successors of a
+   * node) one term at a time: the term's entries for every cube are
+   * prefetched before any is read, so the cache misses overlap instead of
+   * stalling the search one after another.
+   */
+  class CompositePatternDatabase : public PatternDatabase
+  {
+  public:
+    // The probe order is packed into 64 bits, 4 bits per term.
+    static const unsigned MAX_TERMS = 16;
+
+    // getNumMovesBatch looks up this many cubes at a time, and falls back to
+    // one at a time when there are more databases than this.
+    static const unsigned BATCH_SIZE          = 18;
+    static const unsigned MAX_BATCH_DATABASES = 8;
+
+  private:
+    typedef std::chrono::steady_clock clock;
+
+    /**
+     * Measurements of a term, taken from the sampled lookups.  These are
+     * shared by all the searching threads, so they're approximate.
+     */
+    struct TermStats
+    {
+      atomic<unsigned long long> numCutoffs;
+      atomic<unsigned long long> nanoseconds;
+    };
+
+    vector<PatternDatabase*> databases;
+    vector<HugePageBuffer>   inflatedDBs;
+
+    // Each term is the indexes of its databases (one unless it's additive).
+    // The measurements and order change during lookups, but they don't
+    // change the estimates.
+    vector<vector<unsigned>>            terms;
+    mutable array<TermStats, MAX_TERMS> termStats;
+    mutable atomic<unsigned long long>  numSamples;
+    mutable atomic<uint64_t>            probeOrder;
+
+    bool     adaptive;
+    unsigned sampleInterval;
+    unsigned reorderInterval;
+
+    unsigned addDatabaseTerm(PatternDatabase* pDatabase);
+    uint8_t getTermMoves(const vector<unsigned>& term, const RubiksCube& cube,
+      const uint8_t boundHint, const uint8_t depthHint) const;
+    uint8_t getTermMoves(const vector<unsigned>& term, const size_t* indexes,
+      const uint8_t boundHint, const uint8_t depthHint) const;
+    bool isSampled() const;
+    uint8_t sampleNumMoves(const RubiksCube& cube, const uint8_t boundHint,
+      const uint8_t depthHint) const;
+    void reorder() const;
+
+  protected:
+    /**
+     * Get the number of moves from one of the databases by index, reading
+     * the inflated copy if there is one.
+     * @param dbInd The database's index, in the order they were added.
+     * @param ind An index into the database.
+     */
+    inline uint8_t getDatabaseMoves(unsigned dbInd, size_t ind) const
+    {
+      return this->inflatedDBs[dbInd].empty() ?
+        this->databases[dbInd]->getNumMoves(ind) :
+        this->inflatedDBs[dbInd][ind];
+    }
+
+    /**
+     * Prefetch an entry of one of the databases (from the inflated copy if
+     * there is one).
+     * @param dbInd The database's index, in the order they were added.
+     * @param ind An index into the database.
+     */
+    inline void prefetchDatabaseMoves(unsigned dbInd, size_t ind) const
+    {
+      if (this->inflatedDBs[dbInd].empty())
+        this->databases[dbInd]->prefetch(ind);
+      else
+        __builtin_prefetch(this->inflatedDBs[dbInd].data() + ind);
+    }
+
+  public:
+    CompositePatternDatabase();
+
+    void addDatabase(PatternDatabase* pDatabase);
+    void addAdditiveDatabases(const vector<PatternDatabase*>& databases);
+    const vector<PatternDatabase*>& getDatabases() const;
+    void setAdaptiveOrdering(bool adaptive, unsigned sampleInterval = 256,
+      unsigned reorderInterval = 4096);
+    vector<unsigned> getProbeOrder() const;
+
+    uint8_t getNumMoves(const RubiksCube& cube) const;
+    uint8_t getNumMovesEx(const RubiksCube& cube,
+      const uint8_t boundHint, const uint8_t depthHint) const;
+    void getNumMovesBatch(const RubiksCube* const* cubes,
+      const unsigned numCubes, const uint8_t boundHint,
+      const uint8_t depthHint, uint8_t* estMoves) const;
+    bool setNumMoves(const RubiksCube& cube, const uint8_t numMoves);
+    bool isFull() const;
+    void inflate(ThreadPool* pThreadPool = nullptr, bool hugePages = false);
+    const HugePageBuffer& getInflatedDatabase(unsigned dbInd) const;
+    void reset();
+    bool isMapped() const;
+
+    // All unimplemented.
+    size_t getDatabaseIndex(const RubiksCube& cube) const;
+    bool setNumMoves(const size_t ind, const uint8_t numMoves);
+    uint8_t getNumMoves(const size_t ind) const;
+    size_t getSize() const;
+    size_t getNumItems() const;
+    void toFile(const string& filePath) const;
+    bool fromFile(const string& filePath);
+    bool mapFile(const string& filePath, bool hugePages = false);
+    HugePageBuffer inflate(ThreadPool* pThreadPool = nullptr,
+      bool hugePages = false) const;
+  };
+}
+
+#endif
@@ -1,5 +1,9 @@
 #include "CornerPatternDatabase.h"
 
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace busybin
 {
   /**
@@ -15,7 +19,7 @@ namespace busybin
   /**
    * Given a cube, get an index into the pattern database.
    */
-  uint32_t CornerPatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  size_t CornerPatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
   {
     typedef RubiksCube::CORNER CORNER;
 
@@ -81,5 +85,132 @@ namespace busybin
     // p * 3^7 + o;
     return rank * 2187 + orientationNum;
   }
-}
 
+  /**
+   * Given a batch of cubes, get an index into the pattern database for each.
+   * The corners are gathered into a structure of arrays (one array per
+   * corner) so that the permutations and orientations can be ranked with
+   * SIMD instructions, several cubes per instruction.
+   */
+  void CornerPatternDatabase::getDatabaseIndexes(const RubiksCube* const* cubes,
+    const unsigned numCubes, size_t* indexes) const
+  {
+    uint8_t                  perms[8][BATCH_SIZE];
+    uint8_t                  orientations[7][BATCH_SIZE];
+    uint32_t                 ranks[BATCH_SIZE];
+    uint32_t                 orientationNums[BATCH_SIZE];
+    array<const uint8_t*, 8> permDigits;
+    array<const uint8_t*, 7> orientationDigits;
+
+    for (unsigned i = 0; i < 8; ++i)
+      permDigits[i] = perms[i];
+
+    for (unsigned i = 0; i < 7; ++i)
+      orientationDigits[i] = orientations[i];
+
+    for (unsigned first = 0; first < numCubes; first += BATCH_SIZE)
+    {
+      unsigned batchSize = numCubes - first < BATCH_SIZE ?
+        numCubes - first : BATCH_SIZE;
+
+      unsigned c = 0;
+
+#if defined(__SSE2__)
+      // The corners of a cube are 16 bytes (index, orientation pairs), so 8
+      // cubes are an 8x16 byte matrix.  It's transposed in registers with
+      // three rounds of unpacks, leaving corner i's indexes in the low half
+      // of row i and its orientations in the high half.
+      for (; c + 8 <= batchSize; c += 8)
+      {
+        __m128i x[8];
+        __m128i t[8];
+
+        for (unsigned j = 0; j < 8; ++j)
+        {
+          const RubiksCubeIndexModel& iCube =
+            static_cast<const RubiksCubeIndexModel&>(*cubes[first + c + j]);
+
+          x[j] = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(iCube.getCorners().data()));
+        }
+
+        for (unsigned j = 0; j < 8; j += 2)
+        {
+          t[j / 2]     = _mm_unpacklo_epi8(x[j], x[j + 1]);
+          t[j / 2 + 4] = _mm_unpackhi_epi8(x[j], x[j + 1]);
+        }
+
+        for (unsigned j = 0; j < 8; j += 2)
+        {
+          x[j / 2]     = _mm_unpacklo_epi16(t[j], t[j + 1]);
+          x[j / 2 + 4] = _mm_unpackhi_epi16(t[j], t[j + 1]);
+        }
+
+        for (unsigned j = 0; j < 8; j += 2)
+        {
+          t[j / 2]     = _mm_unpacklo_epi32(x[j], x[j + 1]);
+          t[j / 2 + 4] = _mm_unpackhi_epi32(x[j], x[j + 1]);
+        }
+
+        // The rows come out in the order 0 4 2 6 1 5 3 7: row j holds the
+        // corner with j's bits reversed.
+        for (unsigned j = 0; j < 8; ++j)
+        {
+          unsigned corner = ((j & 1) << 2) | (j & 2) | (j >> 2);
+
+          _mm_storel_epi64(reinterpret_cast<__m128i*>(perms[corner] + c), t[j]);
+
+          if (corner < 7)
+          {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(orientations[corner] + c),
+              _mm_unpackhi_epi64(t[j], t[j]));
+          }
+        }
+      }
+#endif
+
+      for (; c < batchSize; ++c)
+      {
+        const array<RubiksCubeIndexModel::Cubie, 8>& cubies =
+          static_cast<const RubiksCubeIndexModel&>(*cubes[first + c]).getCorners();
+
+        for (unsigned i = 0; i < 8; ++i)
+          perms[i][c] = cubies[i].index;
+
+        for (unsigned i = 0; i < 7; ++i)
+          orientations[i][c] = cubies[i].orientation;
+      }
+
+      this->permIndexer.rankBatch(permDigits, batchSize, ranks);
+      this->orientationIndexer.rankBatch(orientationDigits, batchSize,
+        orientationNums);
+
+      for (unsigned c = 0; c < batchSize; ++c)
+        indexes[first + c] = (size_t)ranks[c] * 2187 + orientationNums[c];
+    }
+  }
+
+  /**
+   * Set up a cube with the given database index.  The orientation of the 8th
+   * corner is implied by the other 7.
+   */
+  void CornerPatternDatabase::getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+  {
+    typedef RubiksCube::CORNER CORNER;
+
+    perm_t   cornerPerm     = this->permIndexer.unrank(ind / 2187);
+    uint32_t orientationNum = ind % 2187;
+    uint8_t  orientationSum = 0;
+
+    for (int i = 6; i >= 0; --i)
+    {
+      uint8_t orientation = orientationNum % 3;
+
+      cube.setCorner((CORNER)i, cornerPerm[i], orientation);
+      orientationSum += orientation;
+      orientationNum /= 3;
+    }
+
+    cube.setCorner(CORNER::DRF, cornerPerm[7], (3 - orientationSum % 3) % 3);
+  }
+}
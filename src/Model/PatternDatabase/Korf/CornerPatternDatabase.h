@@ -5,6 +5,7 @@
 #include "../../RubiksCubeIndexModel.h"
 #include "../PatternDatabase.h"
 #include "../PermutationIndexer.h"
+#include "../OrientationIndexer.h"
 #include <cstdint>
 
 namespace busybin
@@ -18,11 +19,18 @@ namespace busybin
     typedef array<uint8_t, 8> perm_t;
     typedef RubiksCube::FACE F;
 
-    PermutationIndexer<8> permIndexer;
+    // The number of cubes ranked together by getDatabaseIndexes.
+    static const unsigned BATCH_SIZE = 32;
+
+    PermutationIndexer<8>    permIndexer;
+    OrientationIndexer<7, 3> orientationIndexer;
 
   public:
     CornerPatternDatabase();
-    uint32_t getDatabaseIndex(const RubiksCube& cube) const;
+    size_t getDatabaseIndex(const RubiksCube& cube) const;
+    void getDatabaseIndexes(const RubiksCube* const* cubes,
+      const unsigned numCubes, size_t* indexes) const;
+    void getCube(const size_t ind, RubiksCubeIndexModel& cube) const;
   };
 }
 
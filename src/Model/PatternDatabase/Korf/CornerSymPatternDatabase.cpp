@@ -0,0 +1,185 @@
+#include "CornerSymPatternDatabase.h"
+
+namespace busybin
+{
+  /**
+   * Initialize the database storage and the symmetry class tables.  The
+   * representative of each class is the permutation with the lowest rank.
+   */
+  CornerSymPatternDatabase::CornerSymPatternDatabase() :
+    PatternDatabase(NUM_CLASSES * 2187),
+    pSymmetries(&CubeSymmetries::getInstance()),
+    permClasses(40320, 0xFFFF),
+    permSymmetries(40320, 0),
+    classReps(NUM_CLASSES, 0xFFFFFFFF),
+    classStabilizers(NUM_CLASSES)
+  {
+    perm_t   ori        = {0, 0, 0, 0, 0, 0, 0, 0};
+    uint16_t numClasses = 0;
+
+    for (uint32_t rank = 0; rank < 40320; ++rank)
+    {
+      // Only representatives start a new class; every other permutation
+      // is reached from its (lower ranked) representative.
+      if (this->permClasses[rank] != 0xFFFF)
+        continue;
+
+      perm_t perm = this->permIndexer.unrank(rank);
+
+      for (unsigned s = 0; s < CubeSymmetries::NUM_SYMMETRIES; ++s)
+      {
+        perm_t symPerm;
+        perm_t symOri;
+
+        this->pSymmetries->conjugateCorners(s, perm, ori, symPerm, symOri);
+
+        uint32_t symRank = this->permIndexer.rank(symPerm);
+
+        // Every permutation that is symmetric to the representative joins
+        // its class.
+        if (this->permClasses[symRank] == 0xFFFF)
+          this->permClasses[symRank] = numClasses;
+      }
+
+      ++numClasses;
+    }
+
+    if (numClasses != NUM_CLASSES)
+      throw RubiksCubeException("CornerSymPatternDatabase: unexpected number of classes.");
+
+    for (uint32_t rank = 0; rank < 40320; ++rank)
+    {
+      if (this->classReps[this->permClasses[rank]] == 0xFFFFFFFF)
+        this->classReps[this->permClasses[rank]] = rank;
+    }
+
+    // For each permutation, the first symmetry that takes it to its class
+    // representative (the identity for the representatives themselves).
+    for (uint32_t rank = 0; rank < 40320; ++rank)
+    {
+      perm_t   perm = this->permIndexer.unrank(rank);
+      uint32_t rep  = this->classReps[this->permClasses[rank]];
+
+      for (unsigned s = 0; s < CubeSymmetries::NUM_SYMMETRIES; ++s)
+      {
+        perm_t symPerm;
+        perm_t symOri;
+
+        this->pSymmetries->conjugateCorners(s, perm, ori, symPerm, symOri);
+
+        if (this->permIndexer.rank(symPerm) == rep)
+        {
+          this->permSymmetries[rank] = s;
+          break;
+        }
+      }
+    }
+
+    for (uint16_t c = 0; c < NUM_CLASSES; ++c)
+    {
+      perm_t perm = this->permIndexer.unrank(this->classReps[c]);
+
+      for (unsigned s = 1; s < CubeSymmetries::NUM_SYMMETRIES; ++s)
+      {
+        perm_t symPerm;
+        perm_t symOri;
+
+        this->pSymmetries->conjugateCorners(s, perm, ori, symPerm, symOri);
+
+        if (symPerm == perm)
+          this->classStabilizers[c].push_back(s);
+      }
+    }
+  }
+
+  /**
+   * Get the orientation number of the first 7 corners (as a base-3 number).
+   */
+  uint32_t CornerSymPatternDatabase::getOrientationNum(const perm_t& ori) const
+  {
+    return
+      ori[0] * 729 +
+      ori[1] * 243 +
+      ori[2] * 81 +
+      ori[3] * 27 +
+      ori[4] * 9 +
+      ori[5] * 3 +
+      ori[6];
+  }
+
+  /**
+   * Given a cube, get an index into the pattern database.
+   */
+  size_t CornerSymPatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  {
+    typedef RubiksCube::CORNER CORNER;
+
+    const RubiksCubeIndexModel& iCube = static_cast<const RubiksCubeIndexModel&>(cube);
+
+    perm_t perm;
+    perm_t ori;
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+      perm[i] = iCube.getCornerIndex((CORNER)i);
+      ori[i]  = iCube.getCornerOrientation((CORNER)i);
+    }
+
+    uint32_t rank = this->permIndexer.rank(perm);
+
+    // Conjugate to the class representative, then only the orientations are
+    // left to index (as in CornerPatternDatabase).
+    perm_t symPerm;
+    perm_t symOri;
+
+    this->pSymmetries->conjugateCorners(this->permSymmetries[rank], perm, ori,
+      symPerm, symOri);
+
+    uint16_t classInd       = this->permClasses[rank];
+    uint32_t orientationNum = this->getOrientationNum(symOri);
+
+    // If the representative is self-symmetric, pick the lowest orientation
+    // number of the equivalent scrambles.
+    for (uint8_t s : this->classStabilizers[classInd])
+    {
+      perm_t stabPerm;
+      perm_t stabOri;
+
+      this->pSymmetries->conjugateCorners(s, symPerm, symOri, stabPerm, stabOri);
+
+      uint32_t stabOrientationNum = this->getOrientationNum(stabOri);
+
+      if (stabOrientationNum < orientationNum)
+        orientationNum = stabOrientationNum;
+    }
+
+    return classInd * 2187 + orientationNum;
+  }
+
+  /**
+   * Set up a cube with the given database index.  The corners are put in the
+   * class representative's permutation, so the orientations can be read
+   * straight off the index.  For a self-symmetric representative, only the
+   * lowest of the equivalent indexes is ever used, and the others don't map
+   * back to themselves.
+   */
+  void CornerSymPatternDatabase::getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+  {
+    typedef RubiksCube::CORNER CORNER;
+
+    perm_t   perm           = this->permIndexer.unrank(this->classReps[ind / 2187]);
+    uint32_t orientationNum = ind % 2187;
+    uint8_t  orientationSum = 0;
+
+    for (int i = 6; i >= 0; --i)
+    {
+      uint8_t orientation = orientationNum % 3;
+
+      cube.setCorner((CORNER)i, perm[i], orientation);
+      orientationSum += orientation;
+      orientationNum /= 3;
+    }
+
+    cube.setCorner(CORNER::DRF, perm[7], (3 - orientationSum % 3) % 3);
+  }
+}
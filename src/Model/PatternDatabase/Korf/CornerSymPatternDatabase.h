@@ -0,0 +1,56 @@
+#ifndef _BUSYBIN_CORNER_SYM_PATTERN_DATABASE_
+#define _BUSYBIN_CORNER_SYM_PATTERN_DATABASE_
+
+#include "../../RubiksCube.h"
+#include "../../RubiksCubeIndexModel.h"
+#include "../../Symmetry/CubeSymmetries.h"
+#include "../PatternDatabase.h"
+#include "../PermutationIndexer.h"
+#include <cstdint>
+#include <vector>
+using std::vector;
+
+namespace busybin
+{
+  /**
+   * A symmetry-reduced version of the CornerPatternDatabase.  The 8! corner
+   * permutations fall into 984 classes under the 48 cube symmetries.  Each
+   * scramble is conjugated by a symmetry that takes its corner permutation to
+   * the class representative, and the index is the class times 3^7 plus the
+   * conjugated corner orientations.  That's 984*3^7 entries (~1MB) rather
+   * than 8!*3^7 (~42MB).
+   *
+   * Some representatives are symmetric to themselves, in which case several
+   * symmetries take a scramble to the representative; the one that gives
+   * the lowest orientation number is used so that symmetric scrambles always
+   * share an index.
+   */
+  class CornerSymPatternDatabase : public PatternDatabase
+  {
+    typedef array<uint8_t, 8> perm_t;
+
+    const CubeSymmetries* pSymmetries;
+    PermutationIndexer<8> permIndexer;
+
+    // The class of each corner permutation rank, and the symmetry that
+    // takes the permutation to the class representative.
+    vector<uint16_t> permClasses;
+    vector<uint8_t>  permSymmetries;
+
+    // The rank of each class's representative, and the symmetries (other
+    // than the identity) that map the representative onto itself.
+    vector<uint32_t>         classReps;
+    vector<vector<uint8_t> > classStabilizers;
+
+    uint32_t getOrientationNum(const perm_t& ori) const;
+
+  public:
+    enum { NUM_CLASSES = 984 };
+
+    CornerSymPatternDatabase();
+    size_t getDatabaseIndex(const RubiksCube& cube) const;
+    void getCube(const size_t ind, RubiksCubeIndexModel& cube) const;
+  };
+}
+
+#endif
@@ -1,10 +1,7 @@
 #ifndef _BUSYBIN_EDGE_G1_PATTERN_DATABASE_
 #define _BUSYBIN_EDGE_G1_PATTERN_DATABASE_
 
-#include "../../RubiksCube.h"
-#include "../../RubiksCubeIndexModel.h"
 #include "EdgePatternDatabase.h"
-#include <cstdint>
 
 namespace busybin
 {
@@ -13,10 +10,10 @@ namespace busybin
    * the number of moves required to get the edges to the solved state.  The 7
    * edges are UB, UR, UF, UL, FR, FL, and BL.
    */
-  class EdgeG1PatternDatabase : public EdgePatternDatabase
+  class EdgeG1PatternDatabase : public EdgePatternDatabase<7>
   {
   public:
-    uint32_t getDatabaseIndex(const RubiksCube& cube) const;
+    EdgeG1PatternDatabase();
   };
 }
 
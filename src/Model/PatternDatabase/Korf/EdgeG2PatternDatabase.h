@@ -1,10 +1,7 @@
 #ifndef _BUSYBIN_EDGE_G2_PATTERN_DATABASE_
 #define _BUSYBIN_EDGE_G2_PATTERN_DATABASE_
 
-#include "../../RubiksCube.h"
-#include "../../RubiksCubeIndexModel.h"
 #include "EdgePatternDatabase.h"
-#include <cstdint>
 
 namespace busybin
 {
@@ -12,10 +9,10 @@ namespace busybin
    * See EdgeG1PatternDatabase.h.  This indexes the other 7 edges: FL, BL, BR, DF,
    * DL, DB, and DR.
    */
-  class EdgeG2PatternDatabase : public EdgePatternDatabase
+  class EdgeG2PatternDatabase : public EdgePatternDatabase<7>
   {
   public:
-    uint32_t getDatabaseIndex(const RubiksCube& cube) const;
+    EdgeG2PatternDatabase();
   };
 }
 
@@ -2,28 +2,241 @@
 #define _BUSYBIN_EDGE_PATTERN_DATABASE_
 
 #include "../../RubiksCube.h"
+#include "../../RubiksCubeIndexModel.h"
 #include "../PatternDatabase.h"
 #include "../PermutationIndexer.h"
+#include "../OrientationIndexer.h"
+#include "../../../Util/math.h"
+#include "../../../Util/RubiksCubeException.h"
 #include <cstdint>
+#include <cstddef>
+using std::size_t;
+#include <array>
+using std::array;
+#include <vector>
+using std::vector;
 
 namespace busybin
 {
   /**
-   * A base class for the two edge pattern databases.
+   * A database for K of the 12 edges that indexes edge positions and
+   * orientations and the number of moves required to get the edges to the
+   * solved state.  Which edges are tracked is set on construction, so the
+   * edges can be partitioned into any number of databases of any size.
+   * Each database holds 12PK * 2^K entries: 7 edges take ~244MB, 8 edges
+   * ~2.4GB, and 9 edges ~19GB.
    */
+  template <size_t K>
   class EdgePatternDatabase : public PatternDatabase
   {
-    PermutationIndexer<12, 7> permIndexer;
+    // The number of cubes ranked together by getDatabaseIndexes.
+    static const unsigned BATCH_SIZE = 32;
 
-  protected:
-    typedef array<uint8_t, 7> perm_t;
-    typedef RubiksCube::FACE F;
+    PermutationIndexer<12, K> permIndexer;
+    OrientationIndexer<K, 2>  orientationIndexer;
+
+    // The tracked edges, and the reverse: each edge's slot in the
+    // permutation (0xFF for edges that aren't tracked).
+    array<uint8_t, K>  edges;
+    array<uint8_t, 12> slots;
 
-    uint32_t getDatabaseIndex(const perm_t& edgePerm,
-      const array<uint8_t, 7>& edgeOrientations) const;
   public:
-    EdgePatternDatabase();
-    virtual uint32_t getDatabaseIndex(const RubiksCube& cube) const = 0;
+    typedef array<uint8_t, K> perm_t;
+
+    /**
+     * Initialize the database storage.  There are 12PK * 2^K possible
+     * scrambles (K cubies occupying 12 positions, and each cubie can be in 1
+     * of 2 states).  Each move count is stored in 4 bits.
+     * @param edges The K edges to track, numbered 0-11 (see
+     * RubiksCube::EDGE).
+     */
+    EdgePatternDatabase(const vector<uint8_t>& edges) :
+      PatternDatabase(EdgePatternDatabase::getNumStates())
+    {
+      if (edges.size() != K)
+        throw RubiksCubeException("EdgePatternDatabase: Wrong number of edges.");
+
+      this->slots.fill(0xFF);
+
+      for (uint8_t i = 0; i < K; ++i)
+      {
+        if (edges[i] > 11 || this->slots[edges[i]] != 0xFF)
+          throw RubiksCubeException("EdgePatternDatabase: Invalid edge set.");
+
+        this->edges[i]        = edges[i];
+        this->slots[edges[i]] = i;
+      }
+    }
+
+    /**
+     * Get the number of entries in a K-edge database: 12PK * 2^K.
+     */
+    static size_t getNumStates()
+    {
+      return (size_t)pick(12, K) << K;
+    }
+
+    /**
+     * Get the tracked edges.
+     */
+    const array<uint8_t, K>& getEdges() const
+    {
+      return this->edges;
+    }
+
+    /**
+     * Given an permutation of edge indexes and an array of edge orientations,
+     * calculate a unique index into the pattern database.
+     * @param edgePerm An array of K edges positions, numbered 0-11 (K edges
+     * could occupy 12 places).
+     * @param edgeOrientations An array of edge orientations, numbered 0-1
+     * (each edge can be in one of two orientations).
+     */
+    size_t getDatabaseIndex(const perm_t& edgePerm,
+      const perm_t& edgeOrientations) const
+    {
+      // Rank the permutation using by creating a Lehmer code and converting
+      // it to a base-10 number.
+      //
+      // This differs from the corner conversion, because the K edges could
+      // occupy 12 positions.  E.g. with 7 edges there are 12 pick 7 (12P7)
+      // possible permutations, which is 12!/(12-7)! = 3,991,680.  Each digit
+      // in the Lehmer code is thus multipled by the number of partial
+      // permutations that preceed it.  See CornerPatternDatabase.cpp for an
+      // explanation.
+      size_t rank = this->permIndexer.rank(edgePerm);
+
+      // Treat the orientations as a base-2 number, and convert it
+      // to base-10.
+      size_t orientationNum = 0;
+
+      for (uint8_t i = 0; i < K; ++i)
+        orientationNum = (orientationNum << 1) | edgeOrientations[i];
+
+      // Combine the permutation and orientation into a single index.
+      // p * 2^K + o;
+      return (rank << K) | orientationNum;
+    }
+
+    /**
+     * Given a cube, get an index into the pattern database.
+     */
+    size_t getDatabaseIndex(const RubiksCube& cube) const
+    {
+      typedef RubiksCube::EDGE EDGE;
+
+      const RubiksCubeIndexModel& iCube = static_cast<const RubiksCubeIndexModel&>(cube);
+
+      // Create a permutation array consisting of the K tracked edges by
+      // looping over all edge positions until all K are found.  The
+      // permutation is made up of the edges' positions, 0-11.
+      perm_t   edgePerm;
+      perm_t   edgeOrientations;
+      unsigned numIndexed = 0;
+
+      for (uint8_t i = 0; i < 12 && numIndexed != K; ++i)
+      {
+        uint8_t slot = this->slots[iCube.getEdgeIndex((EDGE)i)];
+
+        if (slot != 0xFF)
+        {
+          edgePerm[slot]         = i;
+          edgeOrientations[slot] = iCube.getEdgeOrientation((EDGE)i);
+          ++numIndexed;
+        }
+      }
+
+      return this->getDatabaseIndex(edgePerm, edgeOrientations);
+    }
+
+    /**
+     * Given a batch of cubes, get an index into the pattern database for
+     * each.  The tracked edges are gathered into a structure of arrays (one
+     * array per slot) so that the permutations and orientations can be
+     * ranked with SIMD instructions, several cubes per instruction.
+     */
+    void getDatabaseIndexes(const RubiksCube* const* cubes,
+      const unsigned numCubes, size_t* indexes) const
+    {
+      // The last row of each takes the untracked edges.
+      uint8_t                  perms[K + 1][BATCH_SIZE];
+      uint8_t                  orientations[K + 1][BATCH_SIZE];
+      uint32_t                 ranks[BATCH_SIZE];
+      uint32_t                 orientationNums[BATCH_SIZE];
+      array<const uint8_t*, K> permDigits;
+      array<const uint8_t*, K> orientationDigits;
+
+      for (unsigned i = 0; i < K; ++i)
+      {
+        permDigits[i]        = perms[i];
+        orientationDigits[i] = orientations[i];
+      }
+
+      for (unsigned first = 0; first < numCubes; first += BATCH_SIZE)
+      {
+        unsigned batchSize = numCubes - first < BATCH_SIZE ?
+          numCubes - first : BATCH_SIZE;
+
+        for (unsigned c = 0; c < batchSize; ++c)
+        {
+          const array<RubiksCubeIndexModel::Cubie, 12>& cubies =
+            static_cast<const RubiksCubeIndexModel&>(*cubes[first + c]).getEdges();
+
+          // Without a branch on whether each edge is tracked: which edges
+          // are tracked is unpredictable.
+          for (uint8_t i = 0; i < 12; ++i)
+          {
+            uint8_t slot = this->slots[cubies[i].index];
+            uint8_t row  = slot == 0xFF ? K : slot;
+
+            perms[row][c]        = i;
+            orientations[row][c] = cubies[i].orientation;
+          }
+        }
+
+        this->permIndexer.rankBatch(permDigits, batchSize, ranks);
+        this->orientationIndexer.rankBatch(orientationDigits, batchSize,
+          orientationNums);
+
+        for (unsigned c = 0; c < batchSize; ++c)
+          indexes[first + c] = ((size_t)ranks[c] << K) | orientationNums[c];
+      }
+    }
+
+    /**
+     * Set up a cube with the given database index (the inverse of
+     * getDatabaseIndex).  The other edges fill the remaining positions.
+     * @param ind An index into the database.
+     * @param cube The cube to set up.
+     */
+    void getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+    {
+      typedef RubiksCube::EDGE EDGE;
+
+      perm_t   edgePerm       = this->permIndexer.unrank(ind >> K);
+      size_t   orientationNum = ind & (((size_t)1 << K) - 1);
+      unsigned occupied       = 0;
+
+      for (uint8_t i = 0; i < K; ++i)
+      {
+        cube.setEdge((EDGE)edgePerm[i], this->edges[i],
+          (orientationNum >> (K - 1 - i)) & 1);
+        occupied |= 1 << edgePerm[i];
+      }
+
+      uint8_t edge = 0;
+
+      for (uint8_t i = 0; i < 12; ++i)
+      {
+        if (!((occupied >> i) & 1))
+        {
+          while (this->slots[edge] != 0xFF)
+            ++edge;
+
+          cube.setEdge((EDGE)i, edge++, 0);
+        }
+      }
+    }
   };
 }
 
@@ -14,7 +14,7 @@ namespace busybin
   /**
    * Given a cube, get an index into the pattern database.
    */
-  uint32_t EdgePermutationPatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  size_t EdgePermutationPatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
   {
     typedef RubiksCube::EDGE EDGE;
 
@@ -29,5 +29,18 @@ namespace busybin
     // Lehmer code->rank (see CornerPatternDatabase.cpp).
     return this->permIndexer.rank(edgePerm);
   }
-}
 
+  /**
+   * Set up a cube with the given database index.  The database doesn't
+   * track orientation, so all the edges are left unflipped.
+   */
+  void EdgePermutationPatternDatabase::getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+  {
+    typedef RubiksCube::EDGE EDGE;
+
+    perm_t edgePerm = this->permIndexer.unrank(ind);
+
+    for (unsigned i = 0; i < 12; ++i)
+      cube.setEdge((EDGE)i, edgePerm[i], 0);
+  }
+}
@@ -0,0 +1,218 @@
+#include "EdgeUDSymPatternDatabase.h"
+
+namespace busybin
+{
+  namespace
+  {
+    // Bitmask of the U and D layer edges (and, in the solved state, their
+    // positions).
+    const unsigned UD_EDGES = 0xF0F;
+  }
+
+  /**
+   * Initialize the database storage and the set class tables.  The
+   * representative of each class is the set with the lowest bitmask.
+   */
+  EdgeUDSymPatternDatabase::EdgeUDSymPatternDatabase() :
+    PatternDatabase((size_t)NUM_CLASSES * 40320 * 256),
+    pSymmetries(&CubeSymmetries::getInstance())
+  {
+    uint8_t numClasses = 0;
+
+    this->setClasses.fill(0xFF);
+    this->setSymmetries.fill(0);
+    this->setReps.fill(0);
+
+    for (unsigned mask = 0; mask < 4096; ++mask)
+    {
+      if (__builtin_popcount(mask) != 8 || this->setClasses[mask] != 0xFF)
+        continue;
+
+      if (numClasses == NUM_CLASSES)
+        throw RubiksCubeException("EdgeUDSymPatternDatabase: unexpected number of classes.");
+
+      // mask is the representative of a new class.  Each set in the class
+      // gets the first symmetry that takes it back to mask.
+      for (unsigned s = 0; s < CubeSymmetries::NUM_UD_SYMMETRIES; ++s)
+      {
+        const CubeSymmetries::Symmetry& sym = this->pSymmetries->getSymmetry(s);
+        unsigned symMask = 0;
+
+        for (unsigned i = 0; i < 12; ++i)
+        {
+          if ((mask >> i) & 1)
+            symMask |= 1 << sym.edgePos[i];
+        }
+
+        if (this->setClasses[symMask] == 0xFF)
+        {
+          this->setClasses[symMask] = numClasses;
+          this->setReps[symMask]    = mask;
+        }
+      }
+
+      this->classReps[numClasses++] = mask;
+    }
+
+    if (numClasses != NUM_CLASSES)
+      throw RubiksCubeException("EdgeUDSymPatternDatabase: unexpected number of classes.");
+
+    for (unsigned mask = 0; mask < 4096; ++mask)
+    {
+      if (this->setClasses[mask] == 0xFF)
+        continue;
+
+      for (unsigned s = 0; s < CubeSymmetries::NUM_UD_SYMMETRIES; ++s)
+      {
+        const CubeSymmetries::Symmetry& sym = this->pSymmetries->getSymmetry(s);
+        unsigned symMask = 0;
+
+        for (unsigned i = 0; i < 12; ++i)
+        {
+          if ((mask >> i) & 1)
+            symMask |= 1 << sym.edgePos[i];
+        }
+
+        if (symMask == this->setReps[mask])
+        {
+          this->setSymmetries[mask] = s;
+          break;
+        }
+      }
+    }
+
+    for (uint8_t c = 0; c < NUM_CLASSES; ++c)
+    {
+      unsigned rep = this->classReps[c];
+
+      for (unsigned s = 1; s < CubeSymmetries::NUM_UD_SYMMETRIES; ++s)
+      {
+        const CubeSymmetries::Symmetry& sym = this->pSymmetries->getSymmetry(s);
+        unsigned symMask = 0;
+
+        for (unsigned i = 0; i < 12; ++i)
+        {
+          if ((rep >> i) & 1)
+            symMask |= 1 << sym.edgePos[i];
+        }
+
+        if (symMask == rep)
+          this->classStabilizers[c].push_back(s);
+      }
+    }
+  }
+
+  /**
+   * Given a cube, get an index into the pattern database.
+   */
+  size_t EdgeUDSymPatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  {
+    typedef RubiksCube::EDGE EDGE;
+
+    const RubiksCubeIndexModel& iCube = static_cast<const RubiksCubeIndexModel&>(cube);
+
+    array<uint8_t, 12> perm;
+    array<uint8_t, 12> ori;
+    unsigned           mask = 0;
+
+    for (unsigned i = 0; i < 12; ++i)
+    {
+      perm[i] = iCube.getEdgeIndex((EDGE)i);
+      ori[i]  = iCube.getEdgeOrientation((EDGE)i);
+
+      if ((UD_EDGES >> perm[i]) & 1)
+        mask |= 1 << i;
+    }
+
+    // Conjugate so that the 8 edges occupy the representative set.
+    array<uint8_t, 12> symPerm;
+    array<uint8_t, 12> symOri;
+
+    this->pSymmetries->conjugateEdges(this->setSymmetries[mask], perm, ori,
+      symPerm, symOri);
+
+    uint8_t  classInd = this->setClasses[mask];
+    unsigned rep      = this->setReps[mask];
+    uint32_t setInd   = this->getSetIndex(rep, symPerm, symOri);
+
+    // If the representative set is self-symmetric, pick the lowest index of
+    // the equivalent scrambles.
+    for (uint8_t s : this->classStabilizers[classInd])
+    {
+      array<uint8_t, 12> stabPerm;
+      array<uint8_t, 12> stabOri;
+
+      this->pSymmetries->conjugateEdges(s, symPerm, symOri, stabPerm, stabOri);
+
+      uint32_t stabSetInd = this->getSetIndex(rep, stabPerm, stabOri);
+
+      if (stabSetInd < setInd)
+        setInd = stabSetInd;
+    }
+
+    return (uint32_t)classInd * 40320 * 256 + setInd;
+  }
+
+  /**
+   * Index the order and orientation of the 8 edges within a set of
+   * positions: the rank of the edges' slots (0-7) within the set times 2^8,
+   * plus the orientations.  Edges 8-11 are numbered 4-7.
+   * @param rep The set of positions that the edges occupy.
+   * @param perm The edge permutation.
+   * @param ori The edge orientations.
+   */
+  uint32_t EdgeUDSymPatternDatabase::getSetIndex(unsigned rep,
+    const array<uint8_t, 12>& perm, const array<uint8_t, 12>& ori) const
+  {
+    array<uint8_t, 8> edgeSlots;
+    uint32_t          orientationNum = 0;
+    uint8_t           slot           = 0;
+
+    for (unsigned i = 0; i < 12; ++i)
+    {
+      if ((rep >> i) & 1)
+      {
+        uint8_t edge = perm[i] < 4 ? perm[i] : perm[i] - 4;
+
+        edgeSlots[edge] = slot++;
+        orientationNum |= ori[i] << (7 - edge);
+      }
+    }
+
+    return this->permIndexer.rank(edgeSlots) * 256 + orientationNum;
+  }
+
+  /**
+   * Set up a cube with the given database index.  The 8 edges are put in the
+   * class's representative set of positions, and edges 4-7 fill the other
+   * positions.  For a self-symmetric set, only the lowest of the equivalent
+   * indexes is ever used, and the others don't map back to themselves.
+   */
+  void EdgeUDSymPatternDatabase::getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+  {
+    typedef RubiksCube::EDGE EDGE;
+
+    unsigned          rep            = this->classReps[ind / (40320 * 256)];
+    array<uint8_t, 8> edgeSlots      = this->permIndexer.unrank(ind / 256 % 40320);
+    uint32_t          orientationNum = ind % 256;
+
+    // The position of each slot in the set.
+    array<uint8_t, 8> slotPositions;
+    uint8_t           slot      = 0;
+    uint8_t           otherEdge = 4;
+
+    for (uint8_t i = 0; i < 12; ++i)
+    {
+      if ((rep >> i) & 1)
+        slotPositions[slot++] = i;
+      else
+        cube.setEdge((EDGE)i, otherEdge++, 0);
+    }
+
+    for (uint8_t edge = 0; edge < 8; ++edge)
+    {
+      cube.setEdge((EDGE)slotPositions[edgeSlots[edge]],
+        edge < 4 ? edge : edge + 4, (orientationNum >> (7 - edge)) & 1);
+    }
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef _BUSYBIN_EDGE_UD_SYM_PATTERN_DATABASE_
+#define _BUSYBIN_EDGE_UD_SYM_PATTERN_DATABASE_
+
+#include "../../RubiksCube.h"
+#include "../../RubiksCubeIndexModel.h"
+#include "../../Symmetry/CubeSymmetries.h"
+#include "../PatternDatabase.h"
+#include "../PermutationIndexer.h"
+#include <cstdint>
+#include <array>
+using std::array;
+#include <vector>
+using std::vector;
+
+namespace busybin
+{
+  /**
+   * A symmetry-reduced pattern database of the 8 edges in the U and D layers
+   * (edges 0-3 and 8-11), for use in place of the 7-edge databases.
+   *
+   * The 16 symmetries that keep the U-D axis in place map the 8 edges onto
+   * themselves.  The 495 sets of positions that the 8 edges can occupy fall
+   * into 45 classes under those symmetries, so each scramble is conjugated
+   * to put its edges in the representative set of positions.  The index is
+   * then the class, the order of the edges within the set (8!), and their
+   * orientations (2^8): 45*8!*2^8 entries (~221MB), a bit less than one of
+   * the 7-edge databases (12P7*2^7 entries, ~244MB).
+   *
+   * When several symmetries take a scramble to the representative set, the
+   * lowest resulting index is used so that symmetric scrambles always share
+   * an index.
+   */
+  class EdgeUDSymPatternDatabase : public PatternDatabase
+  {
+  public:
+    enum { NUM_CLASSES = 45 };
+
+  private:
+    const CubeSymmetries* pSymmetries;
+    PermutationIndexer<8> permIndexer;
+
+    // By bitmask of occupied positions: the class, the symmetry that takes
+    // the set to the class representative, and the representative.
+    array<uint8_t, 4096>  setClasses;
+    array<uint8_t, 4096>  setSymmetries;
+    array<uint16_t, 4096> setReps;
+
+    // The representative set of each class, and the symmetries (other than
+    // the identity) that map the set onto itself.
+    array<uint16_t, NUM_CLASSES>        classReps;
+    array<vector<uint8_t>, NUM_CLASSES> classStabilizers;
+
+    uint32_t getSetIndex(unsigned rep, const array<uint8_t, 12>& perm,
+      const array<uint8_t, 12>& ori) const;
+
+  public:
+    EdgeUDSymPatternDatabase();
+    size_t getDatabaseIndex(const RubiksCube& cube) const;
+    void getCube(const size_t ind, RubiksCubeIndexModel& cube) const;
+  };
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef _BUSYBIN_ORIENTATION_INDEXER_H_
+#define _BUSYBIN_ORIENTATION_INDEXER_H_
+
+#include <cstdint>
+#include <cstddef>
+using std::size_t;
+#include <array>
+using std::array;
+#include <cstring>
+
+#if defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+namespace busybin
+{
+  /**
+   * Class for indexing the orientations of K cubies, each in one of BASE
+   * orientations (2 for edges, 3 for corners).  The orientations are treated
+   * as a base-BASE number, first cubie most significant.
+   */
+  template <size_t K, uint32_t BASE>
+  class OrientationIndexer
+  {
+  public:
+    /**
+     * The number of orientations: BASE^K.
+     */
+    static constexpr uint32_t getNumOrientations(size_t k = K)
+    {
+      return k == 0 ? 1 : BASE * OrientationIndexer::getNumOrientations(k - 1);
+    }
+
+    /**
+     * Convert the orientations to base-10.
+     */
+    uint32_t rank(const array<uint8_t, K>& orientations) const
+    {
+      uint32_t num = 0;
+
+      for (uint32_t i = 0; i < K; ++i)
+        num = num * BASE + orientations[i];
+
+      return num;
+    }
+
+    /**
+     * Rank a batch of orientations given as a structure of arrays: the
+     * orientation of cubie i in set p is digits[i][p].  See
+     * PermutationIndexer::rankBatch.
+     * @param digits The orientations, K arrays of numSets.
+     * @param numSets The number of sets of orientations.
+     * @param nums Set to the rank of each set.
+     */
+    void rankBatch(const array<const uint8_t*, K>& digits, unsigned numSets,
+      uint32_t* nums) const
+    {
+      unsigned p = 0;
+
+#if defined(__AVX2__)
+      for (; p + 8 <= numSets; p += 8)
+      {
+        __m256i num = _mm256_setzero_si256();
+
+        for (uint32_t i = 0; i < K; ++i)
+        {
+          __m256i digit = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+            reinterpret_cast<const __m128i*>(digits[i] + p)));
+
+          num = _mm256_add_epi32(
+            _mm256_mullo_epi32(num, _mm256_set1_epi32(BASE)), digit);
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(nums + p), num);
+      }
+#endif
+
+#if defined(__SSE4_1__)
+      for (; p + 4 <= numSets; p += 4)
+      {
+        __m128i num = _mm_setzero_si128();
+
+        for (uint32_t i = 0; i < K; ++i)
+        {
+          int32_t packed;
+
+          memcpy(&packed, digits[i] + p, sizeof(packed));
+
+          num = _mm_add_epi32(_mm_mullo_epi32(num, _mm_set1_epi32(BASE)),
+            _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(nums + p), num);
+      }
+#endif
+
+      for (; p < numSets; ++p)
+      {
+        uint32_t num = 0;
+
+        for (uint32_t i = 0; i < K; ++i)
+          num = num * BASE + digits[i][p];
+
+        nums[p] = num;
+      }
+    }
+  };
+}
+
+#endif
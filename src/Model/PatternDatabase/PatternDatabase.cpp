@@ -3,10 +3,12 @@
 namespace busybin
 {
   /**
-   * Initialize the underlying array.
+   * Initialize the underlying array.  No storage is allocated until the
+   * database is indexed in memory or read from a file, so a database that's
+   * mapped or indexed on disk never takes the memory.
    */
   PatternDatabase::PatternDatabase(const size_t size) :
-    database(size, 0xFF), size(size), numItems(0)
+    database(size, 0xFF, false), size(size), numItems(0)
   {
   }
 
@@ -19,8 +21,10 @@ namespace busybin
    * @param numMoves The number of moves to get to this state (must be fewer
    * than 15).
    */
-  bool PatternDatabase::setNumMoves(const uint32_t ind, const uint8_t numMoves) 
+  bool PatternDatabase::setNumMoves(const size_t ind, const uint8_t numMoves) 
   {
+    this->database.allocate();
+
     uint8_t oldNumMoves = this->getNumMoves(ind);
 
     if (oldNumMoves == 0xF)
@@ -35,6 +39,20 @@ namespace busybin
     return false;
   }
 
+  /**
+   * Set the number of moves to get to a scrambled cube state if the state
+   * has not been set.  Unlike setNumMoves this is safe to call from multiple
+   * threads, and it doesn't update the item count (see setNumItems).  Returns
+   * true if the state was set by this call.
+   * @param ind The index in the database.
+   * @param numMoves The number of moves to get to this state (must be fewer
+   * than 15).
+   */
+  bool PatternDatabase::setNumMovesAtomic(const size_t ind, const uint8_t numMoves)
+  {
+    return this->database.compareAndSet(ind, 0xF, numMoves);
+  }
+
   /**
    * Set the number of moves to get to a scrambled cube state.  The index is
    * calculated using the getDatabaseIndex method.
@@ -53,7 +71,7 @@ namespace busybin
    * method.  0xF (15) indicates that the state has not been set.
    * @param cube A cube instance.
    */
-  uint8_t PatternDatabase::getNumMoves(const uint32_t ind) const
+  uint8_t PatternDatabase::getNumMoves(const size_t ind) const
   {
     return this->database.get(ind);
   }
@@ -75,7 +93,7 @@ namespace busybin
    * pattern databases.  For non-aggregate databases this is the same as
    * getNumMoves.
    */
-  uint8_t PatternDatabase::getNumMovesEx(const uint32_t ind,
+  uint8_t PatternDatabase::getNumMovesEx(const size_t ind,
     const uint8_t boundHint, const uint8_t depthHint) const
   {
     return this->database.get(ind);
@@ -91,6 +109,40 @@ namespace busybin
     return this->getNumMoves(this->getDatabaseIndex(cube));
   }
 
+  /**
+   * Get the database indexes of a batch of cubes.  This is the same as
+   * calling getDatabaseIndex on each cube, but databases can override it to
+   * rank the cubes together with SIMD instructions.
+   * @param cubes The cubes.
+   * @param numCubes The number of cubes.
+   * @param indexes Set to each cube's index.
+   */
+  void PatternDatabase::getDatabaseIndexes(const RubiksCube* const* cubes,
+    const unsigned numCubes, size_t* indexes) const
+  {
+    for (unsigned i = 0; i < numCubes; ++i)
+      indexes[i] = this->getDatabaseIndex(*cubes[i]);
+  }
+
+  /**
+   * Get the estimated number of moves for a batch of cubes (e.g. all the
+   * successors of a node).  This is the same as calling getNumMovesEx on each
+   * cube, but databases that are read from memory can look the cubes up
+   * together so that the cache misses overlap.
+   * @param cubes The cubes.
+   * @param numCubes The number of cubes.
+   * @param boundHint The search bound (see getNumMovesEx).
+   * @param depthHint The depth of the cubes (see getNumMovesEx).
+   * @param estMoves Set to each cube's estimate.
+   */
+  void PatternDatabase::getNumMovesBatch(const RubiksCube* const* cubes,
+    const unsigned numCubes, const uint8_t boundHint,
+    const uint8_t depthHint, uint8_t* estMoves) const
+  {
+    for (unsigned i = 0; i < numCubes; ++i)
+      estMoves[i] = this->getNumMovesEx(*cubes[i], boundHint, depthHint);
+  }
+
   /**
    * Get the size of the database.
    */
@@ -107,6 +159,30 @@ namespace busybin
     return this->numItems;
   }
 
+  /**
+   * Set the number of items in the database.  Used after filling the
+   * database with setNumMovesAtomic.
+   */
+  void PatternDatabase::setNumItems(const size_t numItems)
+  {
+    this->numItems = numItems;
+  }
+
+  /**
+   * Set up a cube in a state that has the given database index: the inverse
+   * of getDatabaseIndex.  Cubies that the database doesn't track are put in
+   * the remaining positions in an arbitrary order, so the cube isn't
+   * necessarily solvable, but every move applied to it changes the index as
+   * it would for a real scramble.  Databases that support it override this
+   * method.
+   * @param ind An index into the database.
+   * @param cube The cube to set up.
+   */
+  void PatternDatabase::getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+  {
+    throw RubiksCubeException("PatternDatabase::getCube is not implemented for this database.");
+  }
+
   /**
    * Returns true if every entry in the database has been added.
    */
@@ -120,6 +196,9 @@ namespace busybin
    */
   void PatternDatabase::toFile(const string& filePath) const
   {
+    if (!this->database.isAllocated())
+      throw RubiksCubeException("PatternDatabase::toFile on an empty database.");
+
     ofstream writer(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
 
     if (!writer.is_open())
@@ -162,14 +241,45 @@ namespace busybin
     return true;
   }
 
+  /**
+   * Memory-map the database file instead of reading it into memory.  Lookups
+   * read straight from the page cache, and processes that map the same file
+   * share a single copy of it.  The database is read-only while it's mapped.
+   * If the file can't be mapped, it's read normally.  Returns true if the
+   * database file exists and is loaded, otherwise returns false.
+   * @param filePath The path to the database file.
+   * @param hugePages Hint that the mapping should use huge pages.
+   */
+  bool PatternDatabase::mapFile(const string& filePath, bool hugePages)
+  {
+    if (!this->database.map(filePath, hugePages))
+      return this->fromFile(filePath);
+
+    this->numItems = this->size;
+
+    return true;
+  }
+
+  /**
+   * Check if the database is backed by a memory-mapped file.
+   */
+  bool PatternDatabase::isMapped() const
+  {
+    return this->database.isMapped();
+  }
+
   /**
    * Inflate the underlying array for faster access.
+   * @param pThreadPool An optional ThreadPool for inflating in parallel.
+   * @param hugePages Try to put the inflated copy on huge pages (see
+   * HugePageBuffer).
    */
-  vector<uint8_t> PatternDatabase::inflate() const
+  HugePageBuffer PatternDatabase::inflate(ThreadPool* pThreadPool,
+    bool hugePages) const
   {
-    vector<uint8_t> inflated;
+    HugePageBuffer inflated(this->size, hugePages);
 
-    this->database.inflate(inflated);
+    this->database.inflate(inflated.data(), pThreadPool);
 
     return inflated;
   }
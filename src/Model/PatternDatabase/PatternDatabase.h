@@ -2,8 +2,11 @@
 #define _BUSYBIN_PATTERN_DATABASE_
 
 #include "../RubiksCube.h"
+#include "../RubiksCubeIndexModel.h"
 #include "../../Util/NibbleArray.h"
+#include "../../Util/HugePageBuffer.h"
 #include "../../Util/RubiksCubeException.h"
+#include "../../Util/ThreadPool.h"
 #include <cstdint>
 #include <cstddef>
 using std::size_t;
@@ -38,21 +41,41 @@ namespace busybin
 
   public:
     PatternDatabase(const size_t size);
-    virtual uint32_t getDatabaseIndex(const RubiksCube& cube) const = 0;
+    virtual size_t getDatabaseIndex(const RubiksCube& cube) const = 0;
+    virtual void getDatabaseIndexes(const RubiksCube* const* cubes,
+      const unsigned numCubes, size_t* indexes) const;
     virtual bool setNumMoves(const RubiksCube& cube, const uint8_t numMoves);
-    virtual bool setNumMoves(const uint32_t ind, const uint8_t numMoves);
+    virtual bool setNumMoves(const size_t ind, const uint8_t numMoves);
+    virtual bool setNumMovesAtomic(const size_t ind, const uint8_t numMoves);
     virtual uint8_t getNumMoves(const RubiksCube& cube) const;
-    virtual uint8_t getNumMoves(const uint32_t ind) const;
+    virtual uint8_t getNumMoves(const size_t ind) const;
     virtual uint8_t getNumMovesEx(const RubiksCube& cube,
       const uint8_t boundHint, const uint8_t depthHint) const;
-    virtual uint8_t getNumMovesEx(const uint32_t ind,
+    virtual uint8_t getNumMovesEx(const size_t ind,
       const uint8_t boundHint, const uint8_t depthHint) const;
+    virtual void getNumMovesBatch(const RubiksCube* const* cubes,
+      const unsigned numCubes, const uint8_t boundHint,
+      const uint8_t depthHint, uint8_t* estMoves) const;
+
+    /**
+     * Hint that the entry at index ind will be read soon.
+     */
+    inline void prefetch(const size_t ind) const
+    {
+      this->database.prefetch(ind);
+    }
+
     virtual size_t getSize() const;
     virtual size_t getNumItems() const;
+    virtual void setNumItems(const size_t numItems);
+    virtual void getCube(const size_t ind, RubiksCubeIndexModel& cube) const;
     virtual bool isFull() const;
     virtual void toFile(const string& filePath) const;
     virtual bool fromFile(const string& filePath);
-    virtual vector<uint8_t> inflate() const;
+    virtual bool mapFile(const string& filePath, bool hugePages = false);
+    virtual bool isMapped() const;
+    virtual HugePageBuffer inflate(ThreadPool* pThreadPool = nullptr,
+      bool hugePages = false) const;
     virtual void reset();
   };
 }
@@ -1,50 +1,125 @@
 #ifndef _BUSYBIN_CORNER_PERMUTATION_INDEXER_
 #define _BUSYBIN_CORNER_PERMUTATION_INDEXER_
 
-#include "../../Util/math.h"
 #include <cstdint>
 #include <cstddef>
 using std::size_t;
 #include <array>
 using std::array;
-#include <bitset>
-using std::bitset;
-#include <iostream>
-using std::cout;
-using std::endl;
+#include <type_traits>
+#include <cstring>
+
+#if defined(__BMI2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
 
 namespace busybin
 {
   /**
    * Class for generating sequential indexes for permutations of size N picked K
    * ways.
+   *
+   * Ranking is on the hot path of every pattern database lookup, so the
+   * indexer holds no tables: the seen digits are a bit mask counted with
+   * popcount, and the place values of the Lehmer code are compile-time
+   * constants.  The loops over the K digits are unrolled by template
+   * recursion, so each digit is multiplied (or divided) by a constant.
    */
   template <size_t N, size_t K = N>
   class PermutationIndexer
   {
-    // Precomputed table containing the number of ones in the binary
-    // representation of each number.  The largest N-bit number is
-    // 2^N-1 = (1 << N) - 1.
-    array<uint32_t, (1 << N) - 1> onesCountLookup;
+    static_assert(K <= N && N <= 12, "PermutationIndexer: N is at most 12.");
 
-    // Precomputed table of factorials (or "picks" if N != K).  They're in
-    // reverse order.
-    array<uint32_t, K> factorials;
+    template <uint32_t I>
+    using digit_t = std::integral_constant<uint32_t, I>;
 
-  public:
     /**
-     * Popluate factorials and ones-count tables.
+     * n pick k: n * (n-1) * ... * (n-k+1).
      */
-    PermutationIndexer()
+    static constexpr uint32_t pick(uint32_t n, uint32_t k)
     {
-      for (uint32_t i = 0; i < (1 << N) - 1; ++i)
-      {
-        bitset<N> bits(i);
-        this->onesCountLookup[i] = bits.count();
-      }
+      return k == 0 ? 1 : n * PermutationIndexer::pick(n - 1, k - 1);
+    }
+
+    /**
+     * The place value of digit i of the Lehmer code, which is the number of
+     * partial permutations of the digits after it: (N-1-i) pick (K-1-i).
+     */
+    static constexpr uint32_t placeValue(uint32_t i)
+    {
+      return PermutationIndexer::pick(N - 1 - i, K - 1 - i);
+    }
+
+    /**
+     * Rank digits I through K-1 of a permutation.  The loop over the digits
+     * is a recursion on I, so it's unrolled at compile time, and each place
+     * value is a constant.
+     * @param perm The permutation.
+     * @param seen The digits before digit I (bit d for digit d).
+     */
+    template <uint32_t I>
+    static uint32_t rankFrom(const array<uint8_t, K>& perm, uint32_t seen,
+      digit_t<I>)
+    {
+      // Each digit of the Lehmer code (in a factorial number system) is the
+      // digit less the number of smaller digits that were already seen.
+      uint32_t numOnes = __builtin_popcount(seen & ((1u << perm[I]) - 1));
+
+      return (perm[I] - numOnes) * digit_t<placeValue(I)>::value +
+        PermutationIndexer::rankFrom(perm, seen | (1u << perm[I]),
+          digit_t<I + 1>());
+    }
 
-      for (uint32_t i = 0; i < K; ++i)
-        this->factorials[i] = pick(N - 1 - i, K - 1 - i); 
+    static uint32_t rankFrom(const array<uint8_t, K>& perm, uint32_t seen,
+      digit_t<K>)
+    {
+      return 0;
+    }
+
+    /**
+     * Unrank digits I through K-1 of a permutation (see rankFrom).
+     * @param index What's left of the rank.
+     * @param available The digits not used by digits 0 through I-1.
+     * @param perm The permutation to fill.
+     */
+    template <uint32_t I>
+    static void unrankFrom(uint32_t index, uint32_t available,
+      array<uint8_t, K>& perm, digit_t<I>)
+    {
+      // Each digit of the Lehmer code is the number of available digits
+      // smaller than the one picked.
+      uint32_t lehmer = index / digit_t<placeValue(I)>::value;
+
+#if defined(__BMI2__)
+      // Deposit a single bit at the lehmer-th available digit.
+      uint8_t digit = __builtin_ctz(_pdep_u32(1u << lehmer, available));
+#else
+      uint32_t remaining = available;
+
+      for (; lehmer != 0; --lehmer)
+        remaining &= remaining - 1;
+
+      uint8_t digit = __builtin_ctz(remaining);
+#endif
+
+      perm[I] = digit;
+
+      PermutationIndexer::unrankFrom(index % digit_t<placeValue(I)>::value,
+        available & ~(1u << digit), perm, digit_t<I + 1>());
+    }
+
+    static void unrankFrom(uint32_t index, uint32_t available,
+      array<uint8_t, K>& perm, digit_t<K>)
+    {
+    }
+
+  public:
+    /**
+     * The number of permutations: N pick K.
+     */
+    static constexpr uint32_t getNumPermutations()
+    {
+      return PermutationIndexer::pick(N, K);
     }
 
     /**
@@ -53,37 +128,100 @@ namespace busybin
      */
     uint32_t rank(const array<uint8_t, K>& perm) const
     {
-      // This will hold the Lehmer code (in a factorial number system).
-      array<uint32_t, K> lehmer;
+      return PermutationIndexer::rankFrom(perm, 0, digit_t<0>());
+    }
+
+    /**
+     * Rank a batch of permutations given as a structure of arrays: digit i of
+     * permutation p is digits[i][p].  The permutations are ranked 8 at a time
+     * with AVX2, or 4 at a time with SSE4.1, and the rest one at a time.
+     * Each Lehmer digit is the digit less the number of smaller digits to its
+     * left, which is counted with K*(K-1)/2 vector compares.
+     * @param digits The digits of the permutations, K arrays of numPerms.
+     * @param numPerms The number of permutations.
+     * @param ranks Set to the rank of each permutation.
+     */
+    void rankBatch(const array<const uint8_t*, K>& digits, unsigned numPerms,
+      uint32_t* ranks) const
+    {
+      unsigned p = 0;
+
+#if defined(__AVX2__)
+      for (; p + 8 <= numPerms; p += 8)
+      {
+        __m256i digit[K];
+        __m256i rank = _mm256_setzero_si256();
+
+        for (uint32_t i = 0; i < K; ++i)
+        {
+          digit[i] = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+            reinterpret_cast<const __m128i*>(digits[i] + p)));
 
-      // Set of "seen" digits in the permutation.
-      bitset<N> seen;
+          // Each compare is -1 where the earlier digit is smaller.
+          __m256i lehmer = digit[i];
 
-      // The first digit of the Lehmer code is always the first digit of
-      // the permutation.
-      lehmer[0] = perm[0];
+          for (uint32_t j = 0; j < i; ++j)
+          {
+            lehmer = _mm256_add_epi32(lehmer,
+              _mm256_cmpgt_epi32(digit[i], digit[j]));
+          }
 
-      // Mark the digit as seen (bitset uses right-to-left indexing).
-      seen[N - 1 - perm[0]] = 1;
+          rank = _mm256_add_epi32(rank, _mm256_mullo_epi32(lehmer,
+            _mm256_set1_epi32(PermutationIndexer::placeValue(i))));
+        }
 
-      for (uint32_t i = 1; i < K; ++i)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ranks + p), rank);
+      }
+#endif
+
+#if defined(__SSE4_1__)
+      for (; p + 4 <= numPerms; p += 4)
       {
-        seen[N - 1 - perm[i]] = 1;
+        __m128i digit[K];
+        __m128i rank = _mm_setzero_si128();
+
+        for (uint32_t i = 0; i < K; ++i)
+        {
+          int32_t packed;
+
+          memcpy(&packed, digits[i] + p, sizeof(packed));
+          digit[i] = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+
+          __m128i lehmer = digit[i];
 
-        // The number of "seen" digits to the left of this digit is the
-        // count of ones left of this digit.
-        uint32_t numOnes = this->onesCountLookup[seen.to_ulong() >> (N - perm[i])];
+          for (uint32_t j = 0; j < i; ++j)
+            lehmer = _mm_add_epi32(lehmer, _mm_cmpgt_epi32(digit[i], digit[j]));
 
-        lehmer[i] = perm[i] - numOnes;
+          rank = _mm_add_epi32(rank, _mm_mullo_epi32(lehmer,
+            _mm_set1_epi32(PermutationIndexer::placeValue(i))));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ranks + p), rank);
       }
+#endif
+
+      for (; p < numPerms; ++p)
+      {
+        array<uint8_t, K> perm;
 
-      // Convert the Lehmer code to base-10.
-      uint32_t index = 0;
+        for (uint32_t i = 0; i < K; ++i)
+          perm[i] = digits[i][p];
+
+        ranks[p] = this->rank(perm);
+      }
+    }
+
+    /**
+     * Get the permutation with the given lexicographic rank (the inverse of
+     * rank).
+     */
+    array<uint8_t, K> unrank(uint32_t index) const
+    {
+      array<uint8_t, K> perm;
 
-      for (uint32_t i = 0; i < K; ++i)
-        index += lehmer[i] * this->factorials[i];
+      PermutationIndexer::unrankFrom(index, (1u << N) - 1, perm, digit_t<0>());
 
-      return index;
+      return perm;
     }
   };
 }
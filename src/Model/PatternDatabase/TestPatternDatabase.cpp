@@ -13,7 +13,7 @@ namespace busybin
   /**
    * Given a cube, get an index into the pattern database.
    */
-  uint32_t TestPatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  size_t TestPatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
   {
     typedef RubiksCubeIndexModel::EDGE EDGE;
 
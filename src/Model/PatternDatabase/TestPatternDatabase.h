@@ -23,7 +23,7 @@ namespace busybin
 
   public:
     TestPatternDatabase();
-    uint32_t getDatabaseIndex(const RubiksCube& cube) const;
+    size_t getDatabaseIndex(const RubiksCube& cube) const;
   };
 }
 
@@ -17,7 +17,7 @@ namespace busybin
   /**
    * Given a cube, get an index into the pattern database.
    */
-  uint32_t G1PatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  size_t G1PatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
   {
     typedef RubiksCube::EDGE EDGE;
 
@@ -39,5 +39,30 @@ namespace busybin
       iCube.getEdgeOrientation(EDGE::DL) * 2 +
       iCube.getEdgeOrientation(EDGE::DB);
   }
-}
 
+  /**
+   * Set up a solvable cube with the given database index.  The edges and
+   * corners are in place, and the orientation of the 12th edge is implied by
+   * the other 11.
+   */
+  void G1PatternDatabase::getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+  {
+    typedef RubiksCube::EDGE   EDGE;
+    typedef RubiksCube::CORNER CORNER;
+
+    uint8_t orientationSum = 0;
+
+    for (uint8_t i = 0; i < 11; ++i)
+    {
+      uint8_t orientation = (ind >> (10 - i)) & 1;
+
+      cube.setEdge((EDGE)i, i, orientation);
+      orientationSum += orientation;
+    }
+
+    cube.setEdge(EDGE::DR, 11, orientationSum & 1);
+
+    for (uint8_t i = 0; i < 8; ++i)
+      cube.setCorner((CORNER)i, i, 0);
+  }
+}
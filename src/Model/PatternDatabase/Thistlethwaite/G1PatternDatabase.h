@@ -17,7 +17,8 @@ namespace busybin
   {
   public:
     G1PatternDatabase();
-    uint32_t getDatabaseIndex(const RubiksCube& cube) const;
+    size_t getDatabaseIndex(const RubiksCube& cube) const;
+    void getCube(const size_t ind, RubiksCubeIndexModel& cube) const;
   };
 }
 
@@ -23,7 +23,7 @@ namespace busybin
   /**
    * Given a cube, get an index into the pattern database.
    */
-  uint32_t G2PatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  size_t G2PatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
   {
     typedef RubiksCube::EDGE   EDGE;
     typedef RubiksCube::CORNER CORNER;
@@ -79,5 +79,80 @@ namespace busybin
     // Combine the two (3^7 == 2187).
     return rank * 2187 + orientationNum;
   }
-}
 
+  /**
+   * Set up a solvable cube with the given database index.  The E-slice
+   * edges are put in the combination's positions, the other edges fill the
+   * remaining positions in order, and the corners are in place with the
+   * indexed orientations.  The 8th corner's orientation is implied by the
+   * other 7.
+   */
+  void G2PatternDatabase::getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+  {
+    typedef RubiksCube::EDGE   EDGE;
+    typedef RubiksCube::CORNER CORNER;
+
+    const uint8_t numEdges = 12;
+
+    array<uint8_t, 4> edgeCombo = this->comboIndexer.unrank(ind / 2187);
+    uint8_t           eSliceEdge = (uint8_t)EDGE::FR;
+    uint8_t           otherEdge  = 0;
+    unsigned          comboInd   = 0;
+
+    for (uint8_t i = 0; i < numEdges; ++i)
+    {
+      if (comboInd < 4 && edgeCombo[comboInd] == i)
+      {
+        cube.setEdge((EDGE)i, eSliceEdge++, 0);
+        ++comboInd;
+      }
+      else
+      {
+        // Skip over the E-slice edges (FR, FL, BL, BR).
+        if (otherEdge == (uint8_t)EDGE::FR)
+          otherEdge = (uint8_t)EDGE::DF;
+
+        cube.setEdge((EDGE)i, otherEdge++, 0);
+      }
+    }
+
+    uint32_t orientationNum = ind % 2187;
+    uint8_t  orientationSum = 0;
+
+    for (int i = 6; i >= 0; --i)
+    {
+      uint8_t orientation = orientationNum % 3;
+
+      cube.setCorner((CORNER)i, i, orientation);
+      orientationSum += orientation;
+      orientationNum /= 3;
+    }
+
+    cube.setCorner(CORNER::DRF, 7, (3 - orientationSum % 3) % 3);
+
+    // The corners are in place, so the edges need even parity.  Swapping
+    // two of the edges that aren't tracked doesn't change the index.
+    if (cube.getEdgeParity())
+    {
+      uint8_t first = numEdges, second = numEdges;
+
+      for (uint8_t i = 0; i < numEdges && second == numEdges; ++i)
+      {
+        uint8_t edge = cube.getEdgeIndex((EDGE)i);
+
+        if (edge < (uint8_t)EDGE::FR || edge > (uint8_t)EDGE::BR)
+        {
+          if (first == numEdges)
+            first = i;
+          else
+            second = i;
+        }
+      }
+
+      uint8_t firstEdge = cube.getEdgeIndex((EDGE)first);
+
+      cube.setEdge((EDGE)first, cube.getEdgeIndex((EDGE)second), 0);
+      cube.setEdge((EDGE)second, firstEdge, 0);
+    }
+  }
+}
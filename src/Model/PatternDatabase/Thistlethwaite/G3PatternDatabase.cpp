@@ -53,7 +53,7 @@ namespace busybin
   /**
    * Given a cube, get an index into the pattern database.
    */
-  uint32_t G3PatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  size_t G3PatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
   {
     typedef RubiksCube::EDGE   EDGE;
     typedef RubiksCube::CORNER CORNER;
@@ -122,4 +122,80 @@ namespace busybin
     // 2520 = 8C2*6C2*4C2.
     return (edgeRank * 2520 + cornerRank) * 2 + parity;
   }
+
+  /**
+   * Set up a solvable cube with the given database index.  Each tetrad pair
+   * of corners is put in its pair of positions, in the order that gives the
+   * indexed parity.  The M-slice edges are put in the combination's
+   * positions and the S-slice edges fill the rest of the M and S slices,
+   * with two of them swapped if needed to match the corner parity.  The
+   * E-slice edges are in place, and nothing is twisted or flipped.
+   */
+  void G3PatternDatabase::getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+  {
+    typedef RubiksCube::EDGE   EDGE;
+    typedef RubiksCube::CORNER CORNER;
+
+    uint8_t  parity     = ind % 2;
+    uint32_t cornerRank = (ind / 2) % 2520;
+    uint32_t edgeRank   = (ind / 2) / 2520;
+
+    // The corners in each pair, in the order getDatabaseIndex ranks them.
+    const array<array<CORNER, 2>, 4> pairCorners =
+    {{
+      {{CORNER::ULB, CORNER::URF}},
+      {{CORNER::DLF, CORNER::DRB}},
+      {{CORNER::URB, CORNER::ULF}},
+      {{CORNER::DLB, CORNER::DRF}}
+    }};
+
+    array<array<uint8_t, 2>, 4> tetradPairs = this->pairSetIndexer.unrank(cornerRank);
+
+    for (unsigned p = 0; p < 4; ++p)
+    {
+      cube.setCorner((CORNER)tetradPairs[p][0], (uint8_t)pairCorners[p][0], 0);
+      cube.setCorner((CORNER)tetradPairs[p][1], (uint8_t)pairCorners[p][1], 0);
+    }
+
+    // Swapping the corners of a pair flips the parity but not the pairs.
+    if (cube.getCornerParity() != parity)
+    {
+      cube.setCorner((CORNER)tetradPairs[0][0], (uint8_t)pairCorners[0][1], 0);
+      cube.setCorner((CORNER)tetradPairs[0][1], (uint8_t)pairCorners[0][0], 0);
+    }
+
+    // The M and S slice positions, numbered as in getDatabaseIndex.
+    const array<EDGE, 8> positions =
+    {{
+      EDGE::UB, EDGE::UR, EDGE::UF, EDGE::UL,
+      EDGE::DF, EDGE::DL, EDGE::DB, EDGE::DR
+    }};
+    const array<EDGE, 4> mEdges = {{EDGE::UB, EDGE::UF, EDGE::DF, EDGE::DB}};
+    const array<EDGE, 4> sEdges = {{EDGE::UR, EDGE::UL, EDGE::DL, EDGE::DR}};
+
+    array<uint8_t, 4> edgeCombo = this->comboIndexer.unrank(edgeRank);
+    array<EDGE, 4>    sPositions;
+    unsigned          mInd = 0;
+    unsigned          sInd = 0;
+
+    for (uint8_t i = 0; i < 8; ++i)
+    {
+      if (mInd < 4 && edgeCombo[mInd] == i)
+        cube.setEdge(positions[i], (uint8_t)mEdges[mInd++], 0);
+      else
+      {
+        sPositions[sInd] = positions[i];
+        cube.setEdge(positions[i], (uint8_t)sEdges[sInd++], 0);
+      }
+    }
+
+    for (EDGE e : {EDGE::FR, EDGE::FL, EDGE::BL, EDGE::BR})
+      cube.setEdge(e, (uint8_t)e, 0);
+
+    if (cube.getEdgeParity() != parity)
+    {
+      cube.setEdge(sPositions[0], (uint8_t)sEdges[1], 0);
+      cube.setEdge(sPositions[1], (uint8_t)sEdges[0], 0);
+    }
+  }
 }
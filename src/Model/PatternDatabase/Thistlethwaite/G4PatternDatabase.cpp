@@ -30,7 +30,7 @@ namespace busybin
   /**
    * Given a cube, get an index into the pattern database.
    */
-  uint32_t G4PatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
+  size_t G4PatternDatabase::getDatabaseIndex(const RubiksCube& cube) const
   {
     typedef RubiksCube::CORNER CORNER;
     typedef RubiksCube::EDGE   EDGE;
@@ -116,4 +116,77 @@ namespace busybin
     // 4! * 4 = 96 (or 4!4!/(2*3)).
     return edgeRank * 96 + cornerRank;
   }
+
+  /**
+   * Set up a solvable cube with the given database index.  The untracked
+   * cubies (the last two E-slice edges and three corners of the second
+   * tetrad) fill their remaining positions in order, and the last two edges
+   * are swapped if needed so that the edge and corner parities match.
+   * Nothing is twisted or flipped.
+   */
+  void G4PatternDatabase::getCube(const size_t ind, RubiksCubeIndexModel& cube) const
+  {
+    typedef RubiksCube::CORNER CORNER;
+    typedef RubiksCube::EDGE   EDGE;
+
+    // The cubies and positions of each slice and tetrad, in the order that
+    // getDatabaseIndex numbers them.
+    const array<EDGE, 4>   mSlice  = {{EDGE::UB, EDGE::UF, EDGE::DF, EDGE::DB}};
+    const array<EDGE, 4>   sSlice  = {{EDGE::UR, EDGE::UL, EDGE::DL, EDGE::DR}};
+    const array<EDGE, 4>   eSlice  = {{EDGE::FR, EDGE::FL, EDGE::BL, EDGE::BR}};
+    const array<CORNER, 4> tetrad1 = {{CORNER::ULB, CORNER::URF, CORNER::DLF, CORNER::DRB}};
+    const array<CORNER, 4> tetrad2 = {{CORNER::URB, CORNER::ULF, CORNER::DLB, CORNER::DRF}};
+
+    uint32_t edgeRank   = ind / 96;
+    uint32_t cornerRank = ind % 96;
+
+    array<uint8_t, 4> m = this->permIndexer.unrank(edgeRank / 288);
+    array<uint8_t, 4> s = this->permIndexer.unrank(edgeRank % 288 / 12);
+    array<uint8_t, 2> e = this->partialPermIndexer.unrank(edgeRank % 12);
+
+    for (unsigned i = 0; i < 4; ++i)
+    {
+      cube.setEdge(mSlice[i], (uint8_t)mSlice[m[i]], 0);
+      cube.setEdge(sSlice[i], (uint8_t)sSlice[s[i]], 0);
+    }
+
+    // FR and FL are tracked; BL and BR get the other two E-slice edges.
+    unsigned eInd = 0;
+
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      if (i == e[0] || i == e[1])
+        continue;
+
+      cube.setEdge(eSlice[2 + eInd++], (uint8_t)eSlice[i], 0);
+    }
+
+    cube.setEdge(eSlice[0], (uint8_t)eSlice[e[0]], 0);
+    cube.setEdge(eSlice[1], (uint8_t)eSlice[e[1]], 0);
+
+    // The first tetrad is tracked, and so is the cubie at URB.  The rest of
+    // the second tetrad fills ULF, DLB, and DRF.
+    array<uint8_t, 4> t1    = this->permIndexer.unrank(cornerRank / 4);
+    uint8_t           urb   = cornerRank % 4;
+    unsigned          t2Ind = 1;
+
+    for (unsigned i = 0; i < 4; ++i)
+      cube.setCorner(tetrad1[i], (uint8_t)tetrad1[t1[i]], 0);
+
+    cube.setCorner(tetrad2[0], (uint8_t)tetrad2[urb], 0);
+
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      if (i != urb)
+        cube.setCorner(tetrad2[t2Ind++], (uint8_t)tetrad2[i], 0);
+    }
+
+    if (cube.getEdgeParity() != cube.getCornerParity())
+    {
+      uint8_t bl = cube.getEdgeIndex(EDGE::BL);
+
+      cube.setEdge(EDGE::BL, cube.getEdgeIndex(EDGE::BR), 0);
+      cube.setEdge(EDGE::BR, bl, 0);
+    }
+  }
 }
@@ -23,7 +23,8 @@ namespace busybin
     PermutationIndexer<4, 2> partialPermIndexer;
   public:
     G4PatternDatabase();
-    uint32_t getDatabaseIndex(const RubiksCube& cube) const;
+    size_t getDatabaseIndex(const RubiksCube& cube) const;
+    void getCube(const size_t ind, RubiksCubeIndexModel& cube) const;
   };
 }
 
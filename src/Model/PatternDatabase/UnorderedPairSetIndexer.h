@@ -68,6 +68,14 @@ namespace busybin
         this->bases[i] = this->bases[i + 1] * choose((N-2) - 2*i, 2);
     }
 
+    /**
+     * Get the number of sets of pairs: NC2*(N-2)C2*...*2C2.
+     */
+    uint32_t getNumSets() const
+    {
+      return this->bases[0] * (N*(N-1)/2);
+    }
+
     /**
      * Rank the set of pairs in lexicographic order.  @param set An array of
      * pairs.  Each pair of numbers must be in ascending order, and there must
@@ -128,6 +136,48 @@ namespace busybin
 
       return rank;
     }
+
+    /**
+     * Get the set of pairs with the given rank (the inverse of rank).  Each
+     * digit of the rank picks a pair among those that exclude the numbers of
+     * the pairs before it, and the last pair is the two numbers left over.
+     */
+    array<pair_t, N/2> unrank(uint32_t rank) const
+    {
+      array<pair_t, N/2>       set;
+      unsigned                 numRemaining = N*(N-1)/2;
+      array<pair_t, N*(N-1)/2> remaining    = this->pairs;
+
+      for (unsigned n = 0; n < N/2; ++n)
+      {
+        unsigned remainingInd = 0;
+
+        if (n < (N-2)/2)
+        {
+          set[n] = remaining[rank / this->bases[n]];
+          rank  %= this->bases[n];
+        }
+        else
+          set[n] = remaining[0];
+
+        for (unsigned r = 0; r < numRemaining; ++r)
+        {
+          const pair_t& rPair = remaining[r];
+
+          if (
+            set[n][0] != rPair[0] && set[n][0] != rPair[1] &&
+            set[n][1] != rPair[0] && set[n][1] != rPair[1]
+          )
+          {
+            remaining[remainingInd++] = rPair;
+          }
+        }
+
+        numRemaining = remainingInd;
+      }
+
+      return set;
+    }
   };
 }
 
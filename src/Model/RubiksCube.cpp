@@ -1,4 +1,8 @@
 #include "RubiksCube.h"
+#include <sstream>
+using std::istringstream;
+#include <cstring>
+#include <cctype>
 
 namespace busybin
 {
@@ -254,5 +258,44 @@ namespace busybin
         throw RubiksCubeException("Invalid face turn index.");
     }
   }
-}
 
+  /**
+   * Parse a whitespace-separated list of face twists (e.g. "R U' F2"), the
+   * inverse of getMove.  Lower-case faces are accepted as well.  Returns
+   * false if a twist isn't recognized.
+   * @param moves The moves to parse.
+   * @param parsed The moves are appended to this vector.
+   */
+  bool RubiksCube::parseMoves(const string& moves, vector<MOVE>& parsed)
+  {
+    // In MOVE order; each face has a quarter, prime, and half twist.
+    static const char faces[] = "LRUDFB";
+
+    istringstream stream(moves);
+    string        token;
+
+    while (stream >> token)
+    {
+      const char* pFace = strchr(faces, toupper(token[0]));
+
+      if (!pFace || *pFace == '\0' || token.size() > 2)
+        return false;
+
+      uint8_t move = (uint8_t)(pFace - faces) * 3;
+
+      if (token.size() == 2)
+      {
+        if (token[1] == '\'')
+          move += 1;
+        else if (token[1] == '2')
+          move += 2;
+        else
+          return false;
+      }
+
+      parsed.push_back((MOVE)move);
+    }
+
+    return true;
+  }
+}
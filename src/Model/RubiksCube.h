@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <string>
 using std::string;
+#include <vector>
+using std::vector;
 
 namespace busybin
 {
@@ -39,6 +41,7 @@ namespace busybin
     virtual COLOR getColor(FACE face, unsigned row, unsigned col) const = 0;
     virtual bool isSolved() const = 0;
     string getMove(MOVE ind) const;
+    static bool parseMoves(const string& moves, vector<MOVE>& parsed);
 
     // Face moves.
     RubiksCube& move(MOVE ind);
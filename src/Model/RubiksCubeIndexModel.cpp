@@ -1,4 +1,9 @@
 #include "RubiksCubeIndexModel.h"
+#include <cstring>
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
 
 namespace busybin
 {
@@ -156,37 +161,18 @@ namespace busybin
 
     Cubie corner = this->corners.at((unsigned)ind);
 
-    unsigned i0, i1, i2;
+    // The red or orange sticker is on U or D when the orientation is 0.
+    // Otherwise the orientation that puts it on L or R alternates by
+    // position (see RubiksCubeModel::getCornerOrientation).
+    unsigned i0 = corner.orientation == 0 ? 0 :
+      (corner.orientation == 1) == ((unsigned)ind % 2 == 0) ? 1 : 2;
 
-    // Red or orange on top.
-    if (corner.orientation == 0)
-    {
-      i0 = 0;
-      i1 = 1;
-      i2 = 2;
-
-      // A quarter turn of U or D swaps the two other colors.
-      if ((corner.index + (unsigned)ind) % 2 == 1)
-        swap(i1, i2);
-    }
-    else if (corner.orientation == 1)
-    {
-      i0 = 1;
-      i1 = 2;
-      i2 = 0;
-
-      if ((corner.index + (unsigned)ind) % 2 == 1)
-        swap(i0, i1);
-    }
-    else // if (corner.orientation == 2)
-    {
-      i0 = 2;
-      i1 = 0;
-      i2 = 1;
-
-      if ((corner.index + (unsigned)ind) % 2 == 1)
-        swap(i0, i2);
-    }
+    // The other two stickers follow in the cubie's cyclic order, which is
+    // YXZ in positions of the same parity as the cubie's home, and YZX in
+    // the others (a quarter turn of U or D swaps them).
+    bool     mirrored = (corner.index + (unsigned)ind) % 2 == 1;
+    unsigned i1       = mirrored ? (i0 + 2) % 3 : (i0 + 1) % 3;
+    unsigned i2       = mirrored ? (i0 + 1) % 3 : (i0 + 2) % 3;
 
     switch ((CORNER)corner.index)
     {
@@ -454,6 +440,66 @@ namespace busybin
     return this->corners[(unsigned)ind].orientation;
   }
 
+  /**
+   * Place an edge cubie.  Used to build a cube from a pattern database index;
+   * the caller is responsible for producing a valid state.
+   * @param ind The edge position.
+   * @param index The cubie index, 0-11.
+   * @param orientation The cubie orientation, 0-1.
+   */
+  void RubiksCubeIndexModel::setEdge(EDGE ind, uint8_t index, uint8_t orientation)
+  {
+    this->edges[(unsigned)ind].index       = index;
+    this->edges[(unsigned)ind].orientation = orientation;
+  }
+
+  /**
+   * Place a corner cubie (see setEdge).
+   * @param ind The corner position.
+   * @param index The cubie index, 0-7.
+   * @param orientation The cubie orientation, 0-2.
+   */
+  void RubiksCubeIndexModel::setCorner(CORNER ind, uint8_t index, uint8_t orientation)
+  {
+    this->corners[(unsigned)ind].index       = index;
+    this->corners[(unsigned)ind].orientation = orientation;
+  }
+
+  /**
+   * Get the parity of the edge permutation: 0 if it takes an even number of
+   * swaps to put the edges in place, 1 if odd.  Every quarter twist swaps
+   * the edge and corner parities together, so they're equal in a solvable
+   * cube.
+   */
+  uint8_t RubiksCubeIndexModel::getEdgeParity() const
+  {
+    uint8_t parity = 0;
+
+    for (unsigned i = 0; i < this->edges.size(); ++i)
+    {
+      for (unsigned j = i + 1; j < this->edges.size(); ++j)
+        parity ^= this->edges[i].index > this->edges[j].index;
+    }
+
+    return parity;
+  }
+
+  /**
+   * Get the parity of the corner permutation (see getEdgeParity).
+   */
+  uint8_t RubiksCubeIndexModel::getCornerParity() const
+  {
+    uint8_t parity = 0;
+
+    for (unsigned i = 0; i < this->corners.size(); ++i)
+    {
+      for (unsigned j = i + 1; j < this->corners.size(); ++j)
+        parity ^= this->corners[i].index > this->corners[j].index;
+    }
+
+    return parity;
+  }
+
   /**
    * Check if the cube is in a solved state.
    */
@@ -474,6 +520,28 @@ namespace busybin
     return true;
   }
 
+  /**
+   * Get a 64-bit hash of the cubies (the centers are ignored).  The cubies
+   * take 40 bytes, which are mixed as five words.
+   */
+  uint64_t RubiksCubeIndexModel::getHash() const
+  {
+    uint64_t words[5];
+    uint64_t hash = 0;
+
+    memcpy(words, this->edges.data(), sizeof(this->edges));
+    memcpy(reinterpret_cast<uint8_t*>(words) + sizeof(this->edges),
+      this->corners.data(), sizeof(this->corners));
+
+    for (uint64_t word : words)
+    {
+      hash  = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+      hash ^= hash >> 29;
+    }
+
+    return hash;
+  }
+
   /**
    * Helper to update the orientation of corners on 90-degree CW twist.
    * @param ind The corner index to update.
@@ -510,6 +578,161 @@ namespace busybin
     this->edges[(unsigned)ind].orientation ^= 1;
   }
 
+  /**
+   * The table for each face twist, L through B2.
+   */
+  const array<RubiksCubeIndexModel::MoveTable, 18>
+    RubiksCubeIndexModel::moveTables = RubiksCubeIndexModel::buildMoveTables();
+
+  /**
+   * Build the move tables by applying each face twist to a solved cube: after
+   * the twist, the cubie at each position gives the source position and the
+   * orientation delta.
+   */
+  array<RubiksCubeIndexModel::MoveTable, 18>
+    RubiksCubeIndexModel::buildMoveTables()
+  {
+    static_assert(sizeof(Cubie) == 2, "Cubies must be packed in two bytes.");
+
+    array<MoveTable, 18> tables;
+
+    for (unsigned m = 0; m < 18; ++m)
+    {
+      RubiksCubeIndexModel cube;
+      MoveTable&           table = tables[m];
+
+      cube.move((RubiksCube::MOVE)m);
+
+      for (unsigned i = 0; i < 12; ++i)
+      {
+        table.edgePerm[i] = cube.edges[i].index;
+        table.edgeFlip[i] = cube.edges[i].orientation;
+      }
+
+      for (unsigned i = 0; i < 8; ++i)
+      {
+        table.cornerPerm[i]  = cube.corners[i].index;
+        table.cornerTwist[i] = cube.corners[i].orientation;
+      }
+
+      // Byte k of the packed output comes from byte src of the input.
+      table.edgeShuffleHiFromLo.fill(0x80);
+      table.edgeShuffleHiFromHi.fill(0x80);
+      table.edgeDeltaHi.fill(0);
+
+      for (unsigned k = 0; k < 24; ++k)
+      {
+        uint8_t src   = table.edgePerm[k / 2] * 2 + (k & 1);
+        uint8_t delta = (k & 1) ? table.edgeFlip[k / 2] : 0;
+
+        if (k < 16)
+        {
+          table.edgeShuffleLoFromLo[k] = src < 16 ? src : 0x80;
+          table.edgeShuffleLoFromHi[k] = src < 16 ? 0x80 : src - 16;
+          table.edgeDeltaLo[k]         = delta;
+        }
+        else
+        {
+          table.edgeShuffleHiFromLo[k - 16] = src < 16 ? src : 0x80;
+          table.edgeShuffleHiFromHi[k - 16] = src < 16 ? 0x80 : src - 16;
+          table.edgeDeltaHi[k - 16]         = delta;
+        }
+      }
+
+      for (unsigned k = 0; k < 16; ++k)
+      {
+        table.cornerShuffle[k] = table.cornerPerm[k / 2] * 2 + (k & 1);
+        table.cornerDelta[k]   = (k & 1) ? table.cornerTwist[k / 2] : 0;
+      }
+    }
+
+    return tables;
+  }
+
+  /**
+   * Get the table for a face twist.
+   * @param move A face twist (L through B2).
+   */
+  const RubiksCubeIndexModel::MoveTable& RubiksCubeIndexModel::getMoveTable(
+    RubiksCube::MOVE move)
+  {
+    return moveTables[(unsigned)move];
+  }
+
+  /**
+   * Apply a face twist (L through B2) using the move tables.  This is the
+   * same as move, but it's not virtual and has no branches, so it's the one
+   * to use in search loops.  Rotations and slice moves are not supported.
+   */
+  void RubiksCubeIndexModel::applyMove(RubiksCube::MOVE move)
+  {
+    const MoveTable& table = moveTables[(unsigned)move];
+
+#ifdef __SSSE3__
+    uint8_t* pEdges   = reinterpret_cast<uint8_t*>(this->edges.data());
+    uint8_t* pCorners = reinterpret_cast<uint8_t*>(this->corners.data());
+
+    // Corners: one shuffle, then add the twists.  Orientations end up in
+    // 0-4, and 3 is subtracted from those over 2 (only in orientation
+    // bytes).
+    __m128i corners  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCorners));
+    __m128i oriMask  = _mm_set1_epi16(0x0300);
+
+    corners = _mm_shuffle_epi8(corners,
+      _mm_load_si128(reinterpret_cast<const __m128i*>(table.cornerShuffle.data())));
+    corners = _mm_add_epi8(corners,
+      _mm_load_si128(reinterpret_cast<const __m128i*>(table.cornerDelta.data())));
+    corners = _mm_sub_epi8(corners, _mm_and_si128(oriMask,
+      _mm_cmpgt_epi8(corners, _mm_set1_epi8(2))));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pCorners), corners);
+
+    // Edges: the low and high halves are each combined from two shuffles,
+    // then the flips are xor'd in.
+    __m128i edgesLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pEdges));
+    __m128i edgesHi = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pEdges + 16));
+
+    __m128i newLo = _mm_or_si128(
+      _mm_shuffle_epi8(edgesLo, _mm_load_si128(
+        reinterpret_cast<const __m128i*>(table.edgeShuffleLoFromLo.data()))),
+      _mm_shuffle_epi8(edgesHi, _mm_load_si128(
+        reinterpret_cast<const __m128i*>(table.edgeShuffleLoFromHi.data()))));
+    __m128i newHi = _mm_or_si128(
+      _mm_shuffle_epi8(edgesLo, _mm_load_si128(
+        reinterpret_cast<const __m128i*>(table.edgeShuffleHiFromLo.data()))),
+      _mm_shuffle_epi8(edgesHi, _mm_load_si128(
+        reinterpret_cast<const __m128i*>(table.edgeShuffleHiFromHi.data()))));
+
+    newLo = _mm_xor_si128(newLo,
+      _mm_load_si128(reinterpret_cast<const __m128i*>(table.edgeDeltaLo.data())));
+    newHi = _mm_xor_si128(newHi,
+      _mm_load_si128(reinterpret_cast<const __m128i*>(table.edgeDeltaHi.data())));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pEdges), newLo);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(pEdges + 16), newHi);
+#else
+    array<Cubie, 12> oldEdges   = this->edges;
+    array<Cubie, 8>  oldCorners = this->corners;
+
+    for (unsigned i = 0; i < 12; ++i)
+    {
+      const Cubie& edge = oldEdges[table.edgePerm[i]];
+
+      this->edges[i].index       = edge.index;
+      this->edges[i].orientation = edge.orientation ^ table.edgeFlip[i];
+    }
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+      const Cubie& corner = oldCorners[table.cornerPerm[i]];
+      uint8_t      ori    = corner.orientation + table.cornerTwist[i];
+
+      this->corners[i].index       = corner.index;
+      this->corners[i].orientation = ori >= 3 ? ori - 3 : ori;
+    }
+#endif
+  }
+
   /**
    * Up.
    */
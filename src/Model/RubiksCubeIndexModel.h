@@ -46,18 +46,52 @@ namespace busybin
       uint8_t orientation;
     };
 
+    /**
+     * The effect of one face twist.  After the twist, position i holds the
+     * cubie that was at position perm[i], and the cubie's orientation is
+     * increased by the delta (mod 2 for edges and mod 3 for corners).  The
+     * shuffle and delta arrays hold the same twist as byte shuffles over the
+     * packed edges and corners (two bytes per cubie: index, orientation).
+     */
+    struct MoveTable
+    {
+      array<uint8_t, 12> edgePerm;
+      array<uint8_t, 12> edgeFlip;
+      array<uint8_t, 8>  cornerPerm;
+      array<uint8_t, 8>  cornerTwist;
+
+      // The edges take 24 bytes, so they're shuffled as a low (16 bytes) and
+      // a high (8 bytes) half.  Each output half is shuffled from both input
+      // halves (0x80 selects a zero).
+      alignas(16) array<uint8_t, 16> edgeShuffleLoFromLo;
+      alignas(16) array<uint8_t, 16> edgeShuffleLoFromHi;
+      alignas(16) array<uint8_t, 16> edgeShuffleHiFromLo;
+      alignas(16) array<uint8_t, 16> edgeShuffleHiFromHi;
+      alignas(16) array<uint8_t, 16> edgeDeltaLo;
+      alignas(16) array<uint8_t, 16> edgeDeltaHi;
+      alignas(16) array<uint8_t, 16> cornerShuffle;
+      alignas(16) array<uint8_t, 16> cornerDelta;
+    };
+
   private:
     array<Cubie, 12> edges;
     array<Cubie, 8>  corners;
     array<COLOR, 6>  centers;
 
+    static const array<MoveTable, 18> moveTables;
+
     inline void updateCornerOrientation(RubiksCube::CORNER ind, uint8_t amount);
     inline void updateEdgeOrientationZ(EDGE ind);
+    static array<MoveTable, 18> buildMoveTables();
 
   public:
     RubiksCubeIndexModel();
     RubiksCubeIndexModel(const RubiksCubeModel& cube);
 
+    // Table-driven face twists.
+    void applyMove(RubiksCube::MOVE move);
+    static const MoveTable& getMoveTable(RubiksCube::MOVE move);
+
     array<COLOR, 2> getEdgeColors(EDGE ind) const;
     array<COLOR, 3> getCornerColors(CORNER ind) const;
     COLOR getColor(FACE face, unsigned row, unsigned col) const;
@@ -67,8 +101,31 @@ namespace busybin
     uint8_t getEdgeOrientation(EDGE ind) const;
     uint8_t getCornerIndex(CORNER ind) const;
     uint8_t getCornerOrientation(CORNER ind) const;
+    void setEdge(EDGE ind, uint8_t index, uint8_t orientation);
+    void setCorner(CORNER ind, uint8_t index, uint8_t orientation);
+
+    /**
+     * Get the packed edge cubies (index, orientation), e.g. for gathering
+     * the cubies of many cubes at once.
+     */
+    inline const array<Cubie, 12>& getEdges() const
+    {
+      return this->edges;
+    }
+
+    /**
+     * Get the packed corner cubies (see getEdges).
+     */
+    inline const array<Cubie, 8>& getCorners() const
+    {
+      return this->corners;
+    }
+
+    uint8_t getEdgeParity() const;
+    uint8_t getCornerParity() const;
 
     bool isSolved() const;
+    uint64_t getHash() const;
 
     // Face moves.
     RubiksCube& u();
@@ -56,6 +56,24 @@ namespace busybin
       reinterpret_cast<const void*>(&cube.centers[0]), 6);
   }
 
+  /**
+   * Copy the stickers of any cube model (e.g. a RubiksCubeIndexModel).
+   */
+  RubiksCubeModel::RubiksCubeModel(const RubiksCube& cube)
+  {
+    // See getColor for the sticker order of a face.
+    unsigned rows[] = {0, 0, 0, 1, 2, 2, 2, 1};
+    unsigned cols[] = {0, 1, 2, 2, 2, 1, 0, 0};
+
+    for (unsigned f = 0; f < 6; ++f)
+    {
+      for (unsigned i = 0; i < 8; ++i)
+        this->cube[f * 8 + i] = cube.getColor((FACE)f, rows[i], cols[i]);
+
+      this->centers[f] = cube.getColor((FACE)f, 1, 1);
+    }
+  }
+
   /**
    * Same as above, but using the equals operator.
    */
@@ -100,6 +100,7 @@ namespace busybin
 
     RubiksCubeModel();
     RubiksCubeModel(const RubiksCubeModel& cube);
+    explicit RubiksCubeModel(const RubiksCube& cube);
 
     COLOR getColor(FACE face, unsigned row, unsigned col) const;
     COLOR getColor(unsigned ind) const;
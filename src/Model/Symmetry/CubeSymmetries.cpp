@@ -0,0 +1,314 @@
+#include "CubeSymmetries.h"
+
+namespace busybin
+{
+  namespace
+  {
+    // Position vectors (x: L to R, y: D to U, z: B to F) in model order.
+    const int edgeVectors[12][3] =
+    {
+      { 0,  1, -1}, { 1,  1,  0}, { 0,  1,  1}, {-1,  1,  0},
+      { 1,  0,  1}, {-1,  0,  1}, {-1,  0, -1}, { 1,  0, -1},
+      { 0, -1,  1}, {-1, -1,  0}, { 0, -1, -1}, { 1, -1,  0}
+    };
+
+    const int cornerVectors[8][3] =
+    {
+      {-1,  1, -1}, { 1,  1, -1}, { 1,  1,  1}, {-1,  1,  1},
+      {-1, -1,  1}, {-1, -1, -1}, { 1, -1, -1}, { 1, -1,  1}
+    };
+
+    // Face normals in MOVE order: L, R, U, D, F, B.
+    const int faceVectors[6][3] =
+    {
+      {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+    };
+
+    /**
+     * Find v in vectors.
+     */
+    unsigned findVector(const int (*vectors)[3], unsigned numVectors, const int* v)
+    {
+      for (unsigned i = 0; i < numVectors; ++i)
+      {
+        if (vectors[i][0] == v[0] && vectors[i][1] == v[1] && vectors[i][2] == v[2])
+          return i;
+      }
+
+      throw RubiksCubeException("CubeSymmetries: position not found.");
+    }
+  }
+
+  /**
+   * Build the 48 symmetries.  Each is a signed permutation matrix.
+   */
+  CubeSymmetries::CubeSymmetries()
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    const unsigned axisPerms[6][3] =
+      {{0, 1, 2}, {2, 1, 0}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}};
+
+    unsigned numSyms = 0;
+
+    // The first two axis permutations keep y (U-D) in place, so their 16
+    // symmetries come first.  Sign pattern 0 of the identity permutation is
+    // the identity.
+    for (unsigned p = 0; p < 6; ++p)
+    {
+      for (unsigned signs = 0; signs < 8; ++signs)
+      {
+        Symmetry& sym = this->symmetries[numSyms++];
+        int       matrix[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+
+        for (unsigned r = 0; r < 3; ++r)
+          matrix[r][axisPerms[p][r]] = ((signs >> r) & 1) ? -1 : 1;
+
+        int det =
+          matrix[0][0] * (matrix[1][1] * matrix[2][2] - matrix[1][2] * matrix[2][1]) -
+          matrix[0][1] * (matrix[1][0] * matrix[2][2] - matrix[1][2] * matrix[2][0]) +
+          matrix[0][2] * (matrix[1][0] * matrix[2][1] - matrix[1][1] * matrix[2][0]);
+
+        auto transform = [&matrix](const int* v, int* out)
+        {
+          for (unsigned r = 0; r < 3; ++r)
+            out[r] = matrix[r][0] * v[0] + matrix[r][1] * v[1] + matrix[r][2] * v[2];
+        };
+
+        int v[3];
+
+        for (unsigned i = 0; i < 12; ++i)
+        {
+          transform(edgeVectors[i], v);
+          sym.edgePos[i] = findVector(edgeVectors, 12, v);
+        }
+
+        for (unsigned i = 0; i < 8; ++i)
+        {
+          transform(cornerVectors[i], v);
+          sym.cornerPos[i] = findVector(cornerVectors, 8, v);
+        }
+
+        // A face twist maps to a twist of the transformed face.  Mirrors
+        // swap clockwise and counterclockwise.
+        for (unsigned f = 0; f < 6; ++f)
+        {
+          transform(faceVectors[f], v);
+
+          unsigned newFace = findVector(faceVectors, 6, v);
+
+          for (unsigned k = 0; k < 3; ++k)
+          {
+            unsigned newK = (k == 2 || det > 0) ? k : 1 - k;
+
+            sym.moves[f * 3 + k] = (MOVE)(newFace * 3 + newK);
+          }
+        }
+
+        if (!CubeSymmetries::solveEdgeOffsets(sym) ||
+          !CubeSymmetries::solveCornerOffsets(sym))
+        {
+          throw RubiksCubeException("CubeSymmetries: symmetry has no orientation offsets.");
+        }
+      }
+    }
+  }
+
+  /**
+   * Get the symmetries, building them on the first call (thread safe).
+   */
+  const CubeSymmetries& CubeSymmetries::getInstance()
+  {
+    static const CubeSymmetries symmetries;
+
+    return symmetries;
+  }
+
+  /**
+   * Find the edge offsets.  For every move m and position i, conjugating
+   * must satisfy
+   *
+   *   flip_m(i) + offset(i) - offset(perm_m(i)) = flip_sym(m)(sym(i))
+   *
+   * The moves connect every position, so fixing offset(0) = 0 and walking
+   * the constraints assigns all of the offsets; then every constraint is
+   * checked.  Returns false if there's no solution.
+   */
+  bool CubeSymmetries::solveEdgeOffsets(Symmetry& sym)
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    array<bool, 12> assigned;
+
+    assigned.fill(false);
+    sym.edgeOffset.fill(0);
+    assigned[0] = true;
+
+    for (bool changed = true; changed; )
+    {
+      changed = false;
+
+      for (unsigned m = 0; m < 18; ++m)
+      {
+        const RubiksCubeIndexModel::MoveTable& table = RubiksCubeIndexModel::getMoveTable((MOVE)m);
+        const RubiksCubeIndexModel::MoveTable& symTable = RubiksCubeIndexModel::getMoveTable(sym.moves[m]);
+
+        for (unsigned i = 0; i < 12; ++i)
+        {
+          unsigned src = table.edgePerm[i];
+
+          if (assigned[i] && !assigned[src])
+          {
+            sym.edgeOffset[src] = table.edgeFlip[i] ^ sym.edgeOffset[i] ^
+              symTable.edgeFlip[sym.edgePos[i]];
+            assigned[src] = changed = true;
+          }
+        }
+      }
+    }
+
+    for (unsigned m = 0; m < 18; ++m)
+    {
+      const RubiksCubeIndexModel::MoveTable& table = RubiksCubeIndexModel::getMoveTable((MOVE)m);
+      const RubiksCubeIndexModel::MoveTable& symTable = RubiksCubeIndexModel::getMoveTable(sym.moves[m]);
+
+      for (unsigned i = 0; i < 12; ++i)
+      {
+        unsigned src = table.edgePerm[i];
+
+        if (!assigned[i] || symTable.edgePerm[sym.edgePos[i]] != sym.edgePos[src] ||
+          (table.edgeFlip[i] ^ sym.edgeOffset[i] ^ sym.edgeOffset[src]) !=
+          symTable.edgeFlip[sym.edgePos[i]])
+        {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Find the corner offsets and sign (see solveEdgeOffsets):
+   *
+   *   sign * twist_m(i) + offset(i) - offset(perm_m(i)) = twist_sym(m)(sym(i))
+   *
+   * Both signs are tried.
+   */
+  bool CubeSymmetries::solveCornerOffsets(Symmetry& sym)
+  {
+    typedef RubiksCube::MOVE MOVE;
+
+    for (uint8_t sign = 1; sign <= 2; ++sign)
+    {
+      array<bool, 8> assigned;
+      bool           solved = true;
+
+      assigned.fill(false);
+      sym.cornerOffset.fill(0);
+      sym.cornerSign = sign;
+      assigned[0]    = true;
+
+      for (bool changed = true; changed; )
+      {
+        changed = false;
+
+        for (unsigned m = 0; m < 18; ++m)
+        {
+          const RubiksCubeIndexModel::MoveTable& table = RubiksCubeIndexModel::getMoveTable((MOVE)m);
+          const RubiksCubeIndexModel::MoveTable& symTable = RubiksCubeIndexModel::getMoveTable(sym.moves[m]);
+
+          for (unsigned i = 0; i < 8; ++i)
+          {
+            unsigned src = table.cornerPerm[i];
+
+            if (assigned[i] && !assigned[src])
+            {
+              sym.cornerOffset[src] = (sign * table.cornerTwist[i] + sym.cornerOffset[i] +
+                6 - symTable.cornerTwist[sym.cornerPos[i]]) % 3;
+              assigned[src] = changed = true;
+            }
+          }
+        }
+      }
+
+      for (unsigned m = 0; m < 18 && solved; ++m)
+      {
+        const RubiksCubeIndexModel::MoveTable& table = RubiksCubeIndexModel::getMoveTable((MOVE)m);
+        const RubiksCubeIndexModel::MoveTable& symTable = RubiksCubeIndexModel::getMoveTable(sym.moves[m]);
+
+        for (unsigned i = 0; i < 8 && solved; ++i)
+        {
+          unsigned src = table.cornerPerm[i];
+
+          if (!assigned[i] || symTable.cornerPerm[sym.cornerPos[i]] != sym.cornerPos[src] ||
+            (sign * table.cornerTwist[i] + sym.cornerOffset[i] + 3 - sym.cornerOffset[src]) % 3 !=
+            symTable.cornerTwist[sym.cornerPos[i]])
+          {
+            solved = false;
+          }
+        }
+      }
+
+      if (solved)
+        return true;
+    }
+
+    return false;
+  }
+
+  /**
+   * Get a symmetry.
+   */
+  const CubeSymmetries::Symmetry& CubeSymmetries::getSymmetry(unsigned sym) const
+  {
+    return this->symmetries[sym];
+  }
+
+  /**
+   * Conjugate the corners by a symmetry.
+   * @param sym The symmetry number.
+   * @param perm The cubie at each position.
+   * @param ori The orientation at each position.
+   * @param newPerm The conjugated permutation.
+   * @param newOri The conjugated orientations.
+   */
+  void CubeSymmetries::conjugateCorners(unsigned sym,
+    const array<uint8_t, 8>& perm, const array<uint8_t, 8>& ori,
+    array<uint8_t, 8>& newPerm, array<uint8_t, 8>& newOri) const
+  {
+    const Symmetry& s = this->symmetries[sym];
+
+    for (unsigned i = 0; i < 8; ++i)
+    {
+      uint8_t pos = s.cornerPos[i];
+
+      newPerm[pos] = s.cornerPos[perm[i]];
+      newOri[pos]  = (s.cornerSign * ori[i] + s.cornerOffset[i] + 3 -
+        s.cornerOffset[perm[i]]) % 3;
+    }
+  }
+
+  /**
+   * Conjugate the edges by a symmetry.
+   * @param sym The symmetry number.
+   * @param perm The cubie at each position.
+   * @param ori The orientation at each position.
+   * @param newPerm The conjugated permutation.
+   * @param newOri The conjugated orientations.
+   */
+  void CubeSymmetries::conjugateEdges(unsigned sym,
+    const array<uint8_t, 12>& perm, const array<uint8_t, 12>& ori,
+    array<uint8_t, 12>& newPerm, array<uint8_t, 12>& newOri) const
+  {
+    const Symmetry& s = this->symmetries[sym];
+
+    for (unsigned i = 0; i < 12; ++i)
+    {
+      uint8_t pos = s.edgePos[i];
+
+      newPerm[pos] = s.edgePos[perm[i]];
+      newOri[pos]  = ori[i] ^ s.edgeOffset[i] ^ s.edgeOffset[perm[i]];
+    }
+  }
+}
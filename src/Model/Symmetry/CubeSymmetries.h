@@ -0,0 +1,76 @@
+#ifndef _BUSYBIN_CUBE_SYMMETRIES_H_
+#define _BUSYBIN_CUBE_SYMMETRIES_H_
+
+#include "../RubiksCube.h"
+#include "../RubiksCubeIndexModel.h"
+#include "../../Util/RubiksCubeException.h"
+#include <cstdint>
+#include <array>
+using std::array;
+
+namespace busybin
+{
+  /**
+   * The 48 symmetries of the cube (24 rotations, each with and without a
+   * mirror), as they act on a RubiksCubeIndexModel's cubies.
+   *
+   * Conjugating a scramble by a symmetry gives a scramble that is the same
+   * number of moves from solved, so a pattern database only needs to store
+   * one scramble out of each set of symmetric scrambles.
+   *
+   * A symmetry moves the cubie at position p to position sym(p), and
+   * renames the cubie the same way.  Orientations are relative to a
+   * reference facet at each position, and a symmetry can move a reference
+   * facet onto a different facet, so a per-position offset is added as
+   * well: o' = sign * o + offset(p) - offset(cubie).  Mirrors reverse the
+   * direction of corner twists, which makes sign -1 for corners.  The offsets
+   * are derived on construction from the move tables, such that conjugating
+   * a move's effect gives the effect of the mirrored or rotated move, which
+   * makes each symmetry a homomorphism of the cube group.
+   *
+   * The first 16 symmetries keep the U-D axis in place (and the first one is
+   * the identity), so a database that tracks only some cubies can use the
+   * first 16 as long as that set of cubies is preserved.
+   */
+  class CubeSymmetries
+  {
+  public:
+    enum { NUM_SYMMETRIES = 48 };
+    enum { NUM_UD_SYMMETRIES = 16 };
+
+    struct Symmetry
+    {
+      array<uint8_t, 12> edgePos;
+      array<uint8_t, 12> edgeOffset;
+      array<uint8_t, 8>  cornerPos;
+      array<uint8_t, 8>  cornerOffset;
+      // 1, or 2 (-1 mod 3) for mirrors.
+      uint8_t            cornerSign;
+      array<RubiksCube::MOVE, 18> moves;
+    };
+
+  private:
+    array<Symmetry, NUM_SYMMETRIES> symmetries;
+
+    CubeSymmetries();
+    CubeSymmetries(const CubeSymmetries&);
+    CubeSymmetries& operator=(const CubeSymmetries&);
+
+    static bool solveEdgeOffsets(Symmetry& sym);
+    static bool solveCornerOffsets(Symmetry& sym);
+
+  public:
+    static const CubeSymmetries& getInstance();
+
+    const Symmetry& getSymmetry(unsigned sym) const;
+
+    void conjugateCorners(unsigned sym,
+      const array<uint8_t, 8>& perm, const array<uint8_t, 8>& ori,
+      array<uint8_t, 8>& newPerm, array<uint8_t, 8>& newOri) const;
+    void conjugateEdges(unsigned sym,
+      const array<uint8_t, 12>& perm, const array<uint8_t, 12>& ori,
+      array<uint8_t, 12>& newPerm, array<uint8_t, 12>& newOri) const;
+  };
+}
+
+#endif
@@ -0,0 +1,281 @@
+#include "HugePageBuffer.h"
+
+#include <fstream>
+using std::ifstream;
+#include <sstream>
+using std::istringstream;
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define BUSYBIN_HAVE_MMAP
+#endif
+
+namespace busybin
+{
+  /**
+   * Init an empty buffer.
+   */
+  HugePageBuffer::HugePageBuffer() :
+    pData(nullptr),
+    size(0),
+    mappedSize(0),
+    backing(BACKING::NONE)
+  {
+  }
+
+  /**
+   * Allocate a buffer (see allocate).
+   */
+  HugePageBuffer::HugePageBuffer(size_t size, bool hugePages) :
+    HugePageBuffer()
+  {
+    this->allocate(size, hugePages);
+  }
+
+  /**
+   * Take rhs's memory, leaving it empty.
+   */
+  HugePageBuffer::HugePageBuffer(HugePageBuffer&& rhs) :
+    HugePageBuffer()
+  {
+    *this = std::move(rhs);
+  }
+
+  /**
+   * Free this buffer and take rhs's memory, leaving it empty.
+   */
+  HugePageBuffer& HugePageBuffer::operator=(HugePageBuffer&& rhs)
+  {
+    if (this != &rhs)
+    {
+      this->free();
+
+      this->pData      = rhs.pData;
+      this->size       = rhs.size;
+      this->mappedSize = rhs.mappedSize;
+      this->backing    = rhs.backing;
+
+      rhs.pData      = nullptr;
+      rhs.size       = 0;
+      rhs.mappedSize = 0;
+      rhs.backing    = BACKING::NONE;
+    }
+
+    return *this;
+  }
+
+  /**
+   * Free the memory.
+   */
+  HugePageBuffer::~HugePageBuffer()
+  {
+    this->free();
+  }
+
+  /**
+   * Allocate the buffer, freeing any previous memory.  The contents are
+   * uninitialized.
+   * @param size The size in bytes.
+   * @param hugePages Try to back the buffer with huge pages (explicit, then
+   * transparent).  Without huge pages, or if neither is available, the
+   * buffer is on the heap.  See getBacking for what was obtained.
+   */
+  void HugePageBuffer::allocate(size_t size, bool hugePages)
+  {
+    this->free();
+
+    if (size == 0)
+      return;
+
+    if (hugePages && (this->mapHugeTLB(size) || this->mapTransparent(size)))
+      return;
+
+    this->pData   = new uint8_t[size];
+    this->size    = size;
+    this->backing = BACKING::HEAP;
+  }
+
+  /**
+   * Map the buffer on explicit huge pages.  Returns false if there aren't
+   * enough reserved.
+   */
+  bool HugePageBuffer::mapHugeTLB(size_t size)
+  {
+#if defined(BUSYBIN_HAVE_MMAP) && defined(MAP_HUGETLB)
+    size_t mapSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void*  pMap    = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (pMap == MAP_FAILED)
+      return false;
+
+    this->pData      = static_cast<uint8_t*>(pMap);
+    this->size       = size;
+    this->mappedSize = mapSize;
+    this->backing    = BACKING::HUGETLB;
+
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Map the buffer and ask for transparent huge pages.  The mapping is
+   * aligned to a huge page so that all of it can be covered.  Returns false
+   * if the kernel doesn't take the advice (e.g. THP is off).
+   */
+  bool HugePageBuffer::mapTransparent(size_t size)
+  {
+#if defined(BUSYBIN_HAVE_MMAP) && defined(MADV_HUGEPAGE)
+    size_t mapSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+    // Over-allocate by a huge page, then trim the ends to align it.
+    void* pMap = mmap(nullptr, mapSize + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (pMap == MAP_FAILED)
+      return false;
+
+    uint8_t* pStart   = static_cast<uint8_t*>(pMap);
+    uint8_t* pAligned = reinterpret_cast<uint8_t*>(
+      (reinterpret_cast<uintptr_t>(pStart) + HUGE_PAGE_SIZE - 1) &
+      ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+    size_t   head     = pAligned - pStart;
+
+    if (head != 0)
+      munmap(pStart, head);
+
+    if (head != HUGE_PAGE_SIZE)
+      munmap(pAligned + mapSize, HUGE_PAGE_SIZE - head);
+
+    if (madvise(pAligned, mapSize, MADV_HUGEPAGE) != 0)
+    {
+      munmap(pAligned, mapSize);
+      return false;
+    }
+
+    this->pData      = pAligned;
+    this->size       = size;
+    this->mappedSize = mapSize;
+    this->backing    = BACKING::TRANSPARENT_HUGE_PAGES;
+
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Free the memory, leaving the buffer empty.
+   */
+  void HugePageBuffer::free()
+  {
+    if (this->backing == BACKING::HEAP)
+      delete [] this->pData;
+#ifdef BUSYBIN_HAVE_MMAP
+    else if (this->pData)
+      munmap(this->pData, this->mappedSize);
+#endif
+
+    this->pData      = nullptr;
+    this->size       = 0;
+    this->mappedSize = 0;
+    this->backing    = BACKING::NONE;
+  }
+
+  /**
+   * Check if the buffer is empty (unallocated).
+   */
+  bool HugePageBuffer::empty() const
+  {
+    return this->size == 0;
+  }
+
+  /**
+   * Get the size of the buffer in bytes.
+   */
+  size_t HugePageBuffer::getSize() const
+  {
+    return this->size;
+  }
+
+  /**
+   * Get the kind of memory backing the buffer.
+   */
+  HugePageBuffer::BACKING HugePageBuffer::getBacking() const
+  {
+    return this->backing;
+  }
+
+  /**
+   * Get a description of the memory backing the buffer, for reports.
+   */
+  string HugePageBuffer::getBackingName() const
+  {
+    switch (this->backing)
+    {
+      case BACKING::HEAP:
+        return "heap (4KB pages)";
+      case BACKING::TRANSPARENT_HUGE_PAGES:
+        return "transparent huge pages";
+      case BACKING::HUGETLB:
+        return "explicit huge pages";
+      default:
+        return "none";
+    }
+  }
+
+  /**
+   * Get the number of bytes of the buffer that are actually on huge pages.
+   * Transparent huge pages are best-effort, so this reads the kernel's
+   * count from /proc/self/smaps (0 where that's unavailable).  Touch the
+   * buffer first: pages aren't allocated until they're used.
+   */
+  size_t HugePageBuffer::getHugePageBytes() const
+  {
+    if (this->backing == BACKING::HUGETLB)
+      return this->size;
+
+    if (this->backing != BACKING::TRANSPARENT_HUGE_PAGES)
+      return 0;
+
+    ifstream  smaps("/proc/self/smaps");
+    string    line;
+    uintptr_t begin   = reinterpret_cast<uintptr_t>(this->pData);
+    uintptr_t end     = begin + this->mappedSize;
+    bool      inRange = false;
+    size_t    numKB   = 0;
+
+    while (getline(smaps, line))
+    {
+      istringstream fields(line);
+      string        first;
+
+      fields >> first;
+
+      if (first == "AnonHugePages:")
+      {
+        size_t kb = 0;
+
+        if (inRange && fields >> kb)
+          numKB += kb;
+      }
+      else if (first.find('-') != string::npos && first.back() != ':')
+      {
+        // A mapping's header: "start-end perms ...", in hex.
+        uintptr_t vmaBegin = std::stoull(first.substr(0, first.find('-')),
+          nullptr, 16);
+        uintptr_t vmaEnd   = std::stoull(first.substr(first.find('-') + 1),
+          nullptr, 16);
+
+        inRange = vmaBegin < end && vmaEnd > begin;
+      }
+    }
+
+    // The mapping may be merged with neighbors, and it's rounded up to a
+    // whole huge page.
+    return numKB * 1024 < this->size ? numKB * 1024 : this->size;
+  }
+}
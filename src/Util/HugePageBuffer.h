@@ -0,0 +1,83 @@
+#ifndef _BUSYBIN_HUGE_PAGE_BUFFER_H_
+#define _BUSYBIN_HUGE_PAGE_BUFFER_H_
+
+#include <cstddef>
+using std::size_t;
+#include <cstdint>
+#include <string>
+using std::string;
+
+namespace busybin
+{
+  /**
+   * A fixed-size byte buffer that can be backed by huge pages.  The inflated
+   * pattern databases are hundreds of MB and looked up at random, so with
+   * 4KB pages nearly every lookup misses the TLB as well as the cache.  Huge
+   * pages are tried in order of preference, and the buffer falls back to
+   * the heap if neither is available:
+   *
+   * 1) Explicit huge pages (MAP_HUGETLB), which need pages reserved in
+   *    /proc/sys/vm/nr_hugepages.
+   * 2) Transparent huge pages (MADV_HUGEPAGE), which the kernel gives on a
+   *    best-effort basis when THP is set to "madvise" or "always".
+   *
+   * The buffer owns its memory and can be moved but not copied.
+   */
+  class HugePageBuffer
+  {
+  public:
+    enum class BACKING {NONE, HEAP, TRANSPARENT_HUGE_PAGES, HUGETLB};
+
+    // The huge page size the buffer is aligned to.
+    static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  private:
+    uint8_t* pData;
+    size_t   size;
+    size_t   mappedSize;
+    BACKING  backing;
+
+    HugePageBuffer(const HugePageBuffer&);
+    HugePageBuffer& operator=(const HugePageBuffer&);
+
+    bool mapHugeTLB(size_t size);
+    bool mapTransparent(size_t size);
+
+  public:
+    HugePageBuffer();
+    HugePageBuffer(size_t size, bool hugePages = false);
+    HugePageBuffer(HugePageBuffer&& rhs);
+    HugePageBuffer& operator=(HugePageBuffer&& rhs);
+    ~HugePageBuffer();
+
+    void allocate(size_t size, bool hugePages = false);
+    void free();
+    bool empty() const;
+    size_t getSize() const;
+    BACKING getBacking() const;
+    string getBackingName() const;
+    size_t getHugePageBytes() const;
+
+    inline uint8_t* data()
+    {
+      return this->pData;
+    }
+
+    inline const uint8_t* data() const
+    {
+      return this->pData;
+    }
+
+    inline uint8_t& operator[](size_t pos)
+    {
+      return this->pData[pos];
+    }
+
+    inline uint8_t operator[](size_t pos) const
+    {
+      return this->pData[pos];
+    }
+  };
+}
+
+#endif
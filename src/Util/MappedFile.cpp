@@ -0,0 +1,124 @@
+#include "MappedFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define BUSYBIN_HAVE_MMAP
+#endif
+
+namespace busybin
+{
+  /**
+   * Init.  Nothing is mapped until open is called.
+   */
+  MappedFile::MappedFile() : pData(nullptr), size(0)
+  {
+  }
+
+  /**
+   * Unmap the file.
+   */
+  MappedFile::~MappedFile()
+  {
+    this->close();
+  }
+
+  /**
+   * Map a file.  Returns false if the file can't be opened or mapped (or if
+   * memory mapping isn't supported on this platform).
+   * @param filePath The path to the file.
+   * @param hugePages Ask the kernel to back the mapping with huge pages, which
+   * cuts down on TLB misses for random lookups.  This is only a hint: it
+   * needs transparent huge pages for file mappings, and is ignored otherwise.
+   */
+  bool MappedFile::open(const string& filePath, bool hugePages)
+  {
+    this->close();
+
+#ifdef BUSYBIN_HAVE_MMAP
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+
+    if (fd == -1)
+      return false;
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) == -1 || fileStat.st_size == 0)
+    {
+      ::close(fd);
+      return false;
+    }
+
+    int flags = MAP_SHARED;
+
+#ifdef MAP_POPULATE
+    // Fault the whole file in up front rather than on the first lookups.
+    flags |= MAP_POPULATE;
+#endif
+
+    void* pMap = mmap(nullptr, fileStat.st_size, PROT_READ, flags, fd, 0);
+
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+
+    if (pMap == MAP_FAILED)
+      return false;
+
+    // Lookups are random, so read-ahead only wastes I/O.
+    madvise(pMap, fileStat.st_size, MADV_RANDOM);
+    madvise(pMap, fileStat.st_size, MADV_WILLNEED);
+
+#ifdef MADV_HUGEPAGE
+    if (hugePages)
+      madvise(pMap, fileStat.st_size, MADV_HUGEPAGE);
+#endif
+
+    this->pData = static_cast<const uint8_t*>(pMap);
+    this->size  = fileStat.st_size;
+
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Unmap the file, if it's mapped.
+   */
+  void MappedFile::close()
+  {
+#ifdef BUSYBIN_HAVE_MMAP
+    if (this->pData)
+      munmap(const_cast<uint8_t*>(this->pData), this->size);
+#endif
+
+    this->pData = nullptr;
+    this->size  = 0;
+  }
+
+  /**
+   * Check if a file is mapped.
+   */
+  bool MappedFile::isOpen() const
+  {
+    return this->pData != nullptr;
+  }
+
+  /**
+   * Get a pointer to the mapped data.
+   */
+  const uint8_t* MappedFile::data() const
+  {
+    return this->pData;
+  }
+
+  /**
+   * Get the size of the mapped file in bytes.
+   */
+  size_t MappedFile::getSize() const
+  {
+    return this->size;
+  }
+}
@@ -0,0 +1,36 @@
+#ifndef _BUSYBIN_MAPPED_FILE_H_
+#define _BUSYBIN_MAPPED_FILE_H_
+
+#include <cstddef>
+using std::size_t;
+#include <cstdint>
+#include <string>
+using std::string;
+
+namespace busybin
+{
+  /**
+   * A read-only memory mapping of a whole file.  The mapping is shared, so
+   * every process that maps the same file reads the same physical pages from
+   * the page cache.
+   */
+  class MappedFile
+  {
+    const uint8_t* pData;
+    size_t         size;
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+  public:
+    MappedFile();
+    ~MappedFile();
+    bool open(const string& filePath, bool hugePages = false);
+    void close();
+    bool isOpen() const;
+    const uint8_t* data() const;
+    size_t getSize() const;
+  };
+}
+
+#endif
@@ -1,36 +1,77 @@
 #include "NibbleArray.h"
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace busybin
 {
   /**
    * Initialize the underlying vector.
+   * @param size The number of elements.
+   * @param val The initial value of each byte (two elements).
+   * @param allocateNow Whether to allocate the storage now.  If not, it's
+   * allocated on the first write (see the class comment).
    */
-  NibbleArray::NibbleArray(const size_t size, const uint8_t val) :
-    size(size), arr(size / 2 + 1, val)
+  NibbleArray::NibbleArray(const size_t size, const uint8_t val,
+    const bool allocateNow) :
+    size(size), numBytes(size / 2 + 1), fillVal(val), pData(nullptr)
   {
+    if (allocateNow)
+      this->allocate();
   }
 
   /**
-   * Access the element at index pos.
-   * @param pos The 0-based index of the element.
+   * Copy the array.  A mapped array shares the mapping.
    */
-  uint8_t NibbleArray::get(const size_t pos) const
+  NibbleArray::NibbleArray(const NibbleArray& rhs) :
+    size(rhs.size), numBytes(rhs.numBytes), fillVal(rhs.fillVal),
+    arr(rhs.arr), pMapped(rhs.pMapped),
+    pData(rhs.pMapped ? rhs.pData : rhs.pData ? arr.data() : nullptr)
   {
-    size_t i = pos / 2;
-    uint8_t val = this->arr.at(i);
+  }
 
-    if (pos % 2)
-    {
-      // Odd: last 4 bits.
-      return val & 0x0F;
-    }
-    else
+  /**
+   * Assign the array.  A mapped array shares the mapping.
+   */
+  NibbleArray& NibbleArray::operator=(const NibbleArray& rhs)
+  {
+    this->size     = rhs.size;
+    this->numBytes = rhs.numBytes;
+    this->fillVal  = rhs.fillVal;
+    this->arr      = rhs.arr;
+    this->pMapped  = rhs.pMapped;
+    this->pData    = rhs.pMapped ? rhs.pData :
+      rhs.pData ? this->arr.data() : nullptr;
+
+    return *this;
+  }
+
+  /**
+   * Allocate the underlying vector if the array has no storage, filling it
+   * with the initial value.
+   */
+  void NibbleArray::allocate()
+  {
+    if (!this->pData)
     {
-      // Even: first 4 bits.
-      return val >> 4;
+      this->arr.assign(this->numBytes, this->fillVal);
+      this->pData = this->arr.data();
     }
   }
 
+  /**
+   * Access the element at index pos.  There's no bounds checking, and no
+   * branching: even positions are in the high 4 bits, so the byte is shifted
+   * by 4 for even positions and by 0 for odd ones.  The array must have
+   * storage.
+   * @param pos The 0-based index of the element.
+   */
+  uint8_t NibbleArray::get(const size_t pos) const
+  {
+    return (this->pData[pos >> 1] >> ((~pos & 1) << 2)) & 0x0F;
+  }
+
   /**
    * Set the element at index pos.
    * @param pos The 0-based index of the element.
@@ -39,6 +80,11 @@ namespace busybin
    */
   void NibbleArray::set(const size_t pos, const uint8_t val)
   {
+    if (this->pMapped)
+      throw RubiksCubeException("NibbleArray::set on a mapped (read-only) array.");
+
+    this->allocate();
+
     size_t i = pos / 2;
     uint8_t curVal = this->arr.at(i);
 
@@ -55,19 +101,62 @@ namespace busybin
   }
 
   /**
-   * Get a pointer to the underlying array.
+   * Atomically set the element at index pos to val if it's currently equal
+   * to expected.  Two elements share each byte, so this is safe to call from
+   * several threads at once where set is not.  Returns true if the element
+   * was set.  The update is relaxed: it isn't ordered with other memory
+   * accesses, so threads must be synchronized before reading each other's
+   * updates.
+   * @param pos The 0-based index of the element.
+   * @param expected The value that the element must have.
+   * @param val The new value, at most 15.
+   */
+  bool NibbleArray::compareAndSet(const size_t pos, const uint8_t expected,
+    const uint8_t val)
+  {
+    if (this->pMapped)
+      throw RubiksCubeException("NibbleArray::compareAndSet on a mapped (read-only) array.");
+
+    this->allocate();
+
+    uint8_t* pByte = &this->arr[pos >> 1];
+    unsigned shift = (~pos & 1) << 2;
+    uint8_t  cur   = __atomic_load_n(pByte, __ATOMIC_RELAXED);
+    uint8_t  next;
+
+    do
+    {
+      if (((cur >> shift) & 0x0F) != expected)
+        return false;
+
+      next = (cur & ~(0x0F << shift)) | ((val & 0x0F) << shift);
+    }
+    while (!__atomic_compare_exchange_n(pByte, &cur, next, true,
+      __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    return true;
+  }
+
+  /**
+   * Get a pointer to the underlying array, allocating it if need be.
    */
   uint8_t* NibbleArray::data()
   {
+    if (this->pMapped)
+      throw RubiksCubeException("NibbleArray::data on a mapped (read-only) array.");
+
+    this->allocate();
+
     return this->arr.data();
   }
 
   /**
-   * Get a pointer to the underlying array.
+   * Get a pointer to the underlying array, which is null if the array has no
+   * storage (see isAllocated).
    */
   const uint8_t* NibbleArray::data() const
   {
-    return this->arr.data();
+    return this->pData;
   }
 
   /**
@@ -75,27 +164,166 @@ namespace busybin
    */
   size_t NibbleArray::storageSize() const
   {
-    return this->arr.size();
+    return this->numBytes;
   }
 
   /**
    * Move all of the moves into a vector.  This doubles the size, but is
-   * faster to access since no bit-wise operations are needed.
+   * faster to access since no bit-wise operations are needed.  With a
+   * ThreadPool the array is unpacked in parallel chunks.
+   * @param dest The vector to fill.  It's resized to hold every element.
+   * @param pThreadPool An optional ThreadPool for unpacking in parallel.
    */
-  void NibbleArray::inflate(vector<uint8_t>& dest) const
+  void NibbleArray::inflate(vector<uint8_t>& dest, ThreadPool* pThreadPool) const
   {
-    dest.reserve(this->size);
+    dest.resize(this->size);
 
-    for (unsigned i = 0; i < this->size; ++i)
-      dest.push_back(this->get(i));
+    this->inflate(dest.data(), pThreadPool);
   }
 
   /**
-   * Reset the array, filling the underlying buffer with val.
+   * Inflate the array into a buffer (see above).
+   * @param out The buffer to fill, which must hold every element.
+   * @param pThreadPool An optional ThreadPool for unpacking in parallel.
+   */
+  void NibbleArray::inflate(uint8_t* out, ThreadPool* pThreadPool) const
+  {
+    // Bytes that hold two elements.  If size is odd, the last element is
+    // alone in the high bits of the next byte.
+    const size_t   numFull = this->size / 2;
+    const uint8_t* src     = this->pData;
+
+    if (!src)
+    {
+      // Nothing has been written.
+      for (size_t i = 0; i < this->size; ++i)
+        out[i] = (this->fillVal >> ((~i & 1) << 2)) & 0x0F;
+
+      return;
+    }
+
+    if (pThreadPool && numFull != 0)
+    {
+      // 4MB chunks: large enough that the job overhead is negligible.
+      pThreadPool->parallelFor(0, numFull, [src, out](size_t begin, size_t end)
+      {
+        NibbleArray::unpack(src + begin, out + begin * 2, end - begin);
+      }, 1 << 22);
+    }
+    else
+      NibbleArray::unpack(src, out, numFull);
+
+    if (this->size % 2)
+      out[this->size - 1] = src[numFull] >> 4;
+  }
+
+  /**
+   * Unpack numBytes bytes of nibbles into 2*numBytes bytes, high nibble
+   * first.
+   */
+  void NibbleArray::unpack(const uint8_t* src, uint8_t* dest, size_t numBytes)
+  {
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i lowMask = _mm256_set1_epi8(0x0F);
+
+    for (; i + 32 <= numBytes; i += 32)
+    {
+      __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+      __m256i high   = _mm256_and_si256(_mm256_srli_epi16(packed, 4), lowMask);
+      __m256i low    = _mm256_and_si256(packed, lowMask);
+
+      // The unpacks interleave within each 128-bit lane, so the lanes are
+      // put back in order afterward.
+      __m256i first  = _mm256_unpacklo_epi8(high, low);
+      __m256i second = _mm256_unpackhi_epi8(high, low);
+
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 2),
+        _mm256_permute2x128_si256(first, second, 0x20));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i * 2 + 32),
+        _mm256_permute2x128_si256(first, second, 0x31));
+    }
+#elif defined(__SSE2__)
+    const __m128i lowMask = _mm_set1_epi8(0x0F);
+
+    for (; i + 16 <= numBytes; i += 16)
+    {
+      __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+      __m128i high   = _mm_and_si128(_mm_srli_epi16(packed, 4), lowMask);
+      __m128i low    = _mm_and_si128(packed, lowMask);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 2),
+        _mm_unpacklo_epi8(high, low));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 2 + 16),
+        _mm_unpackhi_epi8(high, low));
+    }
+#endif
+
+    for (; i < numBytes; ++i)
+    {
+      dest[i * 2]     = src[i] >> 4;
+      dest[i * 2 + 1] = src[i] & 0x0F;
+    }
+  }
+
+  /**
+   * Reset the array, filling the underlying buffer with val.  A mapped array
+   * is unmapped and moved back to the heap.  An array without storage is
+   * left without it, and val becomes its initial value.
    */
   void NibbleArray::reset(const uint8_t val)
   {
-    fill(this->arr.begin(), this->arr.end(), val);
+    this->fillVal = val;
+
+    if (this->pMapped)
+    {
+      this->pMapped.reset();
+      this->arr.assign(this->numBytes, val);
+      this->pData = this->arr.data();
+    }
+    else
+      fill(this->arr.begin(), this->arr.end(), val);
   }
-}
 
+  /**
+   * Back the array with a memory-mapped file instead of the heap.  The file
+   * must hold exactly storageSize() bytes (as written from data()).  The heap
+   * buffer is freed, and the array is read-only until reset.  Returns false
+   * if the file can't be mapped, in which case the array is unchanged.
+   * @param filePath The path to the file.
+   * @param hugePages Hint that the mapping should use huge pages.
+   */
+  bool NibbleArray::map(const string& filePath, bool hugePages)
+  {
+    shared_ptr<MappedFile> pMapped(new MappedFile());
+
+    if (!pMapped->open(filePath, hugePages))
+      return false;
+
+    if (pMapped->getSize() != this->numBytes)
+      throw RubiksCubeException("Database file appears to be corrupt.  Wrong size.");
+
+    this->pMapped = pMapped;
+    this->pData   = pMapped->data();
+    vector<uint8_t>().swap(this->arr);
+
+    return true;
+  }
+
+  /**
+   * Check if the array is backed by a mapped file.
+   */
+  bool NibbleArray::isMapped() const
+  {
+    return (bool)this->pMapped;
+  }
+
+  /**
+   * Check if the array has storage, either on the heap or mapped.
+   */
+  bool NibbleArray::isAllocated() const
+  {
+    return this->pData != nullptr;
+  }
+}
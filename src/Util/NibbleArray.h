@@ -1,6 +1,9 @@
 #ifndef _BUSYBIN_NIBBLE_ARRAY_
 #define _BUSYBIN_NIBBLE_ARRAY_
 
+#include "MappedFile.h"
+#include "RubiksCubeException.h"
+#include "ThreadPool.h"
 #include <cstddef>
 using std::size_t;
 #include <vector>
@@ -8,30 +11,75 @@ using std::vector;
 #include <cstdint>
 #include <algorithm>
 using std::fill;
+#include <memory>
+using std::shared_ptr;
+#include <string>
+using std::string;
 
 namespace busybin
 {
   /**
    * This class is an array, but stores each element in 4 bits (a nibble).
+   * The elements are either stored on the heap or read directly from a
+   * memory-mapped file, in which case the array is read-only.
+   *
+   * An array can also be created without storage, for data that will be
+   * mapped or built elsewhere (e.g. a pattern database indexed on disk), so
+   * that it never takes the memory.  The heap buffer is then allocated, and
+   * filled with the initial value, on the first write.  Reads don't check
+   * for storage, so an array without any must not be read until it's been
+   * written, read from a file (through data()), or mapped.
    */
   class NibbleArray
   {
-    size_t size;
+    size_t  size;
+    size_t  numBytes;
+    uint8_t fillVal;
 
     // This is where the data are stored.  It's a vector rather than an array
     // because the OS imposes stack size limitations, and very large arrays are
     // needed to hold the pattern databases.
     vector<uint8_t> arr;
 
+    // Set when the array is backed by a file.  It's shared by copies of the
+    // array, and unmapped when the last one is destroyed.
+    shared_ptr<MappedFile> pMapped;
+
+    // Points at either arr or the mapped file, or null while the array has
+    // no storage.
+    const uint8_t* pData;
+
+    static void unpack(const uint8_t* src, uint8_t* dest, size_t numBytes);
+
   public:
-    NibbleArray(const size_t size, const uint8_t val = 0xFF);
+    NibbleArray(const size_t size, const uint8_t val = 0xFF,
+      const bool allocateNow = true);
+    NibbleArray(const NibbleArray& rhs);
+    NibbleArray& operator=(const NibbleArray& rhs);
+    void allocate();
     uint8_t get(const size_t pos) const;
+
+    /**
+     * Hint that the element at index pos will be read soon.  The array must
+     * have storage.
+     */
+    inline void prefetch(const size_t pos) const
+    {
+      __builtin_prefetch(this->pData + (pos >> 1));
+    }
+
     void set(const size_t pos, const uint8_t val);
+    bool compareAndSet(const size_t pos, const uint8_t expected,
+      const uint8_t val);
     unsigned char* data();
     const unsigned char* data() const;
     size_t storageSize() const;
-    void inflate(vector<uint8_t>& dest) const;
+    void inflate(vector<uint8_t>& dest, ThreadPool* pThreadPool = nullptr) const;
+    void inflate(uint8_t* dest, ThreadPool* pThreadPool = nullptr) const;
     void reset(const uint8_t val = 0xFF);
+    bool map(const string& filePath, bool hugePages = false);
+    bool isMapped() const;
+    bool isAllocated() const;
   };
 }
 
@@ -1,5 +1,6 @@
 #include <string>
 #include <vector>
+#include <cstdio>
 
 using namespace std;
 
@@ -20,4 +21,25 @@ namespace StringUtils {
 
         return subStrings;
     }
-}
\ No newline at end of file
+
+    // Escape a string for use in a JSON string literal.
+    string JsonEscape(const string& input) {
+        string escaped;
+
+        for (char c : input) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            }
+            else if ((unsigned char)c < 0x20) {
+                char hex[7];
+                snprintf(hex, sizeof(hex), "\\u%04x", (unsigned)c);
+                escaped += hex;
+            }
+            else
+                escaped += c;
+        }
+
+        return escaped;
+    }
+}
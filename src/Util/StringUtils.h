@@ -7,4 +7,5 @@ using namespace std;
 
 namespace StringUtils {
     vector<string> Split(string& input, const string& delimiter);
+    string JsonEscape(const string& input);
 }
\ No newline at end of file
@@ -2,19 +2,35 @@
 
 namespace busybin
 {
+  namespace
+  {
+    // The pool and deque index of the current thread, if it's a worker.
+    thread_local const ThreadPool* pWorkerPool = nullptr;
+    thread_local int               workerIndex = -1;
+  }
+
   /**
    * Initialize and start all threads.
    */
   ThreadPool::ThreadPool(unsigned numThreads)
   {
-    this->halt = false;
+    this->halt        = false;
+    this->numPending  = 0;
+    this->numSleeping = 0;
+
+    if (numThreads == 0)
+      numThreads = 1;
+
+    // All the deques have to exist before any worker starts stealing.
+    for (unsigned i = 0; i < numThreads; ++i)
+      this->deques.push_back(unique_ptr<WorkStealingDeque<Job*> >(new WorkStealingDeque<Job*>()));
 
     for (unsigned i = 0; i < numThreads; ++i)
-      this->threads.push_back(thread(&ThreadPool::waitForWork, ref(*this)));
+      this->threads.push_back(thread(&ThreadPool::waitForWork, this, i));
   }
 
   /**
-   * Join all the threads.
+   * Join all the threads.  Jobs that are already queued are run first.
    */
   ThreadPool::~ThreadPool()
   {
@@ -30,34 +46,132 @@ namespace busybin
   }
 
   /**
-   * Wait for some work (or halt).
+   * Get the number of worker threads.
+   */
+  unsigned ThreadPool::getNumThreads() const
+  {
+    return this->threads.size();
+  }
+
+  /**
+   * Run jobs, and sleep when there's no work (or halt).
    * @param i The thread number.
    */
-  void ThreadPool::waitForWork()
+  void ThreadPool::waitForWork(unsigned i)
   {
+    pWorkerPool = this;
+    workerIndex = i;
+
     while (1)
     {
-      function<void()> job;
+      if (this->runPendingJob())
+        continue;
+
+      // Briefly spin before sleeping: fine-grained jobs tend to come in
+      // bursts.
+      bool found = false;
+
+      for (unsigned spin = 0; spin < 64 && !found; ++spin)
+      {
+        std::this_thread::yield();
+        found = this->runPendingJob();
+      }
+
+      if (found)
+        continue;
+
       unique_lock<mutex> wLock(this->workMutex);
 
-      // Wake up if halt is flagged or there is work in the queue.
+      // Wake up if halt is flagged or there is work somewhere.  numSleeping
+      // is incremented before checking for work so that push() can't miss
+      // this thread.
+      ++this->numSleeping;
       this->workCond.wait(wLock, [this]
       {
-        return this->halt || this->jobs.size() != 0;
+        return this->halt || this->numPending != 0;
       });
+      --this->numSleeping;
 
       // If halt is flagged and there's no more work, exit.
-      if (this->halt && this->jobs.size() == 0)
+      if (this->halt && this->numPending == 0)
         return;
+    }
+  }
+
+  /**
+   * Get the deque index of the current thread, or -1 if the thread is not one
+   * of this pool's workers.
+   */
+  int ThreadPool::getWorkerIndex() const
+  {
+    return pWorkerPool == this ? workerIndex : -1;
+  }
+
+  /**
+   * Queue a job and wake up a sleeping worker if there is one.
+   */
+  void ThreadPool::push(Job* pJob)
+  {
+    int ind = this->getWorkerIndex();
+
+    if (ind >= 0)
+      this->deques[ind]->push(pJob);
+    else
+    {
+      lock_guard<mutex> iLock(this->injectMutex);
+      this->injected.push(pJob);
+    }
+
+    ++this->numPending;
+
+    if (this->numSleeping != 0)
+    {
+      lock_guard<mutex> wLock(this->workMutex);
+      this->workCond.notify_one();
+    }
+  }
+
+  /**
+   * Find a job: first from the current worker's own deque, then from the
+   * shared queue, then by stealing from another worker.  Returns nullptr if
+   * no job was found.
+   */
+  ThreadPool::Job* ThreadPool::takeJob()
+  {
+    Job*     pJob       = nullptr;
+    int      ind        = this->getWorkerIndex();
+    unsigned numDeques  = this->deques.size();
+
+    if (ind >= 0 && this->deques[ind]->pop(pJob))
+    {
+      --this->numPending;
+      return pJob;
+    }
+
+    {
+      lock_guard<mutex> iLock(this->injectMutex);
+
+      if (!this->injected.empty())
+      {
+        pJob = this->injected.front();
+        this->injected.pop();
+        --this->numPending;
+        return pJob;
+      }
+    }
 
-      // Get the next job and release the lock.
-      job = this->jobs.front();
-      this->jobs.pop();
-      wLock.unlock();
+    for (unsigned i = 1; i <= numDeques; ++i)
+    {
+      unsigned victim = (ind + i) % numDeques;
 
-      // Run the job.
-      job();
+      if (victim != (unsigned)ind && this->deques[victim]->steal(pJob))
+      {
+        --this->numPending;
+        return pJob;
+      }
     }
+
+    return nullptr;
   }
 
   /**
@@ -66,14 +180,105 @@ namespace busybin
    */
   void ThreadPool::addJob(function<void()> job)
   {
-    unique_lock<mutex> wLock(this->workMutex);
+    this->push(new Job({job}));
+  }
+
+  /**
+   * Run one pending job, if there is one.  Returns true if a job was run.
+   */
+  bool ThreadPool::runPendingJob()
+  {
+    Job* pJob = this->takeJob();
 
-    // Add the job.
-    this->jobs.push(job);
-    wLock.unlock();
+    if (!pJob)
+      return false;
 
-    // Wake up a waiting thread.
-    this->workCond.notify_one();
+    unique_ptr<Job> job(pJob);
+    job->run();
+
+    return true;
   }
-}
 
+  /**
+   * Run pending jobs until isDone returns true.  This is how a thread
+   * (worker or not) waits on other jobs without idling.
+   */
+  void ThreadPool::helpUntil(const function<bool()>& isDone)
+  {
+    while (!isDone())
+    {
+      if (!this->runPendingJob())
+        std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Call body on chunks of the range [begin, end) in parallel, and wait for
+   * all of them.  The range is split in halves recursively so that idle
+   * workers steal large pieces first.  If body throws, the first exception is
+   * rethrown here after the other chunks finish.
+   * @param begin The first index.
+   * @param end One past the last index.
+   * @param body Called with [chunkBegin, chunkEnd).
+   * @param grain The largest chunk size.  Defaults to about eight chunks per
+   * thread.
+   */
+  void ThreadPool::parallelFor(size_t begin, size_t end,
+    const function<void(size_t, size_t)>& body, size_t grain)
+  {
+    if (begin >= end)
+      return;
+
+    if (grain == 0)
+      grain = (end - begin) / (this->threads.size() * 8);
+
+    if (grain == 0)
+      grain = 1;
+
+    RangeState state;
+
+    state.pBody          = &body;
+    state.grain          = grain;
+    state.numOutstanding = 1;
+
+    this->splitRange(begin, end, state);
+    this->helpUntil([&state]() { return state.numOutstanding == 0; });
+
+    if (state.error)
+      std::rethrow_exception(state.error);
+  }
+
+  /**
+   * Split off the upper half of the range as a new job until it's at most
+   * grain long, then run body on what's left.
+   */
+  void ThreadPool::splitRange(size_t begin, size_t end, RangeState& state)
+  {
+    while (end - begin > state.grain)
+    {
+      size_t mid = begin + (end - begin) / 2;
+
+      ++state.numOutstanding;
+      this->addJob([this, mid, end, &state]()
+      {
+        this->splitRange(mid, end, state);
+      });
+
+      end = mid;
+    }
+
+    try
+    {
+      (*state.pBody)(begin, end);
+    }
+    catch (...)
+    {
+      lock_guard<mutex> eLock(state.errorMutex);
+
+      if (!state.error)
+        state.error = std::current_exception();
+    }
+
+    --state.numOutstanding;
+  }
+}
@@ -1,11 +1,13 @@
 #ifndef _BUSYBIN_THREAD_POOL_H_
 #define _BUSYBIN_THREAD_POOL_H_
 
+#include "WorkStealingDeque.h"
 #include <thread>
 using std::thread;
 #include <mutex>
 using std::mutex;
 using std::unique_lock;
+using std::lock_guard;
 #include <condition_variable>
 using std::condition_variable;
 #include <vector>
@@ -17,26 +19,144 @@ using std::bind;
 using std::function;
 using std::ref;
 #include <atomic>
+using std::atomic;
 using std::atomic_bool;
+#include <memory>
+using std::unique_ptr;
+using std::shared_ptr;
+#include <future>
+using std::packaged_task;
+using std::shared_future;
+#include <exception>
+using std::exception_ptr;
+#include <type_traits>
+#include <chrono>
+#include <cstddef>
+using std::size_t;
 
 namespace busybin
 {
+  class ThreadPool;
+
+  /**
+   * A handle to a task that was submitted to a ThreadPool.  Joining runs
+   * other pending jobs while waiting, so tasks can be joined from inside the
+   * pool without deadlocking it.
+   */
+  template <class T>
+  class TaskHandle
+  {
+    ThreadPool*      pThreadPool;
+    shared_future<T> future;
+
+  public:
+    TaskHandle(ThreadPool* pThreadPool, shared_future<T> future) :
+      pThreadPool(pThreadPool), future(future)
+    {
+    }
+
+    /**
+     * Check if the task has finished (without waiting).
+     */
+    bool isDone() const
+    {
+      return this->future.wait_for(std::chrono::seconds(0)) ==
+        std::future_status::ready;
+    }
+
+    void join() const;
+
+    /**
+     * Wait for the task and return its result.  If the task threw, the
+     * exception is rethrown here.
+     */
+    T get() const
+    {
+      this->join();
+      return this->future.get();
+    }
+  };
+
+  /**
+   * A work-stealing thread pool.  Each worker has its own deque: jobs added
+   * from a worker go on the bottom of that worker's deque, and idle workers
+   * steal from the top of the others' deques without taking a lock.  Jobs
+   * added from outside the pool go through a shared queue.
+   */
   class ThreadPool
   {
+    struct Job
+    {
+      function<void()> run;
+    };
+
+    // State for one parallelFor call.
+    struct RangeState
+    {
+      const function<void(size_t, size_t)>* pBody;
+      size_t          grain;
+      atomic<size_t>  numOutstanding;
+      exception_ptr   error;
+      mutex           errorMutex;
+    };
+
+    vector<thread>                               threads;
+    vector<unique_ptr<WorkStealingDeque<Job*> > > deques;
+
+    // Jobs added from threads outside of the pool.
+    mutex        injectMutex;
+    queue<Job*>  injected;
+
+    // Idle workers sleep on workCond.
     condition_variable workCond;
     mutex              workMutex;
-    vector<thread>     threads;
+    atomic<size_t>     numPending;
+    atomic<unsigned>   numSleeping;
     atomic_bool        halt;
-    queue<function<void()> > jobs;
 
-    void waitForWork();
+    void waitForWork(unsigned i);
+    int getWorkerIndex() const;
+    void push(Job* pJob);
+    Job* takeJob();
+    void splitRange(size_t begin, size_t end, RangeState& state);
 
   public:
     ThreadPool(unsigned numThreads);
     ~ThreadPool();
+    unsigned getNumThreads() const;
     void addJob(function<void()> job);
+    bool runPendingJob();
+    void helpUntil(const function<bool()>& isDone);
+    void parallelFor(size_t begin, size_t end,
+      const function<void(size_t, size_t)>& body, size_t grain = 0);
+
+    /**
+     * Submit a job and get a handle to its result.
+     * @param job A callable that takes no arguments.
+     */
+    template <class F>
+    TaskHandle<typename std::result_of<F()>::type> submit(F job)
+    {
+      typedef typename std::result_of<F()>::type result_t;
+
+      shared_ptr<packaged_task<result_t()> > pTask(
+        new packaged_task<result_t()>(job));
+      shared_future<result_t> future = pTask->get_future().share();
+
+      this->addJob([pTask]() { (*pTask)(); });
+
+      return TaskHandle<result_t>(this, future);
+    }
   };
+
+  /**
+   * Wait for the task to finish, running other jobs in the meantime.
+   */
+  template <class T>
+  void TaskHandle<T>::join() const
+  {
+    this->pThreadPool->helpUntil([this]() { return this->isDone(); });
+  }
 }
 
 #endif
-
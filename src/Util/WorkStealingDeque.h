@@ -0,0 +1,196 @@
+#ifndef _BUSYBIN_WORK_STEALING_DEQUE_H_
+#define _BUSYBIN_WORK_STEALING_DEQUE_H_
+
+#include <atomic>
+using std::atomic;
+using std::atomic_thread_fence;
+using std::memory_order_relaxed;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_seq_cst;
+#include <vector>
+using std::vector;
+#include <cstdint>
+
+namespace busybin
+{
+  /**
+   * A Chase-Lev work-stealing deque.  One owner thread pushes and pops at the
+   * bottom, and any number of thieves steal from the top without taking a
+   * lock.  The ring buffer grows when full; old buffers are kept until the
+   * deque is destroyed because a thief may still be reading from one.
+   *
+   * This follows "Correct and Efficient Work-Stealing for Weak Memory Models"
+   * (Lê, Pop, Cohen, and Zappa Nardelli, 2013).
+   *
+   * T must be trivially copyable (in practice, a pointer).
+   */
+  template <class T>
+  class WorkStealingDeque
+  {
+    class Buffer
+    {
+      int64_t    capacity;
+      atomic<T>* items;
+
+    public:
+      Buffer(int64_t capacity) : capacity(capacity), items(new atomic<T>[capacity])
+      {
+      }
+
+      ~Buffer()
+      {
+        delete [] this->items;
+      }
+
+      int64_t getCapacity() const
+      {
+        return this->capacity;
+      }
+
+      T get(int64_t i) const
+      {
+        return this->items[i & (this->capacity - 1)].load(memory_order_relaxed);
+      }
+
+      void put(int64_t i, T item)
+      {
+        this->items[i & (this->capacity - 1)].store(item, memory_order_relaxed);
+      }
+
+      /**
+       * Copy the live range [top, bottom) into a buffer twice the size.
+       */
+      Buffer* grow(int64_t top, int64_t bottom) const
+      {
+        Buffer* pBuffer = new Buffer(this->capacity * 2);
+
+        for (int64_t i = top; i < bottom; ++i)
+          pBuffer->put(i, this->get(i));
+
+        return pBuffer;
+      }
+    };
+
+    atomic<int64_t> top;
+    atomic<int64_t> bottom;
+    atomic<Buffer*> buffer;
+
+    // Every buffer ever allocated (owner only).
+    vector<Buffer*> buffers;
+
+    WorkStealingDeque(const WorkStealingDeque&);
+    WorkStealingDeque& operator=(const WorkStealingDeque&);
+
+  public:
+    /**
+     * Initialize the deque.
+     * @param capacity The initial capacity, which must be a power of 2.
+     */
+    WorkStealingDeque(int64_t capacity = 1024) : top(0), bottom(0)
+    {
+      Buffer* pBuffer = new Buffer(capacity);
+
+      this->buffers.push_back(pBuffer);
+      this->buffer.store(pBuffer, memory_order_relaxed);
+    }
+
+    /**
+     * Free all the buffers.
+     */
+    ~WorkStealingDeque()
+    {
+      for (Buffer* pBuffer : this->buffers)
+        delete pBuffer;
+    }
+
+    /**
+     * Push an item on the bottom.  Owner only.
+     */
+    void push(T item)
+    {
+      int64_t b       = this->bottom.load(memory_order_relaxed);
+      int64_t t       = this->top.load(memory_order_acquire);
+      Buffer* pBuffer = this->buffer.load(memory_order_relaxed);
+
+      if (b - t > pBuffer->getCapacity() - 1)
+      {
+        pBuffer = pBuffer->grow(t, b);
+        this->buffers.push_back(pBuffer);
+        this->buffer.store(pBuffer, memory_order_release);
+      }
+
+      pBuffer->put(b, item);
+      atomic_thread_fence(memory_order_release);
+      this->bottom.store(b + 1, memory_order_relaxed);
+    }
+
+    /**
+     * Pop an item from the bottom.  Owner only.  Returns false if the deque
+     * is empty (or a thief won the race for the last item).
+     */
+    bool pop(T& item)
+    {
+      int64_t b       = this->bottom.load(memory_order_relaxed) - 1;
+      Buffer* pBuffer = this->buffer.load(memory_order_relaxed);
+
+      this->bottom.store(b, memory_order_relaxed);
+      atomic_thread_fence(memory_order_seq_cst);
+
+      int64_t t = this->top.load(memory_order_relaxed);
+
+      if (t > b)
+      {
+        // Empty.
+        this->bottom.store(b + 1, memory_order_relaxed);
+        return false;
+      }
+
+      item = pBuffer->get(b);
+
+      if (t == b)
+      {
+        // Last item: race the thieves for it.
+        bool won = this->top.compare_exchange_strong(t, t + 1,
+          memory_order_seq_cst, memory_order_relaxed);
+
+        this->bottom.store(b + 1, memory_order_relaxed);
+        return won;
+      }
+
+      return true;
+    }
+
+    /**
+     * Steal an item from the top.  Any thread.  Returns false if the deque is
+     * empty or another thread took the item first.
+     */
+    bool steal(T& item)
+    {
+      int64_t t = this->top.load(memory_order_acquire);
+      atomic_thread_fence(memory_order_seq_cst);
+      int64_t b = this->bottom.load(memory_order_acquire);
+
+      if (t >= b)
+        return false;
+
+      Buffer* pBuffer = this->buffer.load(memory_order_acquire);
+
+      item = pBuffer->get(t);
+
+      return this->top.compare_exchange_strong(t, t + 1,
+        memory_order_seq_cst, memory_order_relaxed);
+    }
+
+    /**
+     * Check if the deque is (approximately) empty.
+     */
+    bool empty() const
+    {
+      return this->bottom.load(memory_order_relaxed) <=
+        this->top.load(memory_order_relaxed);
+    }
+  };
+}
+
+#endif
@@ -1,81 +1,488 @@
 #include "Controller/Command/Solver/KorfCubeSolver.h"
+#include "Controller/Command/Solver/ThistlethwaiteCubeSolver.h"
+#include "Controller/Command/Solver/TwoPhaseCubeSolver.h"
+#include "Controller/Command/Solver/AnytimeCubeSolver.h"
+#include "Controller/Server/SolverServer.h"
 #include "Util/ThreadPool.h"
+#include "Util/Timer.h"
 #include <memory>
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <sstream>
 #include "Util/StringUtils.h"
 
 using namespace busybin;
 #define MOVE busybin::RubiksCube::MOVE
 
-MOVE parseMove(string moveString);
+bool parseScramble(const string& scramble, RubiksCube& cube);
 void handleCommandLineAruments(int argc, char *argv[], RubiksCube* cube);
+void solveBatch(istream& input, ostream& output, ThreadPool* threadPool);
+void serve(ThreadPool* threadPool);
+void benchmarkSearch(const string& scrambleFile, KorfCubeSolver* korfSolver);
+void solveAll(const RubiksCubeIndexModel& cube, KorfCubeSolver* korfSolver);
+vector<vector<uint8_t>> getEdgePartition(unsigned numEdges);
+vector<vector<uint8_t>> getSymmetricEdgePartition(unsigned numEdges);
 
 CubeSolver* solver;
+unsigned numSearchThreads = 1;
+uint8_t splitDepth = 2;
+bool mapDatabases = false;
+bool hugePages = false;
+unsigned numDatabaseEdges = 7;
+bool adaptiveOrdering = true;
+bool symmetryReduction = false;
+bool benchmark = false;
+bool useThistlethwaite = false;
+bool useTwoPhase = false;
+uint8_t twoPhaseLength = 20;
+double twoPhaseSeconds = 0.1;
+double deadlineSeconds = 0;
+bool inPlaceSearch = false;
+size_t tableMegabytes = 0;
+size_t diskIndexMegabytes = 0;
+bool allSolutions = false;
+unsigned long long maxSolutions = 0;
+string batchFile;
+string benchmarkFile;
+string serverSocket;
+uint16_t serverPort = 0;
 
 void solve(RubiksCube& cube) {
-  
+
   solver->solveCube(cube);
 }
 /**
  * Bootstrap the application.
  */
 int main(int argc, char* argv[]) {
-  ThreadPool* threadPool = new ThreadPool(4);
-  solver = new KorfCubeSolver(nullptr, threadPool);
   RubiksCube* cube = new RubiksCubeIndexModel();
-  
+
   handleCommandLineAruments(argc, argv, cube);
 
-  solver->initialize([cube]() {
-    solve(*cube);
+  // The parallel search runs on the same pool as the database loaders.  In
+  // batch mode the pool solves one cube per thread.
+  ThreadPool* threadPool = new ThreadPool(std::max(4u, numSearchThreads));
+
+  if (!serverSocket.empty() || serverPort != 0) {
+    serve(threadPool);
+    return 0;
+  }
+
+  // A deadline (-D) combines Korf's solver with a quick one (-T or -K,
+  // Thistlethwaite by default).
+  KorfCubeSolver* korfSolver  = nullptr;
+  CubeSolver*     quickSolver = nullptr;
+
+  if (useTwoPhase) {
+    TwoPhaseCubeSolver* twoPhaseSolver = new TwoPhaseCubeSolver(nullptr, threadPool);
+
+    twoPhaseSolver->setBudget(twoPhaseLength, twoPhaseSeconds);
+    quickSolver = twoPhaseSolver;
+  }
+  else if (useThistlethwaite || deadlineSeconds > 0)
+    quickSolver = new ThistlethwaiteCubeSolver(nullptr, threadPool);
+
+  if (!quickSolver || deadlineSeconds > 0) {
+    korfSolver = new KorfCubeSolver(nullptr, threadPool, numSearchThreads, splitDepth);
+    korfSolver->setDatabaseMapping(mapDatabases, hugePages);
+    korfSolver->setSymmetryReduction(symmetryReduction);
+    korfSolver->setEdgePartition(symmetryReduction ?
+      getSymmetricEdgePartition(numDatabaseEdges) :
+      getEdgePartition(numDatabaseEdges));
+    korfSolver->setAdaptiveOrdering(adaptiveOrdering);
+    korfSolver->setInPlaceSearch(inPlaceSearch);
+    korfSolver->setTranspositionTableSize(tableMegabytes);
+    korfSolver->setDiskIndexing(diskIndexMegabytes);
+  }
+
+  if (korfSolver && quickSolver) {
+    AnytimeCubeSolver* anytimeSolver = new AnytimeCubeSolver(nullptr, threadPool, korfSolver, quickSolver);
+
+    anytimeSolver->setDeadline(deadlineSeconds);
+    solver = anytimeSolver;
+  }
+  else if (korfSolver)
+    solver = korfSolver;
+  else
+    solver = quickSolver;
+
+  // In batch mode the results are the only thing written to stdout; the
+  // progress messages go to stderr.
+  std::streambuf* resultBuf = cout.rdbuf();
+
+  if (!batchFile.empty())
+    cout.rdbuf(cerr.rdbuf());
+
+  ostream results(resultBuf);
+
+  // Set when the work is done (the solver calls back from the thread pool).
+  std::promise<void> done;
+
+  solver->initialize([&]() {
+    try {
+      if (benchmark && korfSolver)
+        korfSolver->benchmarkLookups();
+      else if (!benchmarkFile.empty() && korfSolver)
+        benchmarkSearch(benchmarkFile, korfSolver);
+      else if (allSolutions && korfSolver)
+        solveAll(*static_cast<RubiksCubeIndexModel*>(cube), korfSolver);
+      else if (batchFile == "-")
+        solveBatch(std::cin, results, threadPool);
+      else if (!batchFile.empty()) {
+        std::ifstream input(batchFile);
+
+        if (!input.is_open())
+          throw RubiksCubeException("Failed to open batch file " + batchFile + ".");
+
+        solveBatch(input, results, threadPool);
+      }
+      else
+        solve(*cube);
+
+      done.set_value();
+    }
+    catch (...) {
+      done.set_exception(std::current_exception());
+    }
   });
 
-  while(solver->solving) {}
+  done.get_future().get();
 
   return 0;
 }
 
+/**
+ * Solve each scramble (one per line) in input and write one JSON object per
+ * line to output.  The databases are loaded once, and the cubes are solved
+ * concurrently, one per pool thread, so results are written in the order
+ * they finish; each one carries the line's 0-based id.
+ */
+void solveBatch(istream& input, ostream& output, ThreadPool* threadPool) {
+  vector<string> scrambles;
+  string         line;
+  std::mutex     outputMutex;
+  Timer          timer(true);
+
+  while (std::getline(input, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+
+    scrambles.push_back(line);
+  }
+
+  cout << "Batch: solving " << scrambles.size() << " scrambles on "
+       << threadPool->getNumThreads() << " threads." << endl;
+
+  threadPool->parallelFor(0, scrambles.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      RubiksCubeIndexModel cube;
+      std::ostringstream   json;
+
+      json << "{\"id\":" << i << ",\"scramble\":\"" << StringUtils::JsonEscape(scrambles[i]) << '"';
+
+      if (!parseScramble(scrambles[i], cube))
+        json << ",\"error\":\"Invalid move.\"}";
+      else {
+        CubeSolver::Solution solution = solver->findSolution(cube);
+        string               moves;
+
+        for (MOVE move : solution.moves) {
+          if (!moves.empty())
+            moves += ' ';
+
+          moves += cube.getMove(move);
+        }
+
+        json << ",\"solution\":\"" << moves << '"'
+             << ",\"length\":" << solution.moves.size()
+             << ",\"nodes\":" << solution.numNodes
+             << ",\"seconds\":" << solution.elapsedSeconds << '}';
+      }
+
+      std::lock_guard<std::mutex> lock(outputMutex);
+      output << json.str() << endl;
+    }
+  }, 1);
+
+  cout << "Batch: solved " << scrambles.size() << " scrambles in "
+       << timer.getElapsedSeconds() << "s." << endl;
+}
+
+/**
+ * Run the IDA* search benchmark on the scrambles in a file (one per line,
+ * e.g. ../Data/referenceScrambles.txt).
+ */
+void benchmarkSearch(const string& scrambleFile, KorfCubeSolver* korfSolver) {
+  std::ifstream                input(scrambleFile);
+  vector<RubiksCubeIndexModel> cubes;
+  string                       line;
+
+  if (!input.is_open())
+    throw RubiksCubeException("Failed to open scramble file " + scrambleFile + ".");
+
+  while (std::getline(input, line)) {
+    RubiksCubeIndexModel cube;
+
+    if (!parseScramble(line, cube))
+      throw RubiksCubeException("Invalid move in scramble " + line + ".");
+
+    cubes.push_back(cube);
+  }
+
+  korfSolver->benchmarkSearch(cubes);
+}
+
+/**
+ * Print every optimal solution of the cube (or the first maxSolutions), one
+ * per line, followed by the count.
+ */
+void solveAll(const RubiksCubeIndexModel& cube, KorfCubeSolver* korfSolver) {
+  Timer              timer(true);
+  unsigned           length = 0;
+  unsigned long long numSolutions;
+
+  numSolutions = korfSolver->findAllSolutions(cube, maxSolutions,
+    [&](const vector<MOVE>& solution) {
+      string moves;
+
+      for (MOVE move : solution) {
+        if (!moves.empty())
+          moves += ' ';
+
+        moves += cube.getMove(move);
+      }
+
+      length = solution.size();
+      cout << moves << endl;
+
+      return true;
+    });
+
+  cout << "Found " << numSolutions << " optimal solutions of length " << length
+       << " in " << timer.getElapsedSeconds() << "s." << endl;
+}
+
+/**
+ * Load the solvers' databases and serve solve requests until killed.
+ */
+void serve(ThreadPool* threadPool) {
+  KorfCubeSolver*           korfSolver     = new KorfCubeSolver(nullptr, threadPool, 1, splitDepth);
+  ThistlethwaiteCubeSolver* thistleSolver  = new ThistlethwaiteCubeSolver(nullptr, threadPool);
+  TwoPhaseCubeSolver*       twoPhaseSolver = new TwoPhaseCubeSolver(nullptr, threadPool);
+  std::atomic_uint          numLoading(3);
+  std::promise<void>        loaded;
+
+  korfSolver->setDatabaseMapping(mapDatabases, hugePages);
+  korfSolver->setSymmetryReduction(symmetryReduction);
+  korfSolver->setEdgePartition(symmetryReduction ?
+    getSymmetricEdgePartition(numDatabaseEdges) :
+    getEdgePartition(numDatabaseEdges));
+  korfSolver->setAdaptiveOrdering(adaptiveOrdering);
+  korfSolver->setInPlaceSearch(inPlaceSearch);
+  korfSolver->setTranspositionTableSize(tableMegabytes);
+  twoPhaseSolver->setBudget(twoPhaseLength, twoPhaseSeconds);
+
+  auto onLoaded = [&]() {
+    if (--numLoading == 0)
+      loaded.set_value();
+  };
+
+  korfSolver->initialize(onLoaded);
+  thistleSolver->initialize(onLoaded);
+  twoPhaseSolver->initialize(onLoaded);
+  loaded.get_future().get();
+
+  // Leave at least one thread for the (fast) Thistlethwaite and two-phase
+  // solves.
+  unsigned     maxOptimal = std::max(1u, threadPool->getNumThreads() - 1);
+  // Anytime solves start from the quick solver's solution.
+  CubeSolver*       quickSolver = useTwoPhase ? (CubeSolver*)twoPhaseSolver : thistleSolver;
+  AnytimeCubeSolver anytimeSolver(nullptr, threadPool, korfSolver, quickSolver);
+
+  SolverServer server(korfSolver, thistleSolver, twoPhaseSolver, &anytimeSolver,
+    threadPool, maxOptimal);
+
+  if (!serverSocket.empty())
+    server.listenUnix(serverSocket);
+  else
+    server.listenTcp(serverPort);
+
+  server.run();
+}
+
 void handleCommandLineAruments(int argc, char *argv[], RubiksCube* cube) {
 
     //Parse all command line arguments.
     for (int i = 1; i < argc; i++) {
         if (((string) argv[i]).compare("-t") == 0) {
-            string turnString = (string) argv[i + 1];
-            vector<string> turns = StringUtils::Split(turnString, " ");
-            
-            for (int i = 0; i < turns.size(); i++) {
-                MOVE turn = parseMove(turns[i]);
-                cube->move(turn);
-            }
+            if (!parseScramble(argv[i + 1], *cube))
+                throw RubiksCubeException("Invalid move in scramble.");
+        }
+        else if (((string) argv[i]).compare("-j") == 0) {
+            // Number of IDA* search threads (0 for one per core).  In batch
+            // mode, the number of cubes solved at once.
+            numSearchThreads = std::stoul(argv[i + 1]);
+
+            if (numSearchThreads == 0)
+                numSearchThreads = std::thread::hardware_concurrency();
+        }
+        else if (((string) argv[i]).compare("-s") == 0) {
+            // Depth at which the parallel IDA* search tree is split.
+            splitDepth = (uint8_t)std::stoul(argv[i + 1]);
+        }
+        else if (((string) argv[i]).compare("-m") == 0) {
+            // Memory map the pattern databases instead of loading them.
+            mapDatabases = true;
+        }
+        else if (((string) argv[i]).compare("-M") == 0) {
+            // Same as -m, but ask for huge pages.
+            mapDatabases = true;
+            hugePages = true;
+        }
+        else if (((string) argv[i]).compare("-G") == 0) {
+            // Put the inflated pattern databases on huge pages (explicit,
+            // then transparent, then the heap as a fallback).
+            hugePages = true;
+        }
+        else if (((string) argv[i]).compare("-E") == 0) {
+            // Track this many edges (6-9) in each of the two edge pattern
+            // databases.  Each extra edge makes the databases about 10
+            // times larger, and the search that much faster.
+            numDatabaseEdges = std::stoul(argv[i + 1]);
+        }
+        else if (((string) argv[i]).compare("-Y") == 0) {
+            // Use the symmetry-reduced corner and U/D edge pattern
+            // databases.
+            symmetryReduction = true;
+        }
+        else if (((string) argv[i]).compare("-X") == 0) {
+            // Index missing pattern databases on disk, holding at most this
+            // many megabytes of each in memory.  An interrupted build
+            // resumes where it left off.
+            diskIndexMegabytes = std::stoul(argv[i + 1]);
+        }
+        else if (((string) argv[i]).compare("-O") == 0) {
+            // Probe the pattern databases in a fixed order instead of
+            // measuring which order prunes fastest.
+            adaptiveOrdering = false;
+        }
+        else if (((string) argv[i]).compare("-B") == 0) {
+            // Benchmark packed vs. inflated database lookups instead of
+            // solving.
+            benchmark = true;
+        }
+        else if (((string) argv[i]).compare("-N") == 0) {
+            // Benchmark the IDA* search (nodes per second) on the scrambles
+            // in a file instead of solving.
+            benchmarkFile = argv[i + 1];
+        }
+        else if (((string) argv[i]).compare("-b") == 0) {
+            // Solve every scramble in a file (one per line, "-" for stdin)
+            // and write the results to stdout as JSON lines.
+            batchFile = argv[i + 1];
+        }
+        else if (((string) argv[i]).compare("-T") == 0) {
+            // Solve with the Thistlethwaite method instead of Korf's.
+            useThistlethwaite = true;
+        }
+        else if (((string) argv[i]).compare("-D") == 0) {
+            // Solve within a deadline of this many milliseconds: a
+            // Thistlethwaite solution (two-phase with -K) right away,
+            // improved by Korf's search until the deadline.
+            deadlineSeconds = std::stod(argv[i + 1]) / 1000;
+        }
+        else if (((string) argv[i]).compare("-K") == 0) {
+            // Solve with the two-phase (Kociemba) method.
+            useTwoPhase = true;
+        }
+        else if (((string) argv[i]).compare("-L") == 0) {
+            // Two-phase: stop at the first solution of at most this many
+            // moves (0 to use the whole time budget).
+            twoPhaseLength = (uint8_t)std::stoul(argv[i + 1]);
+        }
+        else if (((string) argv[i]).compare("-W") == 0) {
+            // Two-phase: stop improving the solution after this many
+            // milliseconds.
+            twoPhaseSeconds = std::stod(argv[i + 1]) / 1000;
+        }
+        else if (((string) argv[i]).compare("-A") == 0) {
+            // Print every optimal solution instead of the first one, or the
+            // first N (0 for all).
+            allSolutions = true;
+            maxSolutions = std::stoull(argv[i + 1]);
+        }
+        else if (((string) argv[i]).compare("-I") == 0) {
+            // Search in place (make/unmake moves) instead of copying cubes.
+            inPlaceSearch = true;
+        }
+        else if (((string) argv[i]).compare("-H") == 0) {
+            // Prune duplicate states with a transposition table of this many
+            // megabytes.
+            tableMegabytes = std::stoul(argv[i + 1]);
+        }
+        else if (((string) argv[i]).compare("-S") == 0) {
+            // Serve solve requests on a Unix domain socket.
+            serverSocket = argv[i + 1];
+        }
+        else if (((string) argv[i]).compare("-P") == 0) {
+            // Serve solve requests on a localhost TCP port.
+            serverPort = (uint16_t)std::stoul(argv[i + 1]);
         }
     }
 }
 
-MOVE parseMove(string moveString) {
-  #define MOVE_COMPARE(first, second, value) if (moveString.compare(first) == 0 || moveString.compare(second) == 0) return value
-  
-  MOVE_COMPARE("U",  "u",  MOVE::U);
-  MOVE_COMPARE("U'", "u'", MOVE::UPRIME);
-  MOVE_COMPARE("U2", "u2", MOVE::U2);
-
-  MOVE_COMPARE("F",  "f",  MOVE::L);
-  MOVE_COMPARE("F'", "f'", MOVE::LPRIME);
-  MOVE_COMPARE("F2", "f2", MOVE::L2);
-  
-  MOVE_COMPARE("R",  "r",  MOVE::R);
-  MOVE_COMPARE("R'", "r'", MOVE::RPRIME);
-  MOVE_COMPARE("R2", "r2", MOVE::R2);
-  
-  MOVE_COMPARE("B",  "b",  MOVE::B);
-  MOVE_COMPARE("B'", "b'", MOVE::BPRIME);
-  MOVE_COMPARE("B2", "b2", MOVE::B2);
-  
-  MOVE_COMPARE("L",  "l",  MOVE::L);
-  MOVE_COMPARE("L'", "l'", MOVE::LPRIME);
-  MOVE_COMPARE("L2", "l2", MOVE::L2);
-  
-  MOVE_COMPARE("D",  "d",  MOVE::D);
-  MOVE_COMPARE("D'", "d'", MOVE::DPRIME);
-  MOVE_COMPARE("D2", "d2", MOVE::D2);
-
-  return (MOVE)0xFF;
-}
\ No newline at end of file
+/**
+ * Split the edges between two pattern databases of numEdges edges each: the
+ * first numEdges edges and the last numEdges edges (by default, 0-6 and
+ * 5-11).
+ */
+vector<vector<uint8_t>> getEdgePartition(unsigned numEdges) {
+  vector<vector<uint8_t>> edgeSets(2);
+
+  for (uint8_t i = 0; i < numEdges; ++i) {
+    edgeSets[0].push_back(i);
+    edgeSets[1].push_back(12 - numEdges + i);
+  }
+
+  return edgeSets;
+}
+
+/**
+ * Split the edges for the symmetry-reduced databases: the 8 U and D layer
+ * edges in one, and numEdges edges starting with the 4 middle layer edges in
+ * the other (by default, 0-2 and 4-7).
+ */
+vector<vector<uint8_t>> getSymmetricEdgePartition(unsigned numEdges) {
+  vector<vector<uint8_t>> edgeSets(2);
+
+  edgeSets[0] = {0, 1, 2, 3, 8, 9, 10, 11};
+  edgeSets[1] = {4, 5, 6, 7};
+
+  for (uint8_t i = 0; edgeSets[1].size() < numEdges; ++i) {
+    if (i < 4 || i >= 8)
+      edgeSets[1].push_back(i);
+  }
+
+  std::sort(edgeSets[1].begin(), edgeSets[1].end());
+
+  return edgeSets;
+}
+
+/**
+ * Apply a space-separated list of moves to the cube.  Returns false if a
+ * move isn't recognized.
+ */
+bool parseScramble(const string& scramble, RubiksCube& cube) {
+  vector<MOVE> turns;
+
+  if (!RubiksCube::parseMoves(scramble, turns))
+    return false;
+
+  for (MOVE turn : turns)
+    cube.move(turn);
+
+  return true;
+}